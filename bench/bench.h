@@ -0,0 +1,59 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+// clock_gettime is POSIX, this has to be defined before any system header
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <uc/types.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// wall clock time in seconds
+static double bench_now(void) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// xorshift64*, good enough to generate benchmark inputs
+static u64 bench_random(u64 *state) {
+  u64 x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+// command line argument `index` as a number, or `fallback` if it is missing
+static usize bench_arg(int argc, char **argv, int index, usize fallback) {
+  if (argc <= index) {
+    return fallback;
+  }
+  return (usize)strtoull(argv[index], NULL, 10);
+}
+
+// defeats dead code elimination of benchmark results
+static volatile u64 bench_sink;
+
+static void bench_report(const char *name, usize ops, double seconds) {
+  (void)fprintf(stdout, "%-40s %10.2f ns/op %10.2f Mop/s\n", name,
+                seconds * 1e9 / (double)ops, (double)ops / seconds * 1e-6);
+}
+
+static void bench_dummy_callee__(void);
+static void bench_dummy_caller__(void) {
+  bench_now();
+  bench_random(NULL);
+  bench_arg(0, NULL, 0, 0);
+  bench_sink = 0;
+  bench_report(NULL, 0, 0);
+  bench_dummy_callee__();
+}
+static void bench_dummy_callee__(void) { bench_dummy_caller__(); }
+
+#endif // BENCH_H_
@@ -0,0 +1,106 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_aggregate.h>
+
+// usage: table_aggregate.out [num_rows] [num_groups]
+//
+// count and sum of a column grouped by random keys: one `table_upsert` per
+// row followed by updating its value, against `table_aggregate` with the
+// number of groups known and estimated. Run once with many groups, whose
+// table does not fit into the cache, and once with a thousand
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+    .value_size = 2 * sizeof(i64),
+};
+
+static const TableAggregate aggregates[] = {
+    {TABLE_AGGREGATE_COUNT, 0},
+    {TABLE_AGGREGATE_SUM, 0},
+};
+
+static void upsert(const u64 *keys, const i64 *column, usize num_rows) {
+  Table(u64) table;
+  table_init(&table, &vtable, 0, allocator_global, NULL);
+  const double start = bench_now();
+  for (usize i = 0; i < num_rows; ++i) {
+    const usize length = table.length;
+    const usize index =
+        table_upsert(&table, &vtable, &keys[i], allocator_global, NULL);
+    i64 *value = table_value(&table, &vtable, index);
+    if (table.length != length) {
+      value[0] = 0;
+      value[1] = 0;
+    }
+    value[0] += 1;
+    value[1] += column[i];
+  }
+  bench_report("table_upsert per row", num_rows, bench_now() - start);
+  bench_sink = table.length;
+  table_deinit(&table, allocator_global);
+}
+
+static void aggregate(const char *name, const u64 *keys, const i64 *column,
+                      usize num_rows, usize cardinality) {
+  const i64 *columns[] = {column};
+  Table(u64) table;
+  table_init(&table, &vtable, 0, allocator_global, NULL);
+  const double start = bench_now();
+  table_aggregate(&table, &vtable, aggregates, 2, keys, columns, num_rows,
+                  cardinality, allocator_global, NULL);
+  bench_report(name, num_rows, bench_now() - start);
+  bench_sink = table.length;
+  table_deinit(&table, allocator_global);
+}
+
+static void bench(const u64 *keys, const i64 *column, usize num_rows,
+                  usize num_groups) {
+  printf("%zu rows, %zu groups\n", num_rows, num_groups);
+  upsert(keys, column, num_rows);
+  aggregate("table_aggregate known groups", keys, column, num_rows,
+            num_groups);
+  aggregate("table_aggregate estimated", keys, column, num_rows, 0);
+}
+
+int main(int argc, char **argv) {
+  const usize num_rows = bench_arg(argc, argv, 1, 1 << 24);
+  const usize num_groups = bench_arg(argc, argv, 2, 1 << 21);
+
+  u64 *keys = malloc(num_rows * sizeof(u64));
+  i64 *column = malloc(num_rows * sizeof(i64));
+  u64 state = 42;
+  for (usize i = 0; i < num_rows; ++i) {
+    keys[i] = bench_random(&state) % num_groups;
+    column[i] = (i64)(bench_random(&state) % 1000);
+  }
+  bench(keys, column, num_rows, num_groups);
+
+  for (usize i = 0; i < num_rows; ++i) {
+    keys[i] %= 1000;
+  }
+  bench(keys, column, num_rows, 1000);
+
+  free(keys);
+  free(column);
+  return 0;
+}
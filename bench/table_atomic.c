@@ -0,0 +1,139 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_atomic.h>
+#include <uc/table_sharded.h>
+
+// usage: table_atomic.out [max_threads] [ops_per_thread] [num_keys]
+//
+// throughput of read mostly workloads from 1 to `max_threads` threads, for a
+// sharded table and for a table with lock free readers
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+typedef struct Shared Shared;
+struct Shared {
+  Epoch epoch;
+  TableAtomic atomic;
+  TableSharded sharded;
+  bool use_atomic;
+  usize read_permille;
+  usize ops;
+  usize num_keys;
+};
+
+typedef struct Worker Worker;
+struct Worker {
+  Shared *shared;
+  u64 seed;
+  usize found;
+};
+
+static void worker_run(void *worker_) {
+  Worker *worker = worker_;
+  Shared *shared = worker->shared;
+  const usize reader = epoch_register(&shared->epoch, NULL);
+  u64 state = worker->seed;
+  usize found = 0;
+  for (usize i = 0; i < shared->ops; ++i) {
+    const u64 r = bench_random(&state);
+    const u64 key = (r >> 16) % (2 * shared->num_keys);
+    const bool read = (r & 0xffff) % 1000 < shared->read_permille;
+    if (shared->use_atomic) {
+      if (read) {
+        found += table_atomic_contains(&shared->atomic, &vtable, reader, &key);
+      } else {
+        table_atomic_insert(&shared->atomic, &vtable, &key, NULL);
+      }
+    } else {
+      if (read) {
+        found += table_sharded_contains(&shared->sharded, &vtable, &key);
+      } else {
+        table_sharded_insert(&shared->sharded, &vtable, &key,
+                             allocator_global, NULL);
+      }
+    }
+  }
+  epoch_unregister(&shared->epoch, reader);
+  worker->found = found;
+}
+
+static void bench(bool use_atomic, usize threads, usize read_permille,
+                  usize ops, usize num_keys) {
+  Shared shared = {0};
+  shared.use_atomic = use_atomic;
+  shared.read_permille = read_permille;
+  shared.ops = ops;
+  shared.num_keys = num_keys;
+  epoch_init(&shared.epoch, threads, allocator_global, NULL);
+  table_atomic_init(&shared.atomic, &vtable, &shared.epoch, 8,
+                    allocator_global, NULL);
+  table_sharded_init(&shared.sharded, &vtable, 64, 0, allocator_global, NULL);
+  for (u64 i = 0; i < num_keys; ++i) {
+    table_atomic_insert(&shared.atomic, &vtable, &i, NULL);
+    table_sharded_insert(&shared.sharded, &vtable, &i, allocator_global,
+                         NULL);
+  }
+
+  Worker workers[64];
+  Thread handles[64];
+  const double start = bench_now();
+  for (usize t = 0; t < threads; ++t) {
+    workers[t] = (Worker){.shared = &shared, .seed = 42 + t};
+    thread_spawn(&handles[t], worker_run, &workers[t], NULL);
+  }
+  for (usize t = 0; t < threads; ++t) {
+    thread_join(&handles[t]);
+    bench_sink = workers[t].found;
+  }
+
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%s %zu threads %zu.%zu%% reads",
+                 use_atomic ? "atomic " : "sharded", threads,
+                 read_permille / 10, read_permille % 10);
+  bench_report(label, threads * ops, bench_now() - start);
+
+  table_atomic_deinit(&shared.atomic);
+  table_sharded_deinit(&shared.sharded, allocator_global);
+  epoch_deinit(&shared.epoch);
+}
+
+int main(int argc, char **argv) {
+  usize max_threads = bench_arg(argc, argv, 1, 8);
+  const usize ops = bench_arg(argc, argv, 2, 1 << 21);
+  const usize num_keys = bench_arg(argc, argv, 3, 1 << 20);
+  if (max_threads > 64) {
+    max_threads = 64;
+  }
+
+  const usize read_permilles[] = {1000, 990, 900};
+  for (usize r = 0; r < sizeof(read_permilles) / sizeof(*read_permilles);
+       ++r) {
+    for (usize threads = 1; threads <= max_threads; threads *= 2) {
+      bench(false, threads, read_permilles[r], ops, num_keys);
+      bench(true, threads, read_permilles[r], ops, num_keys);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_build.h>
+
+// usage: table_build.out [num_elements] [max_threads]
+//
+// builds a table of distinct u64s by calling `table_insert` for each element
+// and with `table_build_from_array` using 1 to `max_threads` threads
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 23);
+  const usize max_threads = bench_arg(argc, argv, 2, 4);
+
+  u64 *elements = calloc(num_elements, sizeof(*elements));
+  u64 state = 42;
+  for (usize i = 0; i < num_elements; ++i) {
+    elements[i] = bench_random(&state);
+  }
+
+  Table(u64) table;
+  double start = bench_now();
+  table_init(&table, &vtable, 8, allocator_global, NULL);
+  for (usize i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &elements[i], allocator_global, NULL);
+  }
+  bench_report("table_insert", num_elements, bench_now() - start);
+  bench_sink = table.length;
+  table_deinit(&table, allocator_global);
+
+  start = bench_now();
+  table_init(&table, &vtable, num_elements, allocator_global, NULL);
+  for (usize i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &elements[i], allocator_global, NULL);
+  }
+  bench_report("table_init sized + table_insert", num_elements,
+               bench_now() - start);
+  bench_sink = table.length;
+  table_deinit(&table, allocator_global);
+
+  for (usize threads = 1; threads <= max_threads; threads *= 2) {
+    char label[128];
+    start = bench_now();
+    table_build_from_array(&table, &vtable, elements, num_elements, threads,
+                           allocator_global, NULL);
+    (void)snprintf(label, sizeof(label), "table_build_from_array %zu threads",
+                   threads);
+    bench_report(label, num_elements, bench_now() - start);
+    bench_sink = table.length;
+    table_deinit(&table, allocator_global);
+  }
+
+  free(elements);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <uc/table_define.h>
+
+// usage: table_define.out [num_elements]
+//
+// the workload of test/table.c: inserting, finding and upserting ints, once
+// through the vtable and once through a `TABLE_DEFINE` table
+
+static u64 int_hash_(const int *x) {
+  u64 hash = (u64)*x * 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 29);
+}
+
+static bool int_equal(const int *a, const int *b) { return *a == *b; }
+
+TABLE_DEFINE(IntSet, int, int_hash_, int_equal)
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return int_hash_(element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(int),
+    .compare = int_compare,
+    .insert = int_insert,
+    .overwrite = int_insert,
+    .hash = int_hash,
+};
+
+int main(int argc, char **argv) {
+  const int num_elements = (int)bench_arg(argc, argv, 1, 1 << 20);
+  usize found = 0;
+
+  Table(int) table;
+  table_init(&table, &vtable, 8, allocator_global, NULL);
+  double start = bench_now();
+  for (int i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+  bench_report("vtable insert", num_elements, bench_now() - start);
+
+  start = bench_now();
+  for (int i = 0; i < 2 * num_elements; ++i) {
+    found += table_contains(&table, &vtable, &i);
+  }
+  bench_report("vtable contains", 2 * num_elements, bench_now() - start);
+
+  start = bench_now();
+  for (int i = 0; i < num_elements; ++i) {
+    found += table_upsert(&table, &vtable, &i, allocator_global, NULL);
+  }
+  bench_report("vtable upsert", num_elements, bench_now() - start);
+  table_deinit(&table, allocator_global);
+
+  IntSet set;
+  IntSet_init(&set, 8, allocator_global, NULL);
+  start = bench_now();
+  for (int i = 0; i < num_elements; ++i) {
+    IntSet_insert(&set, &i, allocator_global, NULL);
+  }
+  bench_report("TABLE_DEFINE insert", num_elements, bench_now() - start);
+
+  start = bench_now();
+  for (int i = 0; i < 2 * num_elements; ++i) {
+    found += IntSet_contains(&set, &i);
+  }
+  bench_report("TABLE_DEFINE contains", 2 * num_elements, bench_now() - start);
+
+  start = bench_now();
+  for (int i = 0; i < num_elements; ++i) {
+    found += IntSet_upsert(&set, &i, allocator_global, NULL);
+  }
+  bench_report("TABLE_DEFINE upsert", num_elements, bench_now() - start);
+  IntSet_deinit(&set, allocator_global);
+
+  bench_sink = found;
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "bench.h"
+
+#include <string.h>
+
+#include <uc/hash.h>
+#include <uc/table_file.h>
+
+// usage: table_file.out [num_elements] [num_lookups] [path]
+//
+// random lookups in a table file right after opening it with the page cache
+// dropped (cold) and again once the touched pages are resident (warm). The
+// file is synced before the cache is dropped with `posix_fadvise`, which the
+// kernel may ignore, e.g. on tmpfs, so pass a path on a real disk
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+static void lookup(const char *name, const TableFile *file, usize num_elements,
+                   usize num_lookups) {
+  u64 state = 42;
+  usize found = 0;
+  const double start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    const u64 key = bench_random(&state) % num_elements;
+    found += table_contains(&file->table, &vtable, &key);
+  }
+  bench_sink = found;
+  bench_report(name, num_lookups, bench_now() - start);
+}
+
+static void drop_page_cache(const char *path) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  (void)close(fd);
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 22);
+  const usize num_lookups = bench_arg(argc, argv, 2, 1 << 16);
+  const char *path = argc > 3 ? argv[3] : "/tmp/uc_bench_table_file.bin";
+
+  (void)remove(path);
+  Error error = 0;
+  TableFile file;
+  table_file_open(&file, &vtable, path, 8, 0, &error);
+  if (error) {
+    (void)fprintf(stderr, "could not open %s: %s\n", path, strerror(error));
+    return 1;
+  }
+  const double start = bench_now();
+  for (u64 i = 0; i < num_elements; ++i) {
+    table_file_insert(&file, &vtable, &i, &error);
+  }
+  bench_report("insert", num_elements, bench_now() - start);
+  table_file_close(&file, &error);
+
+  drop_page_cache(path);
+  table_file_open(&file, &vtable, path, 8, 0, &error);
+  if (error) {
+    (void)fprintf(stderr, "could not reopen %s: %s\n", path, strerror(error));
+    return 1;
+  }
+  lookup("lookup cold", &file, num_elements, num_lookups);
+  lookup("lookup warm", &file, num_elements, num_lookups);
+  table_file_close(&file, &error);
+  (void)remove(path);
+  return 0;
+}
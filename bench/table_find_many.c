@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <uc/table.h>
+
+// usage: table_find_many.out [num_elements] [num_lookups]
+//
+// the default table is ~300MB which should be well beyond the last level cache
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  u64 x = *(const u64 *)element;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 24);
+  const usize num_lookups = bench_arg(argc, argv, 2, 1 << 24);
+
+  Table(u64) table;
+  table_init(&table, &vtable, num_elements, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+
+  // half of the lookups hit, half of them miss
+  u64 state = 0x1234567;
+  u64 *keys = malloc(num_lookups * sizeof(*keys));
+  usize *indices = calloc(num_lookups, sizeof(*indices));
+  for (usize i = 0; i < num_lookups; ++i) {
+    keys[i] = bench_random(&state) % (2 * num_elements);
+  }
+
+  (void)fprintf(stdout, "table: %zu elements, %zu slots, %zu MB\n",
+                (size_t)num_elements, (size_t)table.end,
+                (size_t)(table.end * (sizeof(u64) + 1) >> 20));
+
+  double start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    indices[i] = table_find(&table, &vtable, &keys[i]);
+  }
+  bench_report("table_find", num_lookups, bench_now() - start);
+  bench_sink = indices[num_lookups / 2];
+
+  start = bench_now();
+  table_find_many(&table, &vtable, keys, num_lookups, indices);
+  bench_report("table_find_many", num_lookups, bench_now() - start);
+  bench_sink = indices[num_lookups / 2];
+
+  bool *contains = calloc(num_lookups, sizeof(*contains));
+  start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    contains[i] = table_contains(&table, &vtable, &keys[i]);
+  }
+  bench_report("table_contains", num_lookups, bench_now() - start);
+  bench_sink = contains[num_lookups / 2];
+
+  start = bench_now();
+  table_contains_many(&table, &vtable, keys, num_lookups, contains);
+  bench_report("table_contains_many", num_lookups, bench_now() - start);
+  bench_sink = contains[num_lookups / 2];
+
+  free(contains);
+  free(indices);
+  free(keys);
+  table_deinit(&table, allocator_global);
+  return 0;
+}
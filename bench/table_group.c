@@ -0,0 +1,77 @@
+#include "bench.h"
+
+#include <uc/table.h>
+
+// usage: table_group_<width>.out [num_slots]
+//
+// probe throughput of a single group width, the Makefile builds this file
+// once for every implementation in table_group.h. The table is filled up to
+// just below its maximum load factor where probe sequences are the longest
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  u64 x = *(const u64 *)element;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+int main(int argc, char **argv) {
+  const usize num_slots = bench_arg(argc, argv, 1, 1 << 16);
+  const usize num_elements = num_slots - num_slots / 8 - 1;
+  const usize num_lookups = 1 << 24;
+
+  Table(u64) table;
+  table_init(&table, &vtable, num_elements, allocator_global, NULL);
+  table_reserve(&table, &vtable, num_elements, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+
+  char label[64];
+  usize found = 0;
+  double start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    const u64 key = i % num_elements;
+    found += table_contains(&table, &vtable, &key);
+  }
+  (void)snprintf(label, sizeof(label), "%s (%d) hit, load %.2f",
+                 TABLE_GROUP_NAME, TABLE_GROUP_WIDTH,
+                 (double)table.length / (double)table.end);
+  bench_report(label, num_lookups, bench_now() - start);
+
+  start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    const u64 key = num_elements + i;
+    found += table_contains(&table, &vtable, &key);
+  }
+  (void)snprintf(label, sizeof(label), "%s (%d) miss, load %.2f",
+                 TABLE_GROUP_NAME, TABLE_GROUP_WIDTH,
+                 (double)table.length / (double)table.end);
+  bench_report(label, num_lookups, bench_now() - start);
+
+  bench_sink = found;
+  table_deinit(&table, allocator_global);
+  return 0;
+}
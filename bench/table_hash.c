@@ -0,0 +1,128 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table.h>
+
+// usage: table_hash.out [num_elements]
+//
+// shows how the quality of the hash and the bits the control byte is taken
+// from affect probe lengths and the number of compares per lookup. For each
+// hash, sequential and random keys are inserted and then looked up, once all
+// present and once all missing
+
+typedef struct Counters Counters;
+struct Counters {
+  usize compares;
+};
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  ((Counters *)ctx)->compares += 1;
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+// multiply and xor loop typical for hand written hashes
+static u64 weak_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  const byte *s = element;
+  u64 hash = 1111111111111111111ull;
+  for (usize i = 0; i < sizeof(u64); ++i) {
+    hash *= 31;
+    hash ^= s[i];
+  }
+  return hash;
+}
+
+static u64 good_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+// a good hash whose control byte is a copy of the low 7 bits which also pick
+// the starting slot, as with a tag taken from the low bits of the hash
+static u64 correlated_hash(const void *element, void *ctx) {
+  const u64 hash = good_hash(element, ctx);
+  return (hash & ~(0x7full << 57)) | ((hash & 0x7f) << 57);
+}
+
+static u64 make_key(u64 i, bool random) {
+  return random ? i * 0x9E3779B97F4A7C15ull + 0x632BE59BD9B4E019ull : i;
+}
+
+static void bench(const char *name, table_element_hash_f hash,
+                  usize num_elements, bool random) {
+  Counters counters = {0};
+  const TableVTable vtable = {
+      .element_size = sizeof(u64),
+      .compare = u64_compare,
+      .insert = u64_insert,
+      .overwrite = u64_insert,
+      .hash = hash,
+      .ctx = &counters,
+  };
+
+  Table(u64) table;
+  table_init(&table, &vtable, num_elements, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    const u64 key = make_key(i, random);
+    table_insert(&table, &vtable, &key, allocator_global, NULL);
+  }
+
+  // number of groups visited before the element was found
+  const usize mask = table.end - 1;
+  usize groups = 0;
+  for (u64 i = 0; i < num_elements; ++i) {
+    const u64 key = make_key(i, random);
+    const usize home = hash(&key, NULL) & mask;
+    groups += ((table_find(&table, &vtable, &key) - home) & mask) /
+                  TABLE_GROUP_WIDTH +
+              1;
+  }
+
+  counters.compares = 0;
+  usize found = 0;
+  double start = bench_now();
+  for (u64 i = 0; i < num_elements; ++i) {
+    const u64 key = make_key(i, random);
+    found += table_contains(&table, &vtable, &key);
+  }
+  const double hit_seconds = bench_now() - start;
+  const usize hit_compares = counters.compares;
+
+  counters.compares = 0;
+  start = bench_now();
+  for (u64 i = num_elements; i < 2 * num_elements; ++i) {
+    const u64 key = make_key(i, random);
+    found += table_contains(&table, &vtable, &key);
+  }
+  const double miss_seconds = bench_now() - start;
+  const usize miss_compares = counters.compares;
+  bench_sink = found;
+
+  (void)fprintf(stdout,
+                "%-28s %-10s groups/hit %6.2f  compares/hit %6.2f  "
+                "compares/miss %6.2f  %7.2f ns/hit %7.2f ns/miss\n",
+                name, random ? "random" : "sequential",
+                (double)groups / (double)num_elements,
+                (double)hit_compares / (double)num_elements,
+                (double)miss_compares / (double)num_elements,
+                hit_seconds * 1e9 / (double)num_elements,
+                miss_seconds * 1e9 / (double)num_elements);
+
+  table_deinit(&table, allocator_global);
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 20);
+
+  for (int random = 0; random < 2; ++random) {
+    bench("weak", weak_hash, num_elements, random);
+    bench("hash_u64 tag from low bits", correlated_hash, num_elements, random);
+    bench("hash_u64", good_hash, num_elements, random);
+  }
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include "bench.h"
+
+#include <uc/table.h>
+
+// usage: table_incremental.out [num_elements]
+//
+// compares the worst case latency of a single `table_insert` between
+// stop-the-world and incremental resizing
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  u64 x = *(const u64 *)element;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+static void bench(usize num_elements, usize migrate_groups) {
+  const TableVTable vtable = {
+      .element_size = sizeof(u64),
+      .compare = u64_compare,
+      .insert = u64_insert,
+      .overwrite = u64_insert,
+      .hash = u64_hash,
+      .migrate_groups = migrate_groups,
+  };
+
+  Table(u64) table;
+  table_init(&table, &vtable, 16, allocator_global, NULL);
+
+  double worst = 0;
+  const double start = bench_now();
+  for (u64 i = 0; i < num_elements; ++i) {
+    const double insert_start = bench_now();
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+    const double latency = bench_now() - insert_start;
+    if (latency > worst) {
+      worst = latency;
+    }
+  }
+  const double total = bench_now() - start;
+
+  (void)fprintf(stdout,
+                "migrate_groups: %2zu  total: %8.3f s  worst insert: %10.3f "
+                "us\n",
+                (size_t)migrate_groups, total, worst * 1e6);
+  table_deinit(&table, allocator_global);
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 24);
+  bench(num_elements, 0);
+  bench(num_elements, 1);
+  bench(num_elements, 4);
+  return 0;
+}
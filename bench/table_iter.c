@@ -0,0 +1,70 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table.h>
+
+// usage: table_iter.out [capacity]
+//
+// full table scans at different fill rates, once by checking `table_isset`
+// for every slot and once with `table_next`
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+static void bench(usize capacity, usize percent) {
+  Table(u64) table;
+  table_init(&table, &vtable, capacity, allocator_global, NULL);
+  const usize num_elements = table.end * percent / 100;
+  for (u64 i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+
+  char label[128];
+  u64 sum = 0;
+  double start = bench_now();
+  for (usize i = 0; i < table.end; ++i) {
+    if (table_isset(&table, &vtable, i)) {
+      sum += table.element[i];
+    }
+  }
+  (void)snprintf(label, sizeof(label), "%2zu%% full isset per slot", percent);
+  bench_report(label, table.end, bench_now() - start);
+
+  start = bench_now();
+  table_foreach(&table, &vtable, iter) { sum += table.element[iter.index]; }
+  (void)snprintf(label, sizeof(label), "%2zu%% full table_next", percent);
+  bench_report(label, table.end, bench_now() - start);
+  bench_sink = sum;
+
+  table_deinit(&table, allocator_global);
+}
+
+int main(int argc, char **argv) {
+  const usize capacity = bench_arg(argc, argv, 1, 1 << 24);
+
+  const usize percents[] = {1, 10, 50, 85};
+  for (usize i = 0; i < sizeof(percents) / sizeof(*percents); ++i) {
+    bench(capacity, percents[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_set.h>
+
+// usage: table_set.out [num_large] [num_small]
+//
+// intersection and difference of two tables against a loop of
+// `table_contains`, once for two tables of `num_large` elements which
+// overlap by half and once skewed with `num_small` against `num_large`
+// elements. Union is measured on the equal sized tables only. Reported per
+// element of the iterated table
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+typedef Table(u64) U64Table;
+typedef Vec(u64) U64Vec;
+
+static void fill(U64Table *table, u64 first, usize count) {
+  table_init(table, &vtable, count, allocator_global, NULL);
+  for (u64 i = first; i < first + count; ++i) {
+    table_insert(table, &vtable, &i, allocator_global, NULL);
+  }
+}
+
+// `table_intersect` or `table_difference` written with `table_contains`
+static void loop(const U64Table *a, const U64Table *b, bool present,
+                 U64Vec *out) {
+  table_foreach(a, &vtable, iter) {
+    const u64 *element = table_get(a, &vtable, iter.index);
+    if (table_contains(b, &vtable, element) == present) {
+      vec_push(out, sizeof(u64), element, allocator_global, NULL);
+    }
+  }
+}
+
+static void bench(const char *name, const U64Table *small,
+                  const U64Table *large) {
+  U64Vec out;
+  vec_init(&out, sizeof(u64), 1024, allocator_global, NULL);
+  char label[128];
+
+  double start = bench_now();
+  loop(small, large, true, &out);
+  (void)snprintf(label, sizeof(label), "%s intersect loop", name);
+  bench_report(label, small->length, bench_now() - start);
+  const usize expected = out.length;
+
+  out.length = 0;
+  start = bench_now();
+  table_intersect(small, large, &vtable, &out, allocator_global, NULL);
+  (void)snprintf(label, sizeof(label), "%s table_intersect", name);
+  bench_report(label, small->length, bench_now() - start);
+  bench_sink = out.length == expected;
+
+  out.length = 0;
+  start = bench_now();
+  loop(small, large, false, &out);
+  (void)snprintf(label, sizeof(label), "%s difference loop", name);
+  bench_report(label, small->length, bench_now() - start);
+
+  out.length = 0;
+  start = bench_now();
+  table_difference(small, large, &vtable, &out, allocator_global, NULL);
+  (void)snprintf(label, sizeof(label), "%s table_difference", name);
+  bench_report(label, small->length, bench_now() - start);
+
+  vec_deinit(&out, sizeof(u64), allocator_global);
+}
+
+static void bench_union(const U64Table *a, const U64Table *b) {
+  U64Table dest;
+  fill(&dest, 0, 0);
+  table_union_into(&dest, a, &vtable, allocator_global, NULL);
+
+  double start = bench_now();
+  table_foreach(b, &vtable, iter) {
+    table_upsert(&dest, &vtable, table_get(b, &vtable, iter.index),
+                 allocator_global, NULL);
+  }
+  bench_report("equal union upsert loop", b->length, bench_now() - start);
+  table_deinit(&dest, allocator_global);
+
+  fill(&dest, 0, 0);
+  table_union_into(&dest, a, &vtable, allocator_global, NULL);
+  start = bench_now();
+  table_union_into(&dest, b, &vtable, allocator_global, NULL);
+  bench_report("equal table_union_into", b->length, bench_now() - start);
+  bench_sink = dest.length;
+  table_deinit(&dest, allocator_global);
+}
+
+int main(int argc, char **argv) {
+  const usize num_large = bench_arg(argc, argv, 1, 1 << 22);
+  const usize num_small = bench_arg(argc, argv, 2, 1 << 14);
+
+  U64Table a;
+  U64Table b;
+  U64Table small;
+  fill(&a, 0, num_large);
+  fill(&b, num_large / 2, num_large);
+  fill(&small, num_large - num_small / 2, num_small);
+
+  bench("equal ", &a, &b);
+  bench("skewed", &small, &a);
+  bench_union(&a, &b);
+
+  table_deinit(&a, allocator_global);
+  table_deinit(&b, allocator_global);
+  table_deinit(&small, allocator_global);
+  return 0;
+}
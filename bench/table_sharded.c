@@ -0,0 +1,135 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_sharded.h>
+
+// usage: table_sharded.out [max_threads] [ops_per_thread] [num_keys]
+//
+// throughput of mixed lookups and inserts from 1 to `max_threads` threads,
+// for a single table behind a global mutex and for a sharded table
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+typedef struct Shared Shared;
+struct Shared {
+  Mutex mutex;
+  Table(u64) table;
+  TableSharded sharded;
+  bool use_sharded;
+  usize read_percent;
+  usize ops;
+  usize num_keys;
+};
+
+typedef struct Worker Worker;
+struct Worker {
+  Shared *shared;
+  u64 seed;
+  usize found;
+};
+
+static void worker_run(void *worker_) {
+  Worker *worker = worker_;
+  Shared *shared = worker->shared;
+  u64 state = worker->seed;
+  usize found = 0;
+  for (usize i = 0; i < shared->ops; ++i) {
+    const u64 r = bench_random(&state);
+    const u64 key = (r >> 8) % (2 * shared->num_keys);
+    const bool read = (r & 0xff) * 100 < shared->read_percent * 256;
+    if (shared->use_sharded) {
+      if (read) {
+        found += table_sharded_contains(&shared->sharded, &vtable, &key);
+      } else {
+        table_sharded_insert(&shared->sharded, &vtable, &key,
+                             allocator_global, NULL);
+      }
+    } else {
+      mutex_lock(&shared->mutex);
+      if (read) {
+        found += table_contains(&shared->table, &vtable, &key);
+      } else {
+        table_insert(&shared->table, &vtable, &key, allocator_global, NULL);
+      }
+      mutex_unlock(&shared->mutex);
+    }
+  }
+  worker->found = found;
+}
+
+static void bench(bool use_sharded, usize threads, usize read_percent,
+                  usize ops, usize num_keys) {
+  Shared shared = {0};
+  shared.use_sharded = use_sharded;
+  shared.read_percent = read_percent;
+  shared.ops = ops;
+  shared.num_keys = num_keys;
+  mutex_init(&shared.mutex);
+  table_init(&shared.table, &vtable, 8, allocator_global, NULL);
+  table_sharded_init(&shared.sharded, &vtable, 64, 0, allocator_global, NULL);
+  for (u64 i = 0; i < num_keys; ++i) {
+    table_insert(&shared.table, &vtable, &i, allocator_global, NULL);
+    table_sharded_insert(&shared.sharded, &vtable, &i, allocator_global,
+                         NULL);
+  }
+
+  Worker workers[64];
+  Thread handles[64];
+  const double start = bench_now();
+  for (usize t = 0; t < threads; ++t) {
+    workers[t] = (Worker){.shared = &shared, .seed = 42 + t};
+    thread_spawn(&handles[t], worker_run, &workers[t], NULL);
+  }
+  for (usize t = 0; t < threads; ++t) {
+    thread_join(&handles[t]);
+    bench_sink = workers[t].found;
+  }
+
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%s %zu threads %zu%% reads",
+                 use_sharded ? "sharded" : "mutex  ", threads, read_percent);
+  bench_report(label, threads * ops, bench_now() - start);
+
+  table_deinit(&shared.table, allocator_global);
+  table_sharded_deinit(&shared.sharded, allocator_global);
+  mutex_deinit(&shared.mutex);
+}
+
+int main(int argc, char **argv) {
+  usize max_threads = bench_arg(argc, argv, 1, 8);
+  const usize ops = bench_arg(argc, argv, 2, 1 << 21);
+  const usize num_keys = bench_arg(argc, argv, 3, 1 << 20);
+  if (max_threads > 64) {
+    max_threads = 64;
+  }
+
+  const usize read_percents[] = {100, 95, 50};
+  for (usize r = 0; r < sizeof(read_percents) / sizeof(*read_percents); ++r) {
+    for (usize threads = 1; threads <= max_threads; threads *= 2) {
+      bench(false, threads, read_percents[r], ops, num_keys);
+      bench(true, threads, read_percents[r], ops, num_keys);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_small.h>
+
+// usage: table_small.out [num_tables] [num_elements]
+//
+// lifetime of a short lived table: init, `num_elements` inserts, four
+// lookups per element and deinit, with heap storage and with `TableSmall`
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+static void bench(bool small, usize num_tables, usize num_elements) {
+  u64 storage[TABLE_SMALL_STORAGE_SIZE(sizeof(u64)) / sizeof(u64)];
+  TableSmall table_small;
+  table_small_init(&table_small, storage, sizeof(storage), allocator_global);
+  Allocator *allocator = small ? (Allocator *)&table_small : allocator_global;
+
+  u64 state = 42;
+  usize found = 0;
+  const double start = bench_now();
+  for (usize t = 0; t < num_tables; ++t) {
+    Table(u64) table;
+    table_init(&table, &vtable, num_elements, allocator, NULL);
+    const u64 base = bench_random(&state);
+    for (u64 i = 0; i < num_elements; ++i) {
+      const u64 key = base + i;
+      table_insert(&table, &vtable, &key, allocator, NULL);
+    }
+    for (u64 i = 0; i < 4 * num_elements; ++i) {
+      const u64 key = base + i;
+      found += table_contains(&table, &vtable, &key);
+    }
+    table_deinit(&table, allocator);
+  }
+  bench_sink = found;
+
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%s %zu elements",
+                 small ? "small" : "heap ", num_elements);
+  bench_report(label, num_tables, bench_now() - start);
+}
+
+int main(int argc, char **argv) {
+  const usize num_tables = bench_arg(argc, argv, 1, 1 << 20);
+  const usize num_elements = bench_arg(argc, argv, 2, 6);
+
+  bench(false, num_tables, num_elements);
+  bench(true, num_tables, num_elements);
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table_snapshot.h>
+
+// usage: table_snapshot.out [num_elements] [path]
+//
+// startup cost of a lookup table: rebuilding it by inserting every element
+// against mapping a snapshot, each followed by one lookup per element. The
+// file is usually still in the page cache, so this measures the cost of
+// hashing versus the cost of page faults
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+};
+
+static usize lookup_all(const Table *table, usize num_elements) {
+  usize found = 0;
+  for (u64 i = 0; i < num_elements; ++i) {
+    found += table_contains(table, &vtable, &i);
+  }
+  return found;
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 23);
+  const char *path = argc > 2 ? argv[2] : "/tmp/uc_bench_table_snapshot.bin";
+
+  Table(u64) table;
+  double start = bench_now();
+  table_init(&table, &vtable, 8, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+  bench_report("rebuild by insertion", num_elements, bench_now() - start);
+
+  start = bench_now();
+  bench_sink = lookup_all(&table, num_elements);
+  bench_report("lookup after rebuild", num_elements, bench_now() - start);
+
+  Error error = 0;
+  start = bench_now();
+  table_save(&table, &vtable, path, allocator_global, &error);
+  bench_report("table_save", num_elements, bench_now() - start);
+  table_deinit(&table, allocator_global);
+  if (error) {
+    (void)fprintf(stderr, "could not save %s: %d\n", path, error);
+    return 1;
+  }
+
+  Table(u64) mapped;
+  TableMapping mapping;
+  start = bench_now();
+  table_map(&mapped, &vtable, path, TABLE_MAP_READ_ONLY, &mapping, &error);
+  bench_report("table_map", num_elements, bench_now() - start);
+  if (error) {
+    (void)fprintf(stderr, "could not map %s: %d\n", path, error);
+    return 1;
+  }
+
+  start = bench_now();
+  bench_sink = lookup_all(&mapped, num_elements);
+  bench_report("first lookup after table_map", num_elements,
+               bench_now() - start);
+
+  table_unmap(&mapping);
+  (void)remove(path);
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include "bench.h"
+
+#include <uc/table.h>
+
+#include <string.h>
+
+// usage: table_store_hash.out [num_elements]
+//
+// compares resize and lookup times with and without `store_hash` for a small
+// element with a cheap hash and a large element keyed by a string
+
+typedef struct Large Large;
+struct Large {
+  char key[32];
+  u64 value[12];
+};
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  u64 x = *(const u64 *)element;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+  return x;
+}
+
+static bool large_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return strcmp(((const Large *)a)->key, ((const Large *)b)->key) == 0;
+}
+
+static void large_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(Large *)dest = *(const Large *)src;
+}
+
+// FNV-1a over the key string, representative of a typical string hash
+static u64 large_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  u64 hash = 0xcbf29ce484222325ull;
+  for (const char *c = ((const Large *)element)->key; *c; ++c) {
+    hash ^= (u8)*c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static void make_large(Large *large, u64 i) {
+  memset(large, 0, sizeof(*large));
+  (void)snprintf(large->key, sizeof(large->key), "user:%020llu",
+                 (unsigned long long)(i * 0x9E3779B97F4A7C15ull));
+  large->value[0] = i;
+}
+
+static void bench(const char *name, const TableVTable *vtable,
+                  usize num_elements, void (*make)(void *, u64)) {
+  byte *element = malloc(vtable->element_size);
+  Table(byte) table;
+  table_init(&table, vtable, num_elements, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    make(element, i);
+    table_insert(&table, vtable, element, allocator_global, NULL);
+  }
+
+  char label[128];
+  double start = bench_now();
+  table_reserve(&table, vtable, table.end * 2, allocator_global, NULL);
+  (void)snprintf(label, sizeof(label), "%s resize", name);
+  bench_report(label, num_elements, bench_now() - start);
+
+  u64 state = 42;
+  usize found = 0;
+  start = bench_now();
+  for (usize i = 0; i < num_elements; ++i) {
+    make(element, bench_random(&state) % (2 * num_elements));
+    found += table_contains(&table, vtable, element);
+  }
+  (void)snprintf(label, sizeof(label), "%s lookup", name);
+  bench_report(label, num_elements, bench_now() - start);
+  bench_sink = found;
+
+  free(element);
+  table_deinit(&table, allocator_global);
+}
+
+static void make_u64(void *element, u64 i) { *(u64 *)element = i; }
+static void make_large_(void *element, u64 i) { make_large(element, i); }
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 22);
+
+  TableVTable small = {
+      .element_size = sizeof(u64),
+      .compare = u64_compare,
+      .insert = u64_insert,
+      .overwrite = u64_insert,
+      .hash = u64_hash,
+  };
+  TableVTable large = {
+      .element_size = sizeof(Large),
+      .compare = large_compare,
+      .insert = large_insert,
+      .overwrite = large_insert,
+      .hash = large_hash,
+  };
+
+  bench("u64", &small, num_elements, make_u64);
+  small.store_hash = true;
+  bench("u64 store_hash", &small, num_elements, make_u64);
+
+  bench("string key 128B", &large, num_elements, make_large_);
+  large.store_hash = true;
+  bench("string key 128B store_hash", &large, num_elements, make_large_);
+  return 0;
+}
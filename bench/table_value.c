@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <uc/hash.h>
+#include <uc/table.h>
+
+// usage: table_value.out [num_elements] [num_lookups]
+//
+// compares lookups of u64 keys with values of different sizes, stored inline
+// in the elements and stored in the parallel value array of `value_size`.
+// Half of the lookups miss, every hit reads its value
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+// copies `*(usize *)ctx` bytes, the key and the inline value if there is one
+static void bytes_insert(void *dest, const void *src, void *ctx) {
+  builtin_memcpy(dest, src, *(const usize *)ctx);
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static void bench(usize value_size, bool split, usize num_elements,
+                  usize num_lookups) {
+  usize element_size = sizeof(u64) + (split ? 0 : value_size);
+  const TableVTable vtable = {
+      .element_size = element_size,
+      .compare = u64_compare,
+      .insert = bytes_insert,
+      .overwrite = bytes_insert,
+      .hash = u64_hash,
+      .ctx = &element_size,
+      .value_size = split ? value_size : 0,
+  };
+
+  byte *element = calloc(1, sizeof(u64) + value_size);
+  Table(byte) table;
+  table_init(&table, &vtable, num_elements, allocator_global, NULL);
+  for (u64 i = 0; i < num_elements; ++i) {
+    builtin_memcpy(element, &i, sizeof(i));
+    builtin_memcpy(element + sizeof(u64), &i, sizeof(i));
+    const usize index =
+        table_insert(&table, &vtable, element, allocator_global, NULL);
+    if (split) {
+      builtin_memcpy(table_value(&table, &vtable, index),
+                     element + sizeof(u64), value_size);
+    }
+  }
+
+  u64 state = 42;
+  u64 sum = 0;
+  const double start = bench_now();
+  for (usize i = 0; i < num_lookups; ++i) {
+    const u64 key = bench_random(&state) % (2 * num_elements);
+    const usize index = table_find(&table, &vtable, &key);
+    if (table_isset(&table, &vtable, index)) {
+      const byte *value = split ? table_value(&table, &vtable, index)
+                                : (byte *)table_get(&table, &vtable, index) +
+                                      sizeof(u64);
+      u64 x;
+      builtin_memcpy(&x, value, sizeof(x));
+      sum += x;
+    }
+  }
+  bench_sink = sum;
+
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%4zu byte values %s", value_size,
+                 split ? "split " : "inline");
+  bench_report(label, num_lookups, bench_now() - start);
+
+  table_deinit(&table, allocator_global);
+  free(element);
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 18);
+  const usize num_lookups = bench_arg(argc, argv, 2, 1 << 22);
+
+  const usize value_sizes[] = {8, 32, 64, 128, 256, 512};
+  for (usize i = 0; i < sizeof(value_sizes) / sizeof(*value_sizes); ++i) {
+    bench(value_sizes[i], false, num_elements, num_lookups);
+    bench(value_sizes[i], true, num_elements, num_lookups);
+  }
+  return 0;
+}
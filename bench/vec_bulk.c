@@ -0,0 +1,72 @@
+#include "bench.h"
+
+#include <uc/vec.h>
+
+// usage: vec_bulk.out [num_batches] [batch_size]
+//
+// log batching: batches of `batch_size` `u64`s are appended, inserted in the
+// middle and dropped from the front, one element at a time against the bulk
+// functions. Reported per element
+
+typedef Vec(u64) U64Vec;
+
+static void bench(bool bulk, usize num_batches, usize batch_size) {
+  u64 *batch = malloc(batch_size * sizeof(u64));
+  for (usize i = 0; i < batch_size; ++i) {
+    batch[i] = i;
+  }
+  U64Vec vec;
+  vec_init(&vec, sizeof(u64), 1, allocator_global, NULL);
+  const char *mode = bulk ? "bulk" : "loop";
+  char label[128];
+
+  double start = bench_now();
+  for (usize b = 0; b < num_batches; ++b) {
+    if (bulk) {
+      vec_extend(&vec, sizeof(u64), batch, batch_size, allocator_global,
+                 NULL);
+    } else {
+      for (usize i = 0; i < batch_size; ++i) {
+        vec_push(&vec, sizeof(u64), &batch[i], allocator_global, NULL);
+      }
+    }
+  }
+  (void)snprintf(label, sizeof(label), "%s append", mode);
+  bench_report(label, num_batches * batch_size, bench_now() - start);
+
+  // a few batches into the middle of a vec which keeps its size, every
+  // insert moves the whole tail
+  const usize num_inserts = num_batches / 64 ? num_batches / 64 : 1;
+  start = bench_now();
+  for (usize b = 0; b < num_inserts; ++b) {
+    const usize index = vec.length / 2;
+    if (bulk) {
+      vec_insert_many(&vec, sizeof(u64), index, batch, batch_size,
+                      allocator_global, NULL);
+      vec_remove_range(&vec, sizeof(u64), 0, batch_size);
+    } else {
+      for (usize i = 0; i < batch_size; ++i) {
+        vec_insert(&vec, sizeof(u64), index + i, &batch[i], allocator_global,
+                   NULL);
+      }
+      for (usize i = 0; i < batch_size; ++i) {
+        vec_remove(&vec, sizeof(u64), 0);
+      }
+    }
+  }
+  (void)snprintf(label, sizeof(label), "%s insert middle, drop front", mode);
+  bench_report(label, num_inserts * batch_size, bench_now() - start);
+  bench_sink = vec.element[vec.length / 3];
+
+  vec_deinit(&vec, sizeof(u64), allocator_global);
+  free(batch);
+}
+
+int main(int argc, char **argv) {
+  const usize num_batches = bench_arg(argc, argv, 1, 1 << 12);
+  const usize batch_size = bench_arg(argc, argv, 2, 256);
+
+  bench(false, num_batches, batch_size);
+  bench(true, num_batches, batch_size);
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "bench.h"
+
+#include <uc/allocator_pages.h>
+#include <uc/vec.h>
+
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// usage: vec_pages.out [num_bytes]
+//
+// pushes `u64`s into a vec until it holds `num_bytes`, reporting the push
+// throughput and the peak resident set size. Each run is a child process so
+// that the peaks are measured separately. Compared are `allocator_pages`,
+// `allocator_global` (glibc's `realloc` already moves large chunks with
+// `mremap`) and an allocator whose realloc copies like most allocators do.
+// While copying, the old array and the touched part of the new one are both
+// resident, which peaks at the final size if that is a power of two
+
+// realloc without help from the kernel: allocate, copy everything, free.
+// Chunks keep their size in front of them
+static void *copying_realloc(Allocator *allocator, void *chunk,
+                             usize num_bytes, Error *error) {
+  UNUSED(allocator);
+  usize *p = allocator_alloc(allocator_global, num_bytes + 16, error);
+  if (!p) {
+    return NULL;
+  }
+  *p = num_bytes;
+  if (chunk) {
+    const usize *old = (const usize *)chunk - 2;
+    memcpy(p + 2, chunk, *old < num_bytes ? *old : num_bytes);
+    allocator_free(allocator_global, (usize *)chunk - 2);
+  }
+  return p + 2;
+}
+
+static void *copying_alloc(Allocator *allocator, usize num_bytes,
+                           Error *error) {
+  return copying_realloc(allocator, NULL, num_bytes, error);
+}
+
+static void copying_free(Allocator *allocator, void *chunk) {
+  UNUSED(allocator);
+  if (chunk) {
+    allocator_free(allocator_global, (usize *)chunk - 2);
+  }
+}
+
+static AllocatorVTable copying_vtable = {
+    .alloc = copying_alloc,
+    .free = copying_free,
+    .realloc = copying_realloc,
+};
+
+static AllocatorInternal copying = {.vtable = &copying_vtable};
+
+static void run(const char *name, Allocator *allocator, usize num_bytes) {
+  Vec(u64) vec;
+  vec_init(&vec, sizeof(u64), 1, allocator, NULL);
+
+  const usize count = num_bytes / sizeof(u64);
+  Error error = 0;
+  const double start = bench_now();
+  for (u64 i = 0; i < count; ++i) {
+    vec_push(&vec, sizeof(u64), &i, allocator, &error);
+  }
+  const double seconds = bench_now() - start;
+
+  struct rusage usage;
+  (void)getrusage(RUSAGE_SELF, &usage);
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%s %zu MB, peak %ld MB", name,
+                 num_bytes >> 20, (long)usage.ru_maxrss >> 10);
+  bench_report(label, count, seconds);
+  bench_sink = vec.element[count / 2] + (u64)error;
+}
+
+static void run_child(const char *name, Allocator *allocator,
+                      usize num_bytes) {
+  (void)fflush(stdout);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    run(name, allocator, num_bytes);
+    (void)fflush(stdout);
+    _exit(0);
+  }
+  int status = 0;
+  (void)waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+    printf("%s %zu MB failed\n", name, num_bytes >> 20);
+  }
+}
+
+int main(int argc, char **argv) {
+  const usize num_bytes = bench_arg(argc, argv, 1, (usize)1 << 32);
+
+  run_child("allocator_pages ", allocator_pages, num_bytes);
+  run_child("allocator_global", allocator_global, num_bytes);
+  run_child("copying realloc ", &copying, num_bytes);
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "bench.h"
+
+#include <uc/vec.h>
+
+// usage: vec_retain.out [num_elements] [percent_kept]
+//
+// filters `num_elements` random values, keeping about `percent_kept` percent,
+// with the range kernels, with `vec_retain` and a predicate and, on a slice,
+// with repeated `vec_remove`. Reported per element of the input. Built with
+// and without `-mavx2` to compare the kernels
+
+static bool keep_below(const void *element, void *ctx) {
+  return *(const u32 *)element <= *(const u32 *)ctx;
+}
+
+int main(int argc, char **argv) {
+  const usize num_elements = bench_arg(argc, argv, 1, 1 << 24);
+  const usize percent_kept = bench_arg(argc, argv, 2, 50);
+
+  u32 *values32 = malloc(num_elements * sizeof(u32));
+  u64 *values64 = malloc(num_elements * sizeof(u64));
+  u64 state = 1;
+  for (usize i = 0; i < num_elements; ++i) {
+    values64[i] = bench_random(&state);
+    values32[i] = (u32)values64[i];
+  }
+  u32 high32 = (u32)(0xffffffffull * percent_kept / 100);
+  const u64 high64 = percent_kept >= 100 ? ~0ull : ~0ull / 100 * percent_kept;
+
+  Vec(u32) vec32;
+  Vec(u64) vec64;
+  vec_init(&vec32, sizeof(u32), num_elements, allocator_global, NULL);
+  vec_init(&vec64, sizeof(u64), num_elements, allocator_global, NULL);
+
+  char label[128];
+  (void)snprintf(label, sizeof(label), "%s vec_retain_range_u32",
+                 VEC_SIMD_NAME);
+  double best = 1e9;
+  for (int run = 0; run < 5; ++run) {
+    vec_resize(&vec32, sizeof(u32), 0, NULL, allocator_global, NULL);
+    vec_extend(&vec32, sizeof(u32), values32, num_elements, allocator_global,
+               NULL);
+    const double start = bench_now();
+    vec_retain_range_u32(&vec32, 0, high32);
+    const double seconds = bench_now() - start;
+    best = seconds < best ? seconds : best;
+  }
+  bench_report(label, num_elements, best);
+  bench_sink = vec32.length;
+
+  (void)snprintf(label, sizeof(label), "%s vec_retain_range_u64",
+                 VEC_SIMD_NAME);
+  best = 1e9;
+  for (int run = 0; run < 5; ++run) {
+    vec_resize(&vec64, sizeof(u64), 0, NULL, allocator_global, NULL);
+    vec_extend(&vec64, sizeof(u64), values64, num_elements, allocator_global,
+               NULL);
+    const double start = bench_now();
+    vec_retain_range_u64(&vec64, 0, high64);
+    const double seconds = bench_now() - start;
+    best = seconds < best ? seconds : best;
+  }
+  bench_report(label, num_elements, best);
+  bench_sink = vec64.length;
+
+  best = 1e9;
+  for (int run = 0; run < 5; ++run) {
+    vec_resize(&vec32, sizeof(u32), 0, NULL, allocator_global, NULL);
+    vec_extend(&vec32, sizeof(u32), values32, num_elements, allocator_global,
+               NULL);
+    const double start = bench_now();
+    vec_retain(&vec32, sizeof(u32), keep_below, &high32);
+    const double seconds = bench_now() - start;
+    best = seconds < best ? seconds : best;
+  }
+  bench_report("vec_retain u32", num_elements, best);
+  bench_sink = vec32.length;
+
+  // quadratic, so only on a slice
+  const usize slice = num_elements < (1 << 16) ? num_elements : 1 << 16;
+  vec_resize(&vec32, sizeof(u32), 0, NULL, allocator_global, NULL);
+  vec_extend(&vec32, sizeof(u32), values32, slice, allocator_global, NULL);
+  const double start = bench_now();
+  for (usize i = vec32.length; i-- > 0;) {
+    if (vec32.element[i] > high32) {
+      vec_remove(&vec32, sizeof(u32), i);
+    }
+  }
+  (void)snprintf(label, sizeof(label), "vec_remove u32, %zu elements", slice);
+  bench_report(label, slice, bench_now() - start);
+  bench_sink = vec32.length;
+
+  vec_deinit(&vec32, sizeof(u32), allocator_global);
+  vec_deinit(&vec64, sizeof(u64), allocator_global);
+  free(values32);
+  free(values64);
+  return 0;
+}
@@ -0,0 +1,215 @@
+#include "bench.h"
+
+#include <uc/vec_scan.h>
+
+// usage: vec_scan.out [count] [rounds]
+//
+// every scan kernel against the plain loop it replaces, over vecs of `count`
+// elements, `rounds` times. The loops are kept from being vectorized by the
+// compiler, so they show what scalar code does. Reported per element
+
+typedef Vec(u8) U8Vec;
+typedef Vec(u32) U32Vec;
+typedef Vec(u64) U64Vec;
+typedef Vec(i32) I32Vec;
+typedef Vec(i64) I64Vec;
+typedef Vec(float) FloatVec;
+
+#define NO_VECTORIZE                                                          \
+  __attribute__((noinline, optimize("no-tree-vectorize")))
+
+NO_VECTORIZE static usize loop_find_u8(const U8Vec *vec, u8 value) {
+  for (usize i = 0; i < vec->length; ++i) {
+    if (vec->element[i] == value) {
+      return i;
+    }
+  }
+  return vec->length;
+}
+
+NO_VECTORIZE static usize loop_find_u32(const U32Vec *vec, u32 value) {
+  for (usize i = 0; i < vec->length; ++i) {
+    if (vec->element[i] == value) {
+      return i;
+    }
+  }
+  return vec->length;
+}
+
+NO_VECTORIZE static usize loop_find_u64(const U64Vec *vec, u64 value) {
+  for (usize i = 0; i < vec->length; ++i) {
+    if (vec->element[i] == value) {
+      return i;
+    }
+  }
+  return vec->length;
+}
+
+NO_VECTORIZE static usize loop_count_eq_u8(const U8Vec *vec, u8 value) {
+  usize count = 0;
+  for (usize i = 0; i < vec->length; ++i) {
+    count += vec->element[i] == value;
+  }
+  return count;
+}
+
+NO_VECTORIZE static usize loop_count_eq_u32(const U32Vec *vec, u32 value) {
+  usize count = 0;
+  for (usize i = 0; i < vec->length; ++i) {
+    count += vec->element[i] == value;
+  }
+  return count;
+}
+
+NO_VECTORIZE static i64 loop_sum_i32(const I32Vec *vec) {
+  i64 sum = 0;
+  for (usize i = 0; i < vec->length; ++i) {
+    sum += vec->element[i];
+  }
+  return sum;
+}
+
+NO_VECTORIZE static i64 loop_sum_i64(const I64Vec *vec) {
+  u64 sum = 0;
+  for (usize i = 0; i < vec->length; ++i) {
+    sum += (u64)vec->element[i];
+  }
+  return (i64)sum;
+}
+
+NO_VECTORIZE static i64 loop_minmax_i32(const I32Vec *vec) {
+  i32 low = vec->element[0];
+  i32 high = vec->element[0];
+  for (usize i = 1; i < vec->length; ++i) {
+    low = vec->element[i] < low ? vec->element[i] : low;
+    high = vec->element[i] > high ? vec->element[i] : high;
+  }
+  return (i64)low + high;
+}
+
+NO_VECTORIZE static float loop_minmax_f32(const FloatVec *vec) {
+  float low = INFINITY;
+  float high = -INFINITY;
+  for (usize i = 0; i < vec->length; ++i) {
+    low = vec->element[i] < low ? vec->element[i] : low;
+    high = vec->element[i] > high ? vec->element[i] : high;
+  }
+  return low + high;
+}
+
+enum {
+  FIND_U8,
+  FIND_U32,
+  FIND_U64,
+  COUNT_EQ_U8,
+  COUNT_EQ_U32,
+  SUM_I32,
+  SUM_I64,
+  MINMAX_I32,
+  MINMAX_F32,
+  NUM_KERNELS
+};
+
+static const char *kernel_name[] = {
+    "find_u8", "find_u32", "find_u64",   "count_eq_u8", "count_eq_u32",
+    "sum_i32", "sum_i64",  "minmax_i32", "minmax_f32"};
+
+typedef struct Input Input;
+struct Input {
+  U8Vec u8s;
+  U32Vec u32s;
+  U64Vec u64s;
+  I32Vec i32s;
+  I64Vec i64s;
+  FloatVec floats;
+};
+
+static u64 run(int kernel, bool simd, const Input *in) {
+  i32 low = 0;
+  i32 high = 0;
+  float low_f = 0;
+  float high_f = 0;
+  switch (kernel) {
+  // the searched values are absent, the whole vec is scanned
+  case FIND_U8:
+    return simd ? vec_find_u8(&in->u8s, 0xff) : loop_find_u8(&in->u8s, 0xff);
+  case FIND_U32:
+    return simd ? vec_find_u32(&in->u32s, 1u << 31)
+                : loop_find_u32(&in->u32s, 1u << 31);
+  case FIND_U64:
+    return simd ? vec_find_u64(&in->u64s, 1ull << 63)
+                : loop_find_u64(&in->u64s, 1ull << 63);
+  case COUNT_EQ_U8:
+    return simd ? vec_count_eq_u8(&in->u8s, 3)
+                : loop_count_eq_u8(&in->u8s, 3);
+  case COUNT_EQ_U32:
+    return simd ? vec_count_eq_u32(&in->u32s, 3)
+                : loop_count_eq_u32(&in->u32s, 3);
+  case SUM_I32:
+    return (u64)(simd ? vec_sum_i32(&in->i32s) : loop_sum_i32(&in->i32s));
+  case SUM_I64:
+    return (u64)(simd ? vec_sum_i64(&in->i64s) : loop_sum_i64(&in->i64s));
+  case MINMAX_I32:
+    if (!simd) {
+      return (u64)loop_minmax_i32(&in->i32s);
+    }
+    vec_minmax_i32(&in->i32s, &low, &high);
+    return (u64)((i64)low + high);
+  default:
+    if (!simd) {
+      return (u64)loop_minmax_f32(&in->floats);
+    }
+    vec_minmax_f32(&in->floats, &low_f, &high_f);
+    return (u64)(low_f + high_f);
+  }
+}
+
+int main(int argc, char **argv) {
+  const usize count = bench_arg(argc, argv, 1, 1 << 16);
+  const usize rounds = bench_arg(argc, argv, 2, 1 << 12);
+
+  Input in;
+  vec_init(&in.u8s, sizeof(u8), count, allocator_global, NULL);
+  vec_init(&in.u32s, sizeof(u32), count, allocator_global, NULL);
+  vec_init(&in.u64s, sizeof(u64), count, allocator_global, NULL);
+  vec_init(&in.i32s, sizeof(i32), count, allocator_global, NULL);
+  vec_init(&in.i64s, sizeof(i64), count, allocator_global, NULL);
+  vec_init(&in.floats, sizeof(float), count, allocator_global, NULL);
+  u64 state = 1;
+  for (usize i = 0; i < count; ++i) {
+    const u64 r = bench_random(&state);
+    in.u8s.element[i] = (u8)(r % 200);
+    in.u32s.element[i] = (u32)r >> 1;
+    in.u64s.element[i] = r >> 1;
+    in.i32s.element[i] = (i32)(u32)r;
+    in.i64s.element[i] = (i64)r;
+    in.floats.element[i] = (float)(i32)(u32)r;
+  }
+  in.u8s.length = in.u32s.length = in.u64s.length = count;
+  in.i32s.length = in.i64s.length = in.floats.length = count;
+
+  printf("kernels: %s\n", VEC_SCAN_NAME);
+  for (int kernel = 0; kernel < NUM_KERNELS; ++kernel) {
+    for (int simd = 0; simd < 2; ++simd) {
+      u64 sink = 0;
+      const double start = bench_now();
+      for (usize r = 0; r < rounds; ++r) {
+        sink += run(kernel, simd, &in);
+      }
+      const double seconds = bench_now() - start;
+      bench_sink = sink;
+      char label[64];
+      (void)snprintf(label, sizeof(label), "%s %s", kernel_name[kernel],
+                     simd ? "vec_scan" : "loop");
+      bench_report(label, count * rounds, seconds);
+    }
+  }
+
+  vec_deinit(&in.u8s, sizeof(u8), allocator_global);
+  vec_deinit(&in.u32s, sizeof(u32), allocator_global);
+  vec_deinit(&in.u64s, sizeof(u64), allocator_global);
+  vec_deinit(&in.i32s, sizeof(i32), allocator_global);
+  vec_deinit(&in.i64s, sizeof(i64), allocator_global);
+  vec_deinit(&in.floats, sizeof(float), allocator_global);
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "bench.h"
+
+#include <uc/vec_sort.h>
+
+#include <string.h>
+
+// usage: vec_sort.out [max_count] [num_threads]
+//
+// sorts `u64`s and 16 byte records keyed by a `u64` with `qsort`, `vec_sort`
+// and `vec_sort_by_key`, on one and on `num_threads` threads, for sizes from
+// 1000 up to `max_count` and several distributions. Reported per element
+
+typedef struct Record Record;
+struct Record {
+  u64 key;
+  u64 value;
+};
+
+typedef Vec(byte) ByteVec;
+
+static int u64_compare(const void *a, const void *b) {
+  const u64 x = *(const u64 *)a;
+  const u64 y = *(const u64 *)b;
+  return (x > y) - (x < y);
+}
+
+static bool u64_less(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a < *(const u64 *)b;
+}
+
+static int record_compare(const void *a, const void *b) {
+  return u64_compare(&((const Record *)a)->key, &((const Record *)b)->key);
+}
+
+static bool record_less(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Record *)a)->key < ((const Record *)b)->key;
+}
+
+static u64 record_key(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return ((const Record *)element)->key;
+}
+
+enum { RANDOM, SORTED, FEW, NARROW, NUM_DISTRIBUTIONS };
+
+static const char *distribution_name[] = {"random", "sorted", "16 unique",
+                                          "< 2^20"};
+
+static u64 distribution(int kind, usize i, u64 *state) {
+  switch (kind) {
+  case RANDOM:
+    return bench_random(state);
+  case SORTED:
+    return i;
+  case FEW:
+    return bench_random(state) % 16;
+  default:
+    return bench_random(state) >> 44;
+  }
+}
+
+enum { QSORT, VEC_SORT, BY_KEY, BY_KEY_THREADS, NUM_SORTS };
+
+static const char *sort_name[] = {"qsort", "vec_sort", "vec_sort_by_key",
+                                  "vec_sort_by_key threads"};
+
+// runs `sort` on fresh copies of `input` until at least 0.2 seconds passed,
+// returns the best time of a run
+static double run(int sort, bool records, const byte *input, usize count,
+                  usize num_threads) {
+  const usize element_size = records ? sizeof(Record) : sizeof(u64);
+  ByteVec vec;
+  vec_init(&vec, element_size, count, allocator_global, NULL);
+  vec.length = count;
+
+  double best = 1e9;
+  double total = 0;
+  for (int r = 0; r < 3 || total < 0.2; ++r) {
+    memcpy(vec.element, input, count * element_size);
+    const double start = bench_now();
+    switch (sort) {
+    case QSORT:
+      qsort(vec.element, count, element_size,
+            records ? record_compare : u64_compare);
+      break;
+    case VEC_SORT:
+      vec_sort(&vec, element_size, records ? record_less : u64_less, NULL);
+      break;
+    default:
+      vec_sort_by_key(&vec, element_size, records ? record_key : NULL, NULL,
+                      sort == BY_KEY ? 1 : num_threads, allocator_global,
+                      NULL);
+    }
+    const double seconds = bench_now() - start;
+    best = seconds < best ? seconds : best;
+    total += seconds;
+  }
+  bench_sink = vec.element[count / 2 * element_size];
+  vec_deinit(&vec, element_size, allocator_global);
+  return best;
+}
+
+int main(int argc, char **argv) {
+  const usize max_count = bench_arg(argc, argv, 1, (usize)1 << 22);
+  const usize num_threads = bench_arg(argc, argv, 2, 4);
+
+  Record *input = malloc(max_count * sizeof(Record));
+  u64 *keys = malloc(max_count * sizeof(u64));
+  for (int records = 0; records < 2; ++records) {
+    for (int kind = 0; kind < NUM_DISTRIBUTIONS; ++kind) {
+      u64 state = 1;
+      for (usize i = 0; i < max_count; ++i) {
+        input[i].key = distribution(kind, i, &state);
+        input[i].value = i;
+        keys[i] = input[i].key;
+      }
+      for (usize count = 1000; count <= max_count; count *= 16) {
+        for (int sort = 0; sort < NUM_SORTS; ++sort) {
+          char label[128];
+          (void)snprintf(label, sizeof(label), "%s %s %zu %s",
+                         records ? "record" : "u64", distribution_name[kind],
+                         count, sort_name[sort]);
+          const byte *data =
+              records ? (const byte *)input : (const byte *)keys;
+          bench_report(label, count,
+                       run(sort, records, data, count, num_threads));
+        }
+      }
+    }
+  }
+  free(input);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,197 @@
+#ifndef ALLOCATOR_PAGES_H_
+#define ALLOCATOR_PAGES_H_
+
+#include <uc/allocator.h>
+#include <uc/builtin.h>
+#include <uc/debug_check.h>
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/***
+ * @file
+ * Allocator which gives large chunks their own page mappings. Requires a
+ * POSIX system.
+ *
+ * Chunks smaller than `ALLOCATOR_PAGES_THRESHOLD` come from `malloc`, larger
+ * ones are mapped from `/dev/zero`. Reallocating a mapped chunk on Linux
+ * moves its page table entries with `mremap` instead of copying the bytes,
+ * so a `Vec` growing into gigabytes never copies and never holds the old and
+ * the new array at once. A chunk which grows past the threshold is copied
+ * into a mapping once and stays mapped from then on. Other systems copy into
+ * a new mapping.
+ *
+ * glibc's `realloc` does the same above its own, tunable mmap threshold,
+ * this makes the behaviour independent of the C library.
+ *
+ * Every chunk carries a 16 byte header, chunks are 16 byte aligned.
+ *
+ * @example:
+ * ```c
+ * Vec(u64) vec;
+ * vec_init(&vec, sizeof(u64), 1, allocator_pages, NULL);
+ * ```
+ */
+
+// chunks of at least this many bytes, header included, are mapped
+#ifndef ALLOCATOR_PAGES_THRESHOLD
+#define ALLOCATOR_PAGES_THRESHOLD ((usize)1 << 20)
+#endif
+
+#if defined(__linux__)
+// only declared by `sys/mman.h` with `_GNU_SOURCE`
+void *mremap(void *old_address, size_t old_size, size_t new_size, int flags,
+             ...);
+#define ALLOCATOR_PAGES_INTERNAL_MREMAP_MAYMOVE 1
+#endif
+
+typedef struct AllocatorPagesHeader AllocatorPagesHeader;
+struct AllocatorPagesHeader {
+  // bytes of the chunk including the header
+  u64 size;
+  // whether the chunk is a mapping or comes from `malloc`
+  u64 mapped;
+};
+
+// maps `num_bytes` zeroed bytes, `MAP_ANONYMOUS` is not part of POSIX
+static void *allocator_pages_internal_map(usize num_bytes, Error *error) {
+  const int fd = open("/dev/zero", O_RDWR);
+  if (UNLIKELY(fd < 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return NULL;
+  }
+  void *p = mmap(NULL, num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  (void)close(fd);
+  if (UNLIKELY(p == MAP_FAILED)) {
+    if (error) {
+      *error = ENOMEM;
+    }
+    return NULL;
+  }
+  return p;
+}
+
+static void *allocator_pages_internal_alloc(Allocator *allocator,
+                                            usize num_bytes, Error *error) {
+  UNUSED(allocator);
+
+  AllocatorPagesHeader *header;
+  num_bytes += sizeof(*header);
+  if (num_bytes < ALLOCATOR_PAGES_THRESHOLD) {
+    header = malloc(num_bytes);
+    if (UNLIKELY(!header)) {
+      if (error) {
+        *error = ENOMEM;
+      }
+      return NULL;
+    }
+    header->mapped = false;
+  } else {
+    header = allocator_pages_internal_map(num_bytes, error);
+    if (UNLIKELY(!header)) {
+      return NULL;
+    }
+    header->mapped = true;
+  }
+  header->size = num_bytes;
+  return header + 1;
+}
+
+static void allocator_pages_internal_free(Allocator *allocator, void *chunk) {
+  UNUSED(allocator);
+  if (!chunk) {
+    return;
+  }
+
+  AllocatorPagesHeader *header = (AllocatorPagesHeader *)chunk - 1;
+  if (header->mapped) {
+    (void)munmap(header, header->size);
+  } else {
+    free(header);
+  }
+}
+
+static void *allocator_pages_internal_realloc(Allocator *allocator,
+                                              void *chunk, usize num_bytes,
+                                              Error *error) {
+  if (UNLIKELY(!chunk)) {
+    return allocator_pages_internal_alloc(allocator, num_bytes, error);
+  }
+
+  AllocatorPagesHeader *header = (AllocatorPagesHeader *)chunk - 1;
+  const usize new_size = num_bytes + sizeof(*header);
+
+  if (!header->mapped && new_size < ALLOCATOR_PAGES_THRESHOLD) {
+    AllocatorPagesHeader *p = realloc(header, new_size);
+    if (UNLIKELY(!p)) {
+      if (error) {
+        *error = ENOMEM;
+      }
+      return NULL;
+    }
+    p->size = new_size;
+    return p + 1;
+  }
+
+#if defined(ALLOCATOR_PAGES_INTERNAL_MREMAP_MAYMOVE)
+  if (header->mapped) {
+    AllocatorPagesHeader *p =
+        mremap(header, header->size, new_size,
+               ALLOCATOR_PAGES_INTERNAL_MREMAP_MAYMOVE);
+    if (UNLIKELY(p == MAP_FAILED)) {
+      if (error) {
+        *error = ENOMEM;
+      }
+      return NULL;
+    }
+    p->size = new_size;
+    return p + 1;
+  }
+#endif
+
+  AllocatorPagesHeader *p = allocator_pages_internal_map(new_size, error);
+  if (UNLIKELY(!p)) {
+    return NULL;
+  }
+  const usize old_size = header->size;
+  builtin_memcpy(p + 1, chunk,
+                 (old_size < new_size ? old_size : new_size) - sizeof(*p));
+  p->size = new_size;
+  p->mapped = true;
+  allocator_pages_internal_free(allocator, chunk);
+  return p + 1;
+}
+
+static AllocatorVTable allocator_pages_internal_vtable = {
+    .free = allocator_pages_internal_free,
+    .alloc = allocator_pages_internal_alloc,
+    .realloc = allocator_pages_internal_realloc,
+};
+
+static AllocatorInternal allocator_pages_internal = {
+    .vtable = &allocator_pages_internal_vtable,
+};
+
+/***
+ * @doc(variable): allocator_pages
+ * @tag: all
+ *
+ * @brief: Global allocator mapping chunks of at least
+ * `ALLOCATOR_PAGES_THRESHOLD` bytes, see the file documentation. Thread safe.
+ */
+static Allocator *allocator_pages = &allocator_pages_internal;
+
+static void allocator_pages_dummy_callee__(void);
+static void allocator_pages_dummy_caller__(void) {
+  UNUSED(allocator_pages);
+  allocator_pages_dummy_callee__();
+}
+static void allocator_pages_dummy_callee__(void) {
+  allocator_pages_dummy_caller__();
+}
+
+#endif // ALLOCATOR_PAGES_H_
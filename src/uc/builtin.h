@@ -7,12 +7,18 @@
 #define builtin_memset __builtin_memset
 #define builtin_memcpy __builtin_memcpy
 #define builtin_memmove __builtin_memmove
+#define builtin_memcmp __builtin_memcmp
 
 #define builtin_expect __builtin_expect
+#define builtin_prefetch __builtin_prefetch
 
 #define builtin_ctz __builtin_ctz
+#define builtin_ctzll __builtin_ctzll
 #define builtin_clz __builtin_clz
 #define builtin_clzll __builtin_clzll
+#define builtin_popcountll __builtin_popcountll
+#define builtin_bswap32 __builtin_bswap32
+#define builtin_bswap64 __builtin_bswap64
 
 #define builtin_unreachable __builtin_unreachable
 #define builtin_trap __builtin_trap
@@ -0,0 +1,261 @@
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include <uc/table.h>
+
+/***
+ * @file
+ * Fixed capacity cache on top of the layout of `table.h`.
+ *
+ * A `Cache` holds at most `capacity` elements. Inserting into a full cache
+ * evicts an element which was not used recently, chosen by the CLOCK
+ * algorithm: every slot has a reference byte which is set whenever its
+ * element is accessed, and a hand sweeping over the slots clears set bytes
+ * and evicts the first element whose byte is already clear. The slots are
+ * allocated once by `cache_init` and the cache never reallocates, tombs left
+ * by evictions are purged in place.
+ *
+ * The reference bytes are stored as one byte values (see
+ * `TableVTable.value_size`), so `vtable->value_size` has to be `0`.
+ */
+
+/***
+ * @doc(type): Cache
+ * @tag: all
+ *
+ * @member(table): slots of the cache, may be read with `table_get` and
+ * `table_next` together with the vtable filled in by `cache_vtable`
+ *
+ * @member(hits): number of `cache_get` calls which found their element
+ *
+ * @member(misses): number of `cache_get` calls which did not
+ *
+ * @member(evictions): number of elements evicted to make room
+ */
+typedef struct Cache Cache;
+struct Cache {
+  Table(byte) table;
+  usize capacity;
+  usize hand;
+  u64 hits;
+  u64 misses;
+  u64 evictions;
+};
+
+/***
+ * @doc(function): cache_vtable
+ * @tag: all
+ *
+ * @brief: Fills `internal` with the vtable the slots of the cache are managed
+ * with, which is `vtable` with a one byte value for the reference byte.
+ */
+static void cache_vtable(TableVTable *internal, const TableVTable *vtable) {
+  debug_check(internal);
+  debug_check(vtable);
+  debug_check(!vtable->value_size);
+
+  *internal = *vtable;
+  internal->value_size = 1;
+  internal->migrate_groups = 0;
+}
+
+/***
+ * @doc(function): cache_init
+ * @tag: all
+ *
+ * @brief: Allocates the slots for `capacity` elements.
+ *
+ * @detailed: The table is sized for twice the capacity, which keeps probe
+ * sequences short and lets tombs accumulate between purges.
+ *
+ * @assert(capacity): `capacity > 0`
+ */
+static void cache_init(Cache *cache, const TableVTable *vtable, usize capacity,
+                       Allocator *allocator, Error *error) {
+  debug_check(cache);
+  debug_check(vtable);
+  debug_check(capacity > 0);
+  debug_check(allocator);
+
+  TableVTable internal;
+  cache_vtable(&internal, vtable);
+  builtin_memset(cache, 0, sizeof(*cache));
+  cache->capacity = capacity;
+  table_internal_init(&cache->table, &internal,
+                      table_internal_end_from_capacity(2 * capacity),
+                      allocator, error);
+}
+
+/***
+ * @doc(function): cache_deinit
+ * @tag: all
+ *
+ * @brief: Frees the slots. Like `table_deinit`, elements which are still
+ * cached are not destroyed.
+ */
+static void cache_deinit(Cache *cache, Allocator *allocator) {
+  debug_check(cache);
+  debug_check(allocator);
+
+  table_deinit(&cache->table, allocator);
+}
+
+// evicts the element the CLOCK hand stops at
+static void cache_internal_evict(Cache *cache, const TableVTable *internal) {
+  Table(byte) *table = (Table *)&cache->table;
+  byte *control = table_internal_control_array(table, internal);
+  byte *referenced = table_internal_value_array(table, internal);
+  const usize mask = table->end - 1;
+
+  // every set byte is cleared on the first lap, so this ends within two
+  while (1) {
+    const usize index = cache->hand;
+    cache->hand = (cache->hand + 1) & mask;
+    if (!(control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK)) {
+      continue;
+    }
+    if (referenced[index]) {
+      referenced[index] = 0;
+      continue;
+    }
+
+    if (internal->destroy) {
+      internal->destroy(table->element + internal->element_size * index,
+                        internal->ctx);
+    }
+    if (table_internal_control_erase(control, table->end, index)) {
+      table->tombs += 1;
+    }
+    table->length -= 1;
+    cache->evictions += 1;
+    return;
+  }
+}
+
+/***
+ * @doc(function): cache_get
+ * @tag: all
+ *
+ * @brief: Returns the cached element equal to `element` and marks it as
+ * recently used, or `NULL` if it is not cached.
+ *
+ * @detailed: The pointer is valid until the next `cache_put` or
+ * `cache_remove`.
+ */
+static void *cache_get(Cache *cache, const TableVTable *vtable,
+                       const void *element) {
+  debug_check(cache);
+  debug_check(vtable);
+  debug_check(element);
+
+  TableVTable internal;
+  cache_vtable(&internal, vtable);
+  Table(byte) *table = (Table *)&cache->table;
+  const usize index = table_internal_lookup(
+      table, &internal, element, vtable->hash(element, vtable->ctx));
+  if (!table_isset(table, &internal, index)) {
+    cache->misses += 1;
+    return NULL;
+  }
+  cache->hits += 1;
+  table_internal_value_array(table, &internal)[index] = 1;
+  return table->element + vtable->element_size * index;
+}
+
+/***
+ * @doc(function): cache_put
+ * @tag: all
+ *
+ * @brief: Inserts `element`, or overwrites the equal element, and marks it
+ * as recently used.
+ *
+ * @detailed: If the cache is full an element is evicted first and destroyed
+ * with `vtable->destroy`. Never allocates.
+ *
+ * @return: pointer to the cached element, valid until the next `cache_put`
+ * or `cache_remove`
+ */
+static void *cache_put(Cache *cache, const TableVTable *vtable,
+                       const void *element) {
+  debug_check(cache);
+  debug_check(vtable);
+  debug_check(element);
+
+  TableVTable internal;
+  cache_vtable(&internal, vtable);
+  Table(byte) *table = (Table *)&cache->table;
+  const u64 hash = vtable->hash(element, vtable->ctx);
+
+  usize index = table_internal_lookup(table, &internal, element, hash);
+  if (table_isset(table, &internal, index)) {
+    vtable->overwrite(table->element + vtable->element_size * index, element,
+                      vtable->ctx);
+    table_internal_value_array(table, &internal)[index] = 1;
+    return table->element + vtable->element_size * index;
+  }
+
+  if (table->length == cache->capacity) {
+    cache_internal_evict(cache, &internal);
+  }
+  // the table is twice the capacity, so a purge leaves at least half of the
+  // slots free and happens at most once every `end / 4` evictions
+  if (UNLIKELY(table->length + table->tombs >= table->end - table->end / 8)) {
+    table_internal_purge(table, &internal);
+  }
+
+  // evicting or purging may have freed slots earlier in the probe sequence
+  index = table_internal_find_non_full(table, &internal, hash);
+  byte *control = table_internal_control_array(table, &internal);
+  if (control[index] == TABLE_INTERNAL_CONTROL_TOMB) {
+    table->tombs -= 1;
+  }
+  table_internal_insert(table, &internal, element, hash, index);
+  table_internal_value_array(table, &internal)[index] = 1;
+  return table->element + vtable->element_size * index;
+}
+
+/***
+ * @doc(function): cache_remove
+ * @tag: all
+ *
+ * @brief: Removes the element equal to `element` and destroys it with
+ * `vtable->destroy`.
+ *
+ * @return: `true` if the element was cached
+ */
+static bool cache_remove(Cache *cache, const TableVTable *vtable,
+                         const void *element) {
+  debug_check(cache);
+  debug_check(vtable);
+  debug_check(element);
+
+  TableVTable internal;
+  cache_vtable(&internal, vtable);
+  return table_remove(&cache->table, &internal, element);
+}
+
+/***
+ * @doc(function): cache_length
+ * @tag: all
+ *
+ * @brief: Number of cached elements, at most the capacity.
+ */
+static usize cache_length(const Cache *cache) {
+  debug_check(cache);
+
+  return cache->table.length;
+}
+
+static void cache_dummy_callee__(void);
+static void cache_dummy_caller__(void) {
+  cache_init(NULL, NULL, 0, NULL, NULL);
+  cache_deinit(NULL, NULL);
+  cache_get(NULL, NULL, NULL);
+  cache_put(NULL, NULL, NULL);
+  cache_remove(NULL, NULL, NULL);
+  cache_length(NULL);
+  cache_dummy_callee__();
+}
+static void cache_dummy_callee__(void) { cache_dummy_caller__(); }
+
+#endif // CACHE_H_
@@ -0,0 +1,309 @@
+#ifndef EPOCH_H_
+#define EPOCH_H_
+
+#include <uc/allocator.h>
+#include <uc/debug_check.h>
+#include <uc/error.h>
+#include <uc/thread.h>
+#include <uc/types.h>
+#include <uc/vec.h>
+
+/***
+ * @file
+ * Epoch based memory reclamation. Requires `thread.h` and therefore
+ * `-pthread`.
+ *
+ * Readers access shared memory between `epoch_enter` and `epoch_exit`
+ * without taking any lock. Writers unlink memory from the shared structure
+ * and pass it to `epoch_retire`, which frees it once no reader which could
+ * still see it is left. Entering and exiting are wait free, they only store
+ * to the reader's own cache line.
+ *
+ * Every thread reading through an `Epoch` needs its own reader slot, which
+ * it gets from `epoch_register`.
+ */
+
+/***
+ * @doc(type): epoch_free_f
+ * @tag: all
+ *
+ * @brief: Called by the epoch on retired memory once it is safe, with the
+ * `pointer` and `ctx` given to `epoch_retire`. Has the same signature as
+ * `table_element_destroy_f`.
+ */
+typedef void (*epoch_free_f)(void *pointer, void *ctx);
+
+#define EPOCH_INTERNAL_CACHE_LINE 64
+// bit 0 of `EpochReader.state` is set while the reader is inside, the other
+// bits hold the global epoch it entered in
+#define EPOCH_INTERNAL_ACTIVE ((u64)1)
+
+typedef struct EpochReader EpochReader;
+struct EpochReader {
+  u64 state;
+  u32 registered;
+  byte padding[EPOCH_INTERNAL_CACHE_LINE - sizeof(u64) - sizeof(u32)];
+};
+
+typedef struct EpochRetired EpochRetired;
+struct EpochRetired {
+  epoch_free_f function;
+  void *pointer;
+  void *ctx;
+  u64 epoch;
+};
+
+/***
+ * @doc(type): Epoch
+ * @tag: all
+ *
+ * @brief: Reclamation domain, shared by all readers and writers of one or
+ * more data structures.
+ */
+typedef struct Epoch Epoch;
+struct Epoch {
+  u64 global;
+  EpochReader *reader;
+  usize max_readers;
+  // protects `retired` and advancing `global`
+  Mutex mutex;
+  Vec(EpochRetired) retired;
+  Allocator *allocator;
+};
+
+/***
+ * @doc(function): epoch_init
+ * @tag: all
+ *
+ * @param(max_readers): maximum number of registered readers at a time
+ * @assert(max_readers): `max_readers > 0`
+ *
+ * @param(allocator): used for the reader slots and the list of retired
+ * memory, not for the retired memory itself
+ */
+static void epoch_init(Epoch *epoch, usize max_readers, Allocator *allocator,
+                       Error *error) {
+  debug_check(epoch);
+  debug_check(max_readers > 0);
+  debug_check(allocator);
+
+  builtin_memset(epoch, 0, sizeof(*epoch));
+  epoch->allocator = allocator;
+  epoch->max_readers = max_readers;
+  epoch->reader =
+      allocator_alloc(allocator, max_readers * sizeof(*epoch->reader), error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+  builtin_memset(epoch->reader, 0, max_readers * sizeof(*epoch->reader));
+
+  vec_init(&epoch->retired, sizeof(EpochRetired), 16, allocator, error);
+  if (UNLIKELY(error && *error)) {
+    allocator_free(allocator, epoch->reader);
+    return;
+  }
+  mutex_init(&epoch->mutex);
+}
+
+static void epoch_internal_free_all(Epoch *epoch) {
+  for (usize i = 0; i < epoch->retired.length; ++i) {
+    EpochRetired *retired = &epoch->retired.element[i];
+    retired->function(retired->pointer, retired->ctx);
+  }
+  epoch->retired.length = 0;
+}
+
+/***
+ * @doc(function): epoch_deinit
+ * @tag: all
+ *
+ * @brief: Frees all memory which is still retired. No reader may be inside
+ * any more.
+ */
+static void epoch_deinit(Epoch *epoch) {
+  debug_check(epoch);
+
+  epoch_internal_free_all(epoch);
+  vec_deinit(&epoch->retired, sizeof(EpochRetired), epoch->allocator);
+  allocator_free(epoch->allocator, epoch->reader);
+  mutex_deinit(&epoch->mutex);
+}
+
+/***
+ * @doc(function): epoch_register
+ * @tag: all
+ *
+ * @brief: Claims a reader slot for the calling thread. Thread safe.
+ *
+ * @param(error): set to `EAGAIN` if all `max_readers` slots are taken
+ *
+ * @return: index of the slot, to be passed to `epoch_enter`, `epoch_exit`
+ * and `epoch_unregister`
+ */
+static usize epoch_register(Epoch *epoch, Error *error) {
+  debug_check(epoch);
+
+  for (usize i = 0; i < epoch->max_readers; ++i) {
+    u32 expected = 0;
+    if (__atomic_compare_exchange_n(&epoch->reader[i].registered, &expected,
+                                     1, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_RELAXED)) {
+      return i;
+    }
+  }
+  if (error) {
+    *error = EAGAIN;
+  }
+  return -1;
+}
+
+/***
+ * @doc(function): epoch_unregister
+ * @tag: all
+ *
+ * @brief: Releases a reader slot. The reader must not be inside.
+ */
+static void epoch_unregister(Epoch *epoch, usize reader) {
+  debug_check(epoch);
+  debug_check(reader < epoch->max_readers);
+
+  __atomic_store_n(&epoch->reader[reader].state, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&epoch->reader[reader].registered, 0, __ATOMIC_RELEASE);
+}
+
+/***
+ * @doc(function): epoch_enter
+ * @tag: all
+ *
+ * @brief: Starts a read side critical section. Memory retired after this
+ * call is not freed before the matching `epoch_exit`. Wait free.
+ */
+static void epoch_enter(Epoch *epoch, usize reader) {
+  debug_check(epoch);
+  debug_check(reader < epoch->max_readers);
+
+  const u64 global = __atomic_load_n(&epoch->global, __ATOMIC_RELAXED);
+  __atomic_store_n(&epoch->reader[reader].state,
+                   (global << 1) | EPOCH_INTERNAL_ACTIVE, __ATOMIC_RELAXED);
+  // the announcement has to be visible before any shared memory is read
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/***
+ * @doc(function): epoch_exit
+ * @tag: all
+ *
+ * @brief: Ends a read side critical section. Pointers read inside must not be
+ * used afterwards. Wait free.
+ */
+static void epoch_exit(Epoch *epoch, usize reader) {
+  debug_check(epoch);
+  debug_check(reader < epoch->max_readers);
+
+  __atomic_store_n(&epoch->reader[reader].state, 0, __ATOMIC_RELEASE);
+}
+
+// advances the global epoch if every reader inside has seen the current one
+// and frees what was retired two epochs ago. `mutex` has to be held
+static void epoch_internal_collect(Epoch *epoch) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  const u64 global = __atomic_load_n(&epoch->global, __ATOMIC_RELAXED);
+
+  bool advance = true;
+  for (usize i = 0; i < epoch->max_readers && advance; ++i) {
+    const u64 state =
+        __atomic_load_n(&epoch->reader[i].state, __ATOMIC_ACQUIRE);
+    advance = !(state & EPOCH_INTERNAL_ACTIVE) || (state >> 1) == global;
+  }
+  if (advance) {
+    __atomic_store_n(&epoch->global, global + 1, __ATOMIC_RELEASE);
+  }
+
+  // a reader inside may have entered in `global - 1` and still see memory
+  // retired in it, so only memory retired before that is freed. The list is
+  // in retirement order, which is kept
+  const u64 current = advance ? global + 1 : global;
+  usize kept = 0;
+  for (usize i = 0; i < epoch->retired.length; ++i) {
+    EpochRetired retired = epoch->retired.element[i];
+    if (retired.epoch + 2 <= current) {
+      retired.function(retired.pointer, retired.ctx);
+    } else {
+      epoch->retired.element[kept] = retired;
+      kept += 1;
+    }
+  }
+  epoch->retired.length = kept;
+}
+
+/***
+ * @doc(function): epoch_retire
+ * @tag: all
+ *
+ * @brief: Calls `function(pointer, ctx)` once no reader can access `pointer`
+ * any more. Thread safe.
+ *
+ * @detailed: `pointer` has to be unreachable for readers entering after this
+ * call. Memory is freed in the order it was retired. Each call also tries to
+ * advance the epoch and frees what became safe.
+ *
+ * @param(error): set if the retired list could not grow, in which case
+ * `pointer` is not freed
+ */
+static void epoch_retire(Epoch *epoch, epoch_free_f function, void *pointer,
+                         void *ctx, Error *error) {
+  debug_check(epoch);
+  debug_check(function);
+
+  mutex_lock(&epoch->mutex);
+  EpochRetired retired = {0};
+  retired.function = function;
+  retired.pointer = pointer;
+  retired.ctx = ctx;
+  retired.epoch = __atomic_load_n(&epoch->global, __ATOMIC_RELAXED);
+  vec_push(&epoch->retired, sizeof(EpochRetired), &retired, epoch->allocator,
+           error);
+  epoch_internal_collect(epoch);
+  mutex_unlock(&epoch->mutex);
+}
+
+/***
+ * @doc(function): epoch_collect
+ * @tag: all
+ *
+ * @brief: Tries to advance the epoch and frees retired memory which became
+ * safe. Thread safe.
+ *
+ * @return: number of retired pointers which are still pending
+ */
+static usize epoch_collect(Epoch *epoch) {
+  debug_check(epoch);
+
+  mutex_lock(&epoch->mutex);
+  epoch_internal_collect(epoch);
+  const usize pending = epoch->retired.length;
+  mutex_unlock(&epoch->mutex);
+  return pending;
+}
+
+// `epoch_free_f` releasing `pointer` through the allocator in `ctx`
+static void epoch_allocator_free(void *pointer, void *allocator) {
+  allocator_free(allocator, pointer);
+}
+
+static void epoch_dummy_callee__(void);
+static void epoch_dummy_caller__(void) {
+  epoch_init(NULL, 0, NULL, NULL);
+  epoch_deinit(NULL);
+  epoch_register(NULL, NULL);
+  epoch_unregister(NULL, 0);
+  epoch_enter(NULL, 0);
+  epoch_exit(NULL, 0);
+  epoch_retire(NULL, NULL, NULL, NULL, NULL);
+  epoch_collect(NULL);
+  epoch_allocator_free(NULL, NULL);
+  epoch_dummy_callee__();
+}
+static void epoch_dummy_callee__(void) { epoch_dummy_caller__(); }
+
+#endif // EPOCH_H_
@@ -0,0 +1,210 @@
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <uc/builtin.h>
+#include <uc/macro_util.h>
+#include <uc/types.h>
+
+#include <stddef.h>
+
+/***
+ * @file
+ * Fast non cryptographic hash functions suitable for `table.h`.
+ *
+ * All functions are based on wyhash (final version 4) by Wang Yi, released
+ * into the public domain. Every output bit depends on every input bit, so
+ * both the low bits used for the table index and the high bits used for the
+ * control byte are well distributed. The output is the same on little and big
+ * endian machines.
+ */
+
+#define HASH_INTERNAL_SECRET0 0x2d358dccaa6c78a5ull
+#define HASH_INTERNAL_SECRET1 0x8bb84b93962eacc9ull
+#define HASH_INTERNAL_SECRET2 0x4b33a62ed433d4a3ull
+#define HASH_INTERNAL_SECRET3 0x4d5a2da51de1aa47ull
+
+// 64x64 -> 128 bit multiplication, `*a` receives the low and `*b` the high
+// half of the product
+static void hash_internal_mum(u64 *a, u64 *b) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 u128;
+  const u128 r = (u128)*a * *b;
+  *a = (u64)r;
+  *b = (u64)(r >> 64);
+#else
+  const u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+  const u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const u64 t = rl + (rm0 << 32);
+  u64 c = t < rl;
+  const u64 lo = t + (rm1 << 32);
+  c += lo < t;
+  const u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  *a = lo;
+  *b = hi;
+#endif
+}
+
+static u64 hash_internal_mix(u64 a, u64 b) {
+  hash_internal_mum(&a, &b);
+  return a ^ b;
+}
+
+static u64 hash_internal_read8(const byte *p) {
+  u64 v;
+  builtin_memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = builtin_bswap64(v);
+#endif
+  return v;
+}
+
+static u64 hash_internal_read4(const byte *p) {
+  u32 v;
+  builtin_memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  v = builtin_bswap32(v);
+#endif
+  return v;
+}
+
+// reads 1 to 3 bytes
+static u64 hash_internal_read3(const byte *p, usize length) {
+  return ((u64)p[0] << 16) | ((u64)p[length >> 1] << 8) | p[length - 1];
+}
+
+/***
+ * @doc(function): hash_bytes
+ * @tag: all
+ *
+ * @brief: Hashes `length` bytes starting at `data`.
+ *
+ * @param(data): bytes which are to be hashed
+ * @assert(data): `data != NULL || length == 0`
+ *
+ * @param(length): number of bytes
+ *
+ * @param(seed): seed of the hash, different seeds give unrelated hashes
+ *
+ * @return: 64 bit hash
+ */
+static u64 hash_bytes(const void *data, usize length, u64 seed) {
+  const byte *p = data;
+  seed ^=
+      hash_internal_mix(seed ^ HASH_INTERNAL_SECRET0, HASH_INTERNAL_SECRET1);
+
+  u64 a;
+  u64 b;
+  if (LIKELY(length <= 16)) {
+    if (LIKELY(length >= 4)) {
+      const usize offset = (length >> 3) << 2;
+      a = (hash_internal_read4(p) << 32) | hash_internal_read4(p + offset);
+      b = (hash_internal_read4(p + length - 4) << 32) |
+          hash_internal_read4(p + length - 4 - offset);
+    } else if (LIKELY(length > 0)) {
+      a = hash_internal_read3(p, length);
+      b = 0;
+    } else {
+      a = 0;
+      b = 0;
+    }
+  } else {
+    usize i = length;
+    if (UNLIKELY(i >= 48)) {
+      u64 see1 = seed;
+      u64 see2 = seed;
+      do {
+        seed = hash_internal_mix(hash_internal_read8(p) ^ HASH_INTERNAL_SECRET1,
+                                 hash_internal_read8(p + 8) ^ seed);
+        see1 = hash_internal_mix(hash_internal_read8(p + 16) ^
+                                     HASH_INTERNAL_SECRET2,
+                                 hash_internal_read8(p + 24) ^ see1);
+        see2 = hash_internal_mix(hash_internal_read8(p + 32) ^
+                                     HASH_INTERNAL_SECRET3,
+                                 hash_internal_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (LIKELY(i >= 48));
+      seed ^= see1 ^ see2;
+    }
+    while (UNLIKELY(i > 16)) {
+      seed = hash_internal_mix(hash_internal_read8(p) ^ HASH_INTERNAL_SECRET1,
+                               hash_internal_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = hash_internal_read8(p + i - 16);
+    b = hash_internal_read8(p + i - 8);
+  }
+
+  a ^= HASH_INTERNAL_SECRET1;
+  b ^= seed;
+  hash_internal_mum(&a, &b);
+  return hash_internal_mix(a ^ HASH_INTERNAL_SECRET0 ^ length,
+                           b ^ HASH_INTERNAL_SECRET1);
+}
+
+/***
+ * @doc(function): hash_string
+ * @tag: all
+ *
+ * @brief: Hashes a null terminated string, equivalent to
+ * `hash_bytes(string, strlen(string), seed)`.
+ *
+ * @param(string): null terminated string
+ * @assert(string): `string != NULL`
+ */
+static u64 hash_string(const char *string, u64 seed) {
+  usize length = 0;
+  while (string[length]) {
+    length += 1;
+  }
+  return hash_bytes(string, length, seed);
+}
+
+/***
+ * @doc(function): hash_u64
+ * @tag: all
+ *
+ * @brief: Hashes a single 64 bit integer. Much faster than `hash_bytes` on
+ * the integer as it needs only two multiplications.
+ */
+static u64 hash_u64(u64 value) {
+  u64 a = value ^ HASH_INTERNAL_SECRET0;
+  u64 b = HASH_INTERNAL_SECRET1;
+  hash_internal_mum(&a, &b);
+  return hash_internal_mix(a ^ HASH_INTERNAL_SECRET0,
+                           b ^ HASH_INTERNAL_SECRET1);
+}
+
+/***
+ * @doc(function): hash_u32
+ * @tag: all
+ *
+ * @brief: Hashes a single 32 bit integer, see `hash_u64`.
+ */
+static u64 hash_u32(u32 value) { return hash_u64(value); }
+
+/***
+ * @doc(function): hash_combine
+ * @tag: all
+ *
+ * @brief: Combines two hashes into one, useful for hashing structs member
+ * by member.
+ */
+static u64 hash_combine(u64 first, u64 second) {
+  return hash_internal_mix(first ^ HASH_INTERNAL_SECRET2,
+                           second ^ HASH_INTERNAL_SECRET3);
+}
+
+static void hash_dummy_callee__(void);
+static void hash_dummy_caller__(void) {
+  hash_bytes(NULL, 0, 0);
+  hash_string(NULL, 0);
+  hash_u64(0);
+  hash_u32(0);
+  hash_combine(0, 0);
+  hash_dummy_callee__();
+}
+static void hash_dummy_callee__(void) { hash_dummy_caller__(); }
+
+#endif // HASH_H_
@@ -5,9 +5,12 @@
 #include <uc/builtin.h>
 #include <uc/debug_check.h>
 #include <uc/error.h>
+#include <uc/table_group.h>
 #include <uc/types.h>
 
-#include <emmintrin.h>
+#ifdef TABLE_STATS
+#include <time.h>
+#endif
 
 /***
  * @doc(type): table_element_insert_f
@@ -122,6 +125,53 @@ typedef bool (*table_element_compare_f)(const void *first, const void *second,
  */
 typedef u64 (*table_element_hash_f)(const void *element, void *ctx);
 
+// number of buckets of `TableStats.probe_groups`
+#define TABLE_STATS_PROBE_BUCKETS 16
+
+/***
+ * @doc(type): TableStats
+ * @tag: all
+ *
+ * @brief: Counters collected by a table if `TABLE_STATS` is defined, see
+ * `TableVTable.stats` and `table_stats` in `table_stats.h`.
+ *
+ * @detailed: Without `TABLE_STATS` nothing is counted and the instrumentation
+ * compiles to nothing. The counters are updated with relaxed atomics, so a
+ * `TableStats` may be shared by tables used from different threads. Zero
+ * initialize it before use.
+ *
+ * @member(finds): number of probes for an element, one per lookup, insert and
+ * remove
+ *
+ * @member(probe_groups): `probe_groups[i]` counts the finds which visited
+ * `i + 1` groups, the last bucket also counts all longer finds
+ *
+ * @member(tag_matches): slots whose control byte matched the tag of the
+ * element which was looked for
+ *
+ * @member(false_positives): tag matches which were not the element
+ *
+ * @member(compares): calls of `vtable->compare` during finds
+ *
+ * @member(resizes): number of times a new element array was allocated
+ *
+ * @member(purges): number of in place tomb purges
+ *
+ * @member(rehash_clocks): processor time in `clock()` ticks spent moving
+ * elements during resizes, incremental migrations and purges
+ */
+typedef struct TableStats TableStats;
+struct TableStats {
+  u64 finds;
+  u64 probe_groups[TABLE_STATS_PROBE_BUCKETS];
+  u64 tag_matches;
+  u64 false_positives;
+  u64 compares;
+  u64 resizes;
+  u64 purges;
+  u64 rehash_clocks;
+};
+
 /***
  * @doc(type): TableVTable
  * @tag: all
@@ -140,7 +190,10 @@ typedef u64 (*table_element_hash_f)(const void *element, void *ctx);
  * which case no destructor will be called. This will make `table_deinit`
  * significantly faster
  *
- * @member(hash): callback for hashing elements
+ * @member(hash): callback for hashing elements. The low bits of the hash pick
+ * the starting slot and the highest 7 bits are stored in the control byte, so
+ * both ends of the hash have to be well distributed. `hash.h` provides
+ * suitable hash functions.
  * @assert(hash): `hash != NULL`
  *
  * @member(insert): callback for inserting elements into the table. Can be
@@ -155,6 +208,28 @@ typedef u64 (*table_element_hash_f)(const void *element, void *ctx);
  * @assert(overwrite): `overwrite != NULL`
  *
  * @member(ctx): context pointer passed to each callback. May be `NULL`.
+ *
+ * @member(migrate_groups): if `0` the table grows by rehashing every element
+ * in a single call. Otherwise growing is incremental: the old and the new
+ * element arrays coexist and each `table_insert` and `table_upsert` migrates
+ * `migrate_groups` groups of `TABLE_GROUP_WIDTH` slots into the new array
+ * until the old one is empty. This bounds the worst case latency of a single
+ * insert.
+ *
+ * @member(store_hash): if `true` the table keeps the hash of each element in
+ * a side array. Resizing and purging never call `hash` and `compare` is only
+ * called if the stored hash matches. Costs 8 extra bytes per slot, worth it
+ * for expensive hashes or compares like strings.
+ *
+ * @member(stats): counters which are updated if `TABLE_STATS` is defined. May
+ * be `NULL`, it is ignored otherwise.
+ *
+ * @member(value_size): if not `0` every slot also has a value of `value_size`
+ * bytes, which is kept in a separate array parallel to the elements. The
+ * elements then only hold the keys, so probing and `compare` never touch the
+ * values and a lookup loads its value only on a hit. Values are accessed with
+ * `table_value`, they are moved bitwise and never constructed or destroyed by
+ * the table. Worth it if values are large compared to keys.
  */
 typedef struct TableVTable TableVTable;
 struct TableVTable {
@@ -165,6 +240,10 @@ struct TableVTable {
   table_element_overwrite_f overwrite;
   usize element_size;
   void *ctx;
+  usize migrate_groups;
+  bool store_hash;
+  TableStats *stats;
+  usize value_size;
 };
 
 /**
@@ -184,6 +263,11 @@ typedef void Table;
  *
  * @brief struct type for a table with elements of type `TYPE`
  *
+ * @detailed: `old_element`, `old_end` and `migrated` are only used while an
+ * incremental resize is in progress (see `TableVTable.migrate_groups`). During
+ * that time slot indices `>= end` refer to slot `index - end` of the old
+ * array, use `table_get` to access elements by index.
+ *
  * @param(TYPE)
  */
 #define Table(TYPE)                                                            \
@@ -192,6 +276,9 @@ typedef void Table;
     usize length;                                                              \
     usize end;                                                                 \
     usize tombs;                                                               \
+    TYPE *old_element;                                                         \
+    usize old_end;                                                             \
+    usize migrated;                                                            \
   }
 
 // TODO: documentation
@@ -199,18 +286,81 @@ typedef void Table;
 #define TABLE_INTERNAL_CONTROL_TOMB ((u8)1)
 #define TABLE_INTERNAL_CONTROL_FREE ((u8)0)
 
-// TODO: documentation
+// expands to its arguments only if `TABLE_STATS` is defined
+#ifdef TABLE_STATS
+#define TABLE_INTERNAL_STATS(...) __VA_ARGS__
+#else
+#define TABLE_INTERNAL_STATS(...)
+#endif
+
+#ifdef TABLE_STATS
+static void table_internal_stats_add(u64 *counter, u64 value) {
+  (void)__atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+// records a finished find which visited `groups` groups
+static void table_internal_stats_find(const TableVTable *vtable, usize groups,
+                                      usize tag_matches, usize compares,
+                                      bool found) {
+  TableStats *stats = vtable->stats;
+  if (!stats) {
+    return;
+  }
+  const usize bucket = groups < TABLE_STATS_PROBE_BUCKETS
+                           ? groups - 1
+                           : TABLE_STATS_PROBE_BUCKETS - 1;
+  table_internal_stats_add(&stats->finds, 1);
+  table_internal_stats_add(&stats->probe_groups[bucket], 1);
+  table_internal_stats_add(&stats->tag_matches, tag_matches);
+  table_internal_stats_add(&stats->false_positives, tag_matches - found);
+  table_internal_stats_add(&stats->compares, compares);
+}
+
+// records a resize or purge which started at `start`
+static void table_internal_stats_rehash(const TableVTable *vtable,
+                                        clock_t start, u64 resizes,
+                                        u64 purges) {
+  TableStats *stats = vtable->stats;
+  if (!stats) {
+    return;
+  }
+  table_internal_stats_add(&stats->resizes, resizes);
+  table_internal_stats_add(&stats->purges, purges);
+  table_internal_stats_add(&stats->rehash_clocks, (u64)(clock() - start));
+}
+#endif
+
+// the control byte stores the top 7 bits of the hash while the index uses the
+// low bits, so a tag match says something the index does not already imply
 static u8 table_internal_hash_to_control_byte(u64 hash) {
-  return (hash & 255) | TABLE_INTERNAL_CONTROL_ISSET_MASK;
+  return (u8)(hash >> 57) | TABLE_INTERNAL_CONTROL_ISSET_MASK;
 }
 
+#define TABLE_INTERNAL_MIN_END (TABLE_GROUP_WIDTH > 16 ? TABLE_GROUP_WIDTH : 16)
+
 // TODO: documentation
 static usize table_internal_end_from_capacity(usize capacity) {
   debug_check(capacity > 0);
   capacity *= 8;
   capacity /= 7;
-  return 1 << (8 * sizeof(unsigned long long) -
-               builtin_clzll((unsigned long long)capacity));
+  const usize end = (usize)1 << (8 * sizeof(unsigned long long) -
+                                 builtin_clzll((unsigned long long)capacity));
+  // a table consists of at least one group and at least 16 slots, which keeps
+  // the stored hashes aligned
+  return end < TABLE_INTERNAL_MIN_END ? TABLE_INTERNAL_MIN_END : end;
+}
+
+// returns the array of stored hashes, which lies between the elements and
+// the control bytes. Only valid if `vtable->store_hash`
+static u64 *table_internal_hash_array(const Table *table_,
+                                      const TableVTable *vtable) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(vtable->store_hash);
+
+  // `end >= 16` and a power of two, so the array is always 16 byte aligned
+  const Table(byte) *table = table_;
+  return (u64 *)(table->element + vtable->element_size * table->end);
 }
 
 // TODO: documentation
@@ -221,7 +371,150 @@ static byte *table_internal_control_array(const Table *table_,
   debug_check(vtable);
 
   const Table(byte) *table = table_;
-  return table->element + vtable->element_size * table->end;
+  usize offset = vtable->element_size * table->end;
+  if (vtable->store_hash) {
+    offset += sizeof(u64) * table->end;
+  }
+  return table->element + offset;
+}
+
+// offset of the value array from the start of the chunk of a table with `end`
+// slots, it follows the control bytes and is 16 byte aligned
+static usize table_internal_value_offset(const TableVTable *vtable, usize end) {
+  debug_check(vtable);
+
+  usize offset = vtable->element_size * end + end + TABLE_GROUP_WIDTH;
+  if (vtable->store_hash) {
+    offset += sizeof(u64) * end;
+  }
+  return (offset + 15) & ~(usize)15;
+}
+
+// returns the array of values. Only valid if `vtable->value_size`
+static byte *table_internal_value_array(const Table *table_,
+                                        const TableVTable *vtable) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(vtable->value_size);
+
+  const Table(byte) *table = table_;
+  return table->element + table_internal_value_offset(vtable, table->end);
+}
+
+// hash of the element in slot `index`, read from the side array if possible
+static u64 table_internal_slot_hash(const Table *table_,
+                                    const TableVTable *vtable, usize index) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  const Table(byte) *table = table_;
+  debug_check(table->end > index);
+
+  if (vtable->store_hash) {
+    return table_internal_hash_array(table, vtable)[index];
+  }
+  return vtable->hash(table->element + vtable->element_size * index,
+                      vtable->ctx);
+}
+
+// moves the element in slot `src_index` of `src` into slot `dest_index` of
+// `dest`, including its stored hash and value. Control bytes are left
+// untouched
+static void table_internal_move_slot(Table *dest_, usize dest_index,
+                                     const Table *src_, usize src_index,
+                                     const TableVTable *vtable) {
+  debug_check(dest_);
+  debug_check(src_);
+  debug_check(vtable);
+
+  Table(byte) *dest = dest_;
+  const Table(byte) *src = src_;
+  builtin_memcpy(dest->element + vtable->element_size * dest_index,
+                 src->element + vtable->element_size * src_index,
+                 vtable->element_size);
+  if (vtable->store_hash) {
+    table_internal_hash_array(dest, vtable)[dest_index] =
+        table_internal_hash_array(src, vtable)[src_index];
+  }
+  if (vtable->value_size) {
+    builtin_memcpy(table_internal_value_array(dest, vtable) +
+                       vtable->value_size * dest_index,
+                   table_internal_value_array(src, vtable) +
+                       vtable->value_size * src_index,
+                   vtable->value_size);
+  }
+}
+
+// sets the control byte at `index` and keeps the mirrored bytes after `end` in
+// sync, which allow groups to be loaded without wrapping around
+static void table_internal_set_control(byte *control, usize end, usize index,
+                                       u8 value) {
+  debug_check(control);
+  debug_check(end > index);
+
+  control[index] = value;
+  if (index < TABLE_GROUP_WIDTH) {
+    control[index + end] = value;
+  }
+}
+
+// returns the first slot in the probe sequence of `hash` which is not set
+static usize table_internal_control_find_non_full(const byte *control,
+                                                  usize mask, u64 hash) {
+  debug_check(control);
+
+  usize index = hash & mask;
+  while (1) {
+    const TableGroupMask non_full = table_group_match_non_full(control + index);
+    if (LIKELY(non_full)) {
+      return (index + table_group_mask_lowest(non_full)) & mask;
+    }
+    index += TABLE_GROUP_WIDTH;
+    index &= mask;
+  }
+}
+
+// clears the set slot at `index`. The slot is marked as free if the run of
+// non free slots around it is shorter than a group, as no probe sequence can
+// ever have continued past it. Otherwise a tomb is needed, in which case
+// `true` is returned
+static bool table_internal_control_erase(byte *control, usize end,
+                                         usize index) {
+  debug_check(control);
+  debug_check(end > index);
+
+  const usize mask = end - 1;
+  const TableGroupMask free_before =
+      table_group_match_free(control + ((index - TABLE_GROUP_WIDTH) & mask));
+  const TableGroupMask free_after = table_group_match_free(control + index);
+
+  if (free_before && free_after &&
+      table_group_mask_lowest(free_after) +
+              table_group_mask_leading(free_before) <
+          TABLE_GROUP_WIDTH) {
+    table_internal_set_control(control, end, index,
+                               TABLE_INTERNAL_CONTROL_FREE);
+    return false;
+  }
+  table_internal_set_control(control, end, index, TABLE_INTERNAL_CONTROL_TOMB);
+  return true;
+}
+
+// size of the single allocation holding the elements, stored hashes, control
+// bytes and values of a table with `end` slots
+static usize table_internal_chunk_size(const TableVTable *vtable, usize end) {
+  debug_check(vtable);
+
+  usize chunk_size = vtable->element_size * end;
+  chunk_size += end + TABLE_GROUP_WIDTH;
+  if (vtable->store_hash) {
+    chunk_size += sizeof(u64) * end;
+  }
+  if (vtable->value_size) {
+    chunk_size = table_internal_value_offset(vtable, end) +
+                 vtable->value_size * end;
+  }
+  return chunk_size;
 }
 
 // TODO: documentation
@@ -232,6 +525,9 @@ static void table_deinit(Table *table_, Allocator *allocator) {
 
   Table(byte) *table = table_;
   allocator_free(allocator, table->element);
+  if (table->old_element) {
+    allocator_free(allocator, table->old_element);
+  }
 }
 
 // TODO: documentation
@@ -247,100 +543,290 @@ static void table_internal_init(Table *table_, const TableVTable *vtable,
   builtin_memset(table, 0, sizeof(*table));
   table->end = end;
 
-  usize chunk_size = vtable->element_size * table->end;
-  chunk_size += table->end + 16;
-
-  table->element = allocator_alloc(allocator, chunk_size, error);
+  table->element = allocator_alloc(
+      allocator, table_internal_chunk_size(vtable, table->end), error);
   if (UNLIKELY(error && *error)) {
     return;
   }
 
   byte *control = table_internal_control_array(table, vtable);
-  builtin_memset(control, TABLE_INTERNAL_CONTROL_FREE, 16 + table->end);
+  builtin_memset(control, TABLE_INTERNAL_CONTROL_FREE,
+                 TABLE_GROUP_WIDTH + table->end);
 }
 
 static void table_init(Table *table, const TableVTable *vtable,
                        usize initial_capacity, Allocator *allocator,
                        Error *error) {
-  // TODO: this way if end wil always be over 16 this should not be the case if
-  // initial capacity can be satisfied with end == 16
-  if (initial_capacity < 16) {
-    initial_capacity = 16;
-  }
-  usize end = table_internal_end_from_capacity(initial_capacity);
+  // small capacities get the smallest table, which is a single group on SIMD
+  // targets, see `table_small.h`
+  usize end = table_internal_end_from_capacity(
+      initial_capacity ? initial_capacity : 1);
   table_internal_init(table, vtable, end, allocator, error);
 }
 
-static usize table_internal_find(const Table *table_, const TableVTable *vtable,
-                                 const void *element, u64 hash) {
+// probes for the slot whose element `compare` reports equal to `element`, or
+// the first free slot of the probe sequence
+static usize table_internal_find_compare(const Table *table_,
+                                         const TableVTable *vtable,
+                                         const void *element, u64 hash,
+                                         table_element_compare_f compare) {
   // TODO: quadratic probing
   debug_check(table_);
   debug_check(vtable);
   debug_check(element);
+  debug_check(compare);
 
   const Table(byte) *table = table_;
   const usize mask = table->end - 1;
   usize index = hash & mask;
-  const __m128i control_mask =
-      _mm_set1_epi8(table_internal_hash_to_control_byte(hash));
-  const __m128i zero = _mm_set1_epi8(0);
+  const u8 control_byte = table_internal_hash_to_control_byte(hash);
   const byte *control = table_internal_control_array(table, vtable);
+  TABLE_INTERNAL_STATS(usize stats_groups = 1; usize stats_tag_matches = 0;
+                       usize stats_compares = 0;)
 
   while (1) {
-    const __m128i control_data =
-        _mm_loadu_si128((const __m128i_u *)(control + index));
-    usize poss_bitmask =
-        _mm_movemask_epi8(_mm_cmpeq_epi8(control_mask, control_data));
-
-    if (LIKELY(poss_bitmask)) {
-      usize group_index = 0;
-      do {
-        usize ctz = builtin_ctz(poss_bitmask);
-        group_index += ctz;
-        poss_bitmask >>= ctz;
-
-        usize real_index = (index + group_index) & mask;
-
-        if (vtable->compare(element,
-                            &table->element[vtable->element_size * real_index],
-                            vtable->ctx)) {
+    TableGroupMask poss_bitmask =
+        table_group_match(control + index, control_byte);
+    while (poss_bitmask) {
+      const usize real_index =
+          (index + table_group_mask_lowest(poss_bitmask)) & mask;
+      TABLE_INTERNAL_STATS(stats_tag_matches += 1;)
+
+      if (!vtable->store_hash ||
+          table_internal_hash_array(table, vtable)[real_index] == hash) {
+        TABLE_INTERNAL_STATS(stats_compares += 1;)
+        if (compare(element,
+                    &table->element[vtable->element_size * real_index],
+                    vtable->ctx)) {
+          TABLE_INTERNAL_STATS(table_internal_stats_find(
+              vtable, stats_groups, stats_tag_matches, stats_compares, true);)
           return real_index;
         }
-        group_index += 1;
-        poss_bitmask >>= 1;
-      } while (poss_bitmask);
+      }
+      poss_bitmask = table_group_mask_clear_lowest(poss_bitmask);
     }
 
-    usize empty_bitmask = _mm_movemask_epi8(_mm_cmpeq_epi8(zero, control_data));
+    const TableGroupMask empty_bitmask =
+        table_group_match_free(control + index);
     if (LIKELY(empty_bitmask)) {
-      return (index + builtin_ctz(empty_bitmask)) & mask;
+      TABLE_INTERNAL_STATS(table_internal_stats_find(
+          vtable, stats_groups, stats_tag_matches, stats_compares, false);)
+      return (index + table_group_mask_lowest(empty_bitmask)) & mask;
     }
-    index += 16;
+    TABLE_INTERNAL_STATS(stats_groups += 1;)
+    index += TABLE_GROUP_WIDTH;
     index &= mask;
   }
 }
 
+// returns the first slot in the probe sequence of `hash` which is not set.
+// Only usable if the element is known not to be in the table
+static usize table_internal_find_non_full(const Table *table_,
+                                          const TableVTable *vtable, u64 hash) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  const Table(byte) *table = table_;
+  return table_internal_control_find_non_full(
+      table_internal_control_array(table, vtable), table->end - 1, hash);
+}
+
+// like `table_internal_find_compare` but also searches the old array while an
+// incremental resize is in progress. Hits in the old array are returned as
+// `end + index`
+static usize table_internal_lookup_compare(const Table *table_,
+                                           const TableVTable *vtable,
+                                           const void *element, u64 hash,
+                                           table_element_compare_f compare) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(element);
+
+  const Table(byte) *table = table_;
+  const usize index =
+      table_internal_find_compare(table, vtable, element, hash, compare);
+  if (LIKELY(!table->old_element)) {
+    return index;
+  }
+  if (table_internal_control_array(table, vtable)[index] &
+      TABLE_INTERNAL_CONTROL_ISSET_MASK) {
+    return index;
+  }
+
+  Table(byte) old = {0};
+  old.element = table->old_element;
+  old.end = table->old_end;
+  const usize old_index =
+      table_internal_find_compare(&old, vtable, element, hash, compare);
+  if (table_internal_control_array(&old, vtable)[old_index] &
+      TABLE_INTERNAL_CONTROL_ISSET_MASK) {
+    return table->end + old_index;
+  }
+  return index;
+}
+
+static usize table_internal_lookup(const Table *table_,
+                                   const TableVTable *vtable,
+                                   const void *element, u64 hash) {
+  return table_internal_lookup_compare(table_, vtable, element, hash,
+                                       vtable->compare);
+}
+
 static usize table_find(const Table *table, const TableVTable *vtable,
                         const void *element) {
   debug_check(table);
   debug_check(vtable);
   debug_check(element);
 
-  return table_internal_find(table, vtable, element,
-                             vtable->hash(element, vtable->ctx));
+  return table_internal_lookup(table, vtable, element,
+                               vtable->hash(element, vtable->ctx));
 }
 
-static bool table_isset(const Table *table, const TableVTable *vtable,
-                        usize index) {
+/***
+ * @doc(function): table_find_hashed
+ * @tag: all
+ *
+ * @brief: Like `table_find` but with the hash of `element` supplied by the
+ * caller, e.g. because an earlier stage already computed it.
+ *
+ * @param(hash): has to be `vtable->hash(element, vtable->ctx)`, otherwise the
+ * element is not found
+ */
+static usize table_find_hashed(const Table *table, const TableVTable *vtable,
+                               const void *element, u64 hash) {
   debug_check(table);
   debug_check(vtable);
-  debug_check(((Table(byte) *)table)->end > index);
+  debug_check(element);
+
+  return table_internal_lookup(table, vtable, element, hash);
+}
 
-  return table_internal_control_array(table, vtable)[index] &
+/***
+ * @doc(function): table_find_key
+ * @tag: all
+ *
+ * @brief: Looks up an element by a key of a different type than the
+ * elements.
+ *
+ * @detailed: Returns the slot of the element for which `compare(key,
+ * element, vtable->ctx)` is `true` like `table_find` does. No temporary
+ * element has to be built and `key` is not hashed by the table, so for
+ * example a string slice can be looked up in a table of owned strings.
+ *
+ * @param(key): passed as the first argument of `compare`
+ * @assert(key): `key != NULL`
+ *
+ * @param(hash): hash of `key`, has to be equal to the hash `vtable->hash`
+ * computes for the element it matches
+ *
+ * @param(compare): called with `key` and a stored element
+ * @assert(compare): `compare != NULL`
+ *
+ * @example:
+ * ```c
+ * Slice slice = {.data = "key", .length = 3};
+ * usize index = table_find_key(&table, &vtable, &slice,
+ *                              hash_bytes(slice.data, slice.length, 0),
+ *                              slice_compare_string);
+ * ```
+ */
+static usize table_find_key(const Table *table, const TableVTable *vtable,
+                            const void *key, u64 hash,
+                            table_element_compare_f compare) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(key);
+  debug_check(compare);
+
+  return table_internal_lookup_compare(table, vtable, key, hash, compare);
+}
+
+static bool table_isset(const Table *table_, const TableVTable *vtable,
+                        usize index) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  const Table(byte) *table = table_;
+  debug_check(table->end + table->old_end > index);
+
+  if (LIKELY(index < table->end)) {
+    return table_internal_control_array(table, vtable)[index] &
+           TABLE_INTERNAL_CONTROL_ISSET_MASK;
+  }
+
+  Table(byte) old = {0};
+  old.element = table->old_element;
+  old.end = table->old_end;
+  return table_internal_control_array(&old, vtable)[index - table->end] &
          TABLE_INTERNAL_CONTROL_ISSET_MASK;
 }
 
-// TODO: table_remove
+/***
+ * @doc(function): table_get
+ * @tag: all
+ *
+ * @brief: Returns a pointer to the element in slot `index`.
+ *
+ * @detailed: Equivalent to `&table->element[index]` unless an incremental
+ * resize is in progress, in which case indices `>= end` are mapped to the old
+ * element array.
+ *
+ * @param(index): slot index as returned by `table_find`, `table_insert` or
+ * `table_upsert`
+ * @assert(index): `index < table->end + table->old_end`
+ */
+static void *table_get(const Table *table_, const TableVTable *vtable,
+                       usize index) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  const Table(byte) *table = table_;
+  debug_check(table->end + table->old_end > index);
+
+  if (LIKELY(index < table->end)) {
+    return table->element + vtable->element_size * index;
+  }
+  return table->old_element + vtable->element_size * (index - table->end);
+}
+
+/***
+ * @doc(function): table_value
+ * @tag: all
+ *
+ * @brief: Returns a pointer to the value of slot `index`.
+ *
+ * @detailed: Only available if `vtable->value_size` is set. The value of a
+ * newly inserted element is uninitialized until it is written through this
+ * pointer. Like `table_get` it maps indices `>= end` to the old array during
+ * an incremental resize, and the pointer is invalidated by any insertion.
+ *
+ * @param(index): slot index as returned by `table_find`, `table_insert` or
+ * `table_upsert`
+ * @assert(index): `index < table->end + table->old_end`
+ *
+ * @example:
+ * ```c
+ * const usize index = table_upsert(&table, &vtable, &key, allocator, NULL);
+ * builtin_memcpy(table_value(&table, &vtable, index), &value, sizeof(value));
+ * ```
+ */
+static void *table_value(const Table *table_, const TableVTable *vtable,
+                         usize index) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(vtable->value_size);
+
+  const Table(byte) *table = table_;
+  debug_check(table->end + table->old_end > index);
+
+  if (LIKELY(index < table->end)) {
+    return table_internal_value_array(table, vtable) +
+           vtable->value_size * index;
+  }
+  return table->old_element +
+         table_internal_value_offset(vtable, table->old_end) +
+         vtable->value_size * (index - table->end);
+}
 
 static bool table_contains(const Table *table_, const TableVTable *vtable,
                            const void *element) {
@@ -352,6 +838,292 @@ static bool table_contains(const Table *table_, const TableVTable *vtable,
   return table_isset(table_, vtable, index);
 }
 
+// number of lookups which are kept in flight by `table_find_many`
+#define TABLE_INTERNAL_BATCH 16
+
+// resolves up to `TABLE_INTERNAL_BATCH` lookups in three stages: hash every
+// element and prefetch its first control group, match the tags of each group
+// and prefetch the first candidate slot, and finally probe with
+// `table_internal_lookup` which by now should mostly hit the cache
+static void table_internal_find_batch(const Table *table_,
+                                      const TableVTable *vtable,
+                                      const byte *elements, usize count,
+                                      usize *indices) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(elements);
+  debug_check(count <= TABLE_INTERNAL_BATCH);
+  debug_check(indices);
+
+  const Table(byte) *table = table_;
+  const usize mask = table->end - 1;
+  const byte *control = table_internal_control_array(table, vtable);
+  u64 hash[TABLE_INTERNAL_BATCH];
+
+  for (usize i = 0; i < count; ++i) {
+    hash[i] = vtable->hash(elements + i * vtable->element_size, vtable->ctx);
+    builtin_prefetch(control + (hash[i] & mask));
+  }
+
+  for (usize i = 0; i < count; ++i) {
+    const usize index = hash[i] & mask;
+    const TableGroupMask poss_bitmask = table_group_match(
+        control + index, table_internal_hash_to_control_byte(hash[i]));
+    if (poss_bitmask) {
+      const usize real_index =
+          (index + table_group_mask_lowest(poss_bitmask)) & mask;
+      builtin_prefetch(table->element + vtable->element_size * real_index);
+    }
+  }
+
+  for (usize i = 0; i < count; ++i) {
+    indices[i] = table_internal_lookup(
+        table, vtable, elements + i * vtable->element_size, hash[i]);
+  }
+}
+
+/***
+ * @doc(function): table_find_many
+ * @tag: all
+ *
+ * @brief: Batched version of `table_find`.
+ *
+ * @detailed: Looks up `count` elements and writes the resulting slot indices
+ * into `indices`, `indices[i]` is the same value `table_find` would return
+ * for the `i`th element. Lookups are processed in batches whose cache misses
+ * are overlapped by prefetching, which makes this a lot faster than calling
+ * `table_find` in a loop on tables which do not fit into the cache.
+ *
+ * @param(elements): contiguous array of `count` elements each
+ * `vtable->element_size` bytes big
+ * @assert(elements): `elements != NULL`
+ *
+ * @param(indices): array of at least `count` indices
+ * @assert(indices): `indices != NULL`
+ */
+static void table_find_many(const Table *table, const TableVTable *vtable,
+                            const void *elements, usize count,
+                            usize *indices) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(elements || !count);
+  debug_check(indices || !count);
+
+  const byte *element = elements;
+  for (usize i = 0; i < count; i += TABLE_INTERNAL_BATCH) {
+    const usize batch =
+        count - i < TABLE_INTERNAL_BATCH ? count - i : TABLE_INTERNAL_BATCH;
+    table_internal_find_batch(table, vtable,
+                              element + i * vtable->element_size, batch,
+                              indices + i);
+  }
+}
+
+/***
+ * @doc(function): table_contains_many
+ * @tag: all
+ *
+ * @brief: Batched version of `table_contains`.
+ *
+ * @detailed: Sets `contains[i]` to whether the `i`th element of `elements` is
+ * present in the table. See `table_find_many`.
+ *
+ * @param(contains): array of at least `count` bools
+ * @assert(contains): `contains != NULL`
+ */
+static void table_contains_many(const Table *table, const TableVTable *vtable,
+                                const void *elements, usize count,
+                                bool *contains) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(elements || !count);
+  debug_check(contains || !count);
+
+  const byte *element = elements;
+  usize indices[TABLE_INTERNAL_BATCH];
+  for (usize i = 0; i < count; i += TABLE_INTERNAL_BATCH) {
+    const usize batch =
+        count - i < TABLE_INTERNAL_BATCH ? count - i : TABLE_INTERNAL_BATCH;
+    table_internal_find_batch(table, vtable,
+                              element + i * vtable->element_size, batch,
+                              indices);
+    for (usize j = 0; j < batch; ++j) {
+      contains[i + j] = table_isset(table, vtable, indices[j]);
+    }
+  }
+}
+
+/***
+ * @doc(type): TableIter
+ * @tag: all
+ *
+ * @brief: Cursor over the set slots of a table, see `table_next`.
+ *
+ * @detailed: Has to be zero initialized before the first call to
+ * `table_next`.
+ *
+ * @member(index): slot of the current element, valid after `table_next`
+ * returned `true`. Use `table_get` to access the element.
+ */
+typedef struct TableIter TableIter;
+struct TableIter {
+  usize index;
+  usize next_group;
+  TableGroupMask mask;
+};
+
+/***
+ * @doc(function): table_next
+ * @tag: all
+ *
+ * @brief: Advances `iter` to the next set slot.
+ *
+ * @detailed: Scans the control bytes a whole group at a time and only visits
+ * set slots, so sparse tables are iterated about as fast as their control
+ * bytes can be read. During an incremental resize the elements which are
+ * still in the old array are visited as well, with indices `>= end` as
+ * returned by `table_find`. The order is unspecified.
+ *
+ * The current element may be removed with `table_remove` while iterating.
+ * Any insertion or resize invalidates the iterator.
+ *
+ * @param(iter): zero initialized or previously advanced iterator
+ * @assert(iter): `iter != NULL`
+ *
+ * @return: `false` once all set slots have been visited
+ *
+ * @example:
+ * ```c
+ * TableIter iter = {0};
+ * while (table_next(&table, &vtable, &iter)) {
+ *   int *element = table_get(&table, &vtable, iter.index);
+ * }
+ * ```
+ */
+static bool table_next(const Table *table_, const TableVTable *vtable,
+                       TableIter *iter) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(iter);
+
+  const Table(byte) *table = table_;
+  while (!iter->mask) {
+    const usize group = iter->next_group;
+    if (UNLIKELY(group >= table->end + table->old_end)) {
+      return false;
+    }
+
+    // both ends are multiples of the group width, groups never straddle the
+    // two arrays
+    if (LIKELY(group < table->end)) {
+      iter->mask = table_group_match_full(
+          table_internal_control_array(table, vtable) + group);
+    } else {
+      Table(byte) old = {0};
+      old.element = table->old_element;
+      old.end = table->old_end;
+      iter->mask = table_group_match_full(
+          table_internal_control_array(&old, vtable) + group - table->end);
+    }
+    iter->next_group = group + TABLE_GROUP_WIDTH;
+  }
+
+  iter->index = iter->next_group - TABLE_GROUP_WIDTH +
+                table_group_mask_lowest(iter->mask);
+  iter->mask = table_group_mask_clear_lowest(iter->mask);
+  return true;
+}
+
+/***
+ * @doc(macro): table_foreach
+ * @tag: all
+ *
+ * @brief: Loops over every set slot, declaring the `TableIter` `ITER` whose
+ * `index` is the current slot. Same rules as `table_next`.
+ *
+ * @example:
+ * ```c
+ * table_foreach(&table, &vtable, iter) {
+ *   int *element = table_get(&table, &vtable, iter.index);
+ * }
+ * ```
+ */
+#define table_foreach(TABLE, VTABLE, ITER)                                     \
+  for (TableIter ITER = {0}; table_next((TABLE), (VTABLE), &ITER);)
+
+// moves the element in slot `old_index` of the old array into the new array
+// and returns its new index
+static usize table_internal_migrate_slot(Table *table_,
+                                         const TableVTable *vtable,
+                                         usize old_index, u64 hash) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  Table(byte) *table = table_;
+  debug_check(table->old_end > old_index);
+
+  Table(byte) old = {0};
+  old.element = table->old_element;
+  old.end = table->old_end;
+
+  byte *control = table_internal_control_array(table, vtable);
+  byte *old_control = table_internal_control_array(&old, vtable);
+
+  const usize index = table_internal_find_non_full(table, vtable, hash);
+  if (control[index] == TABLE_INTERNAL_CONTROL_TOMB) {
+    table->tombs -= 1;
+  }
+  table_internal_move_slot(table, index, &old, old_index, vtable);
+  table_internal_set_control(control, table->end, index,
+                             table_internal_hash_to_control_byte(hash));
+
+  // the slot has to stay a tomb so probe sequences of old elements placed
+  // behind it are not cut short
+  table_internal_set_control(old_control, table->old_end, old_index,
+                             TABLE_INTERNAL_CONTROL_TOMB);
+  return index;
+}
+
+// migrates up to `num_slots` slots of the old array and frees it once every
+// slot has been migrated
+static void table_internal_migrate(Table *table_, const TableVTable *vtable,
+                                   usize num_slots, Allocator *allocator) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(allocator);
+
+  Table(byte) *table = table_;
+  debug_check(table->old_element);
+
+  Table(byte) old = {0};
+  old.element = table->old_element;
+  old.end = table->old_end;
+
+  const byte *old_control = table_internal_control_array(&old, vtable);
+  usize end = table->migrated + num_slots;
+  if (end > table->old_end) {
+    end = table->old_end;
+  }
+  TABLE_INTERNAL_STATS(const clock_t stats_start = clock();)
+
+  for (usize i = table->migrated; i < end; ++i) {
+    if (!(old_control[i] & TABLE_INTERNAL_CONTROL_ISSET_MASK)) {
+      continue;
+    }
+    table_internal_migrate_slot(table, vtable, i,
+                                table_internal_slot_hash(&old, vtable, i));
+  }
+  table->migrated = end;
+  TABLE_INTERNAL_STATS(table_internal_stats_rehash(vtable, stats_start, 0, 0);)
+
+  if (end == table->old_end) {
+    allocator_free(allocator, table->old_element);
+    table->old_element = NULL;
+    table->old_end = 0;
+    table->migrated = 0;
+  }
+}
+
 static void table_internal_realloc(Table *table_, const TableVTable *vtable,
                                    usize end, Allocator *allocator,
                                    Error *error) {
@@ -364,6 +1136,11 @@ static void table_internal_realloc(Table *table_, const TableVTable *vtable,
   // TODO: does this increase capacity more than it should?
   Table(byte) *table = table_;
 
+  if (table->old_element) {
+    table_internal_migrate(table, vtable, table->old_end, allocator);
+  }
+  TABLE_INTERNAL_STATS(const clock_t stats_start = clock();)
+
   Table(byte) table_new;
 
   table_internal_init(&table_new, vtable, end, allocator, error);
@@ -381,20 +1158,127 @@ static void table_internal_realloc(Table *table_, const TableVTable *vtable,
       continue;
     }
 
-    byte *element = table->element + vtable->element_size * i;
-    const u64 hash = vtable->hash(element, vtable->ctx);
-    const usize j = table_internal_find(&table_new, vtable, element, hash);
-    builtin_memcpy(table_new.element + vtable->element_size * j, element,
-                   vtable->element_size);
-    table_new_control[j] = table_internal_hash_to_control_byte(hash);
-    if (UNLIKELY(j < 16)) {
-      table_new_control[j + table_new.end] =
-          table_internal_hash_to_control_byte(hash);
-    }
+    const u64 hash = table_internal_slot_hash(table, vtable, i);
+    const usize j = table_internal_find_non_full(&table_new, vtable, hash);
+    table_internal_move_slot(&table_new, j, table, i, vtable);
+    table_internal_set_control(table_new_control, table_new.end, j,
+                               table_internal_hash_to_control_byte(hash));
   }
 
   allocator_free(allocator, table->element);
   builtin_memcpy(table, &table_new, sizeof(*table));
+  TABLE_INTERNAL_STATS(table_internal_stats_rehash(vtable, stats_start, 1, 0);)
+}
+
+// starts an incremental resize, the current array becomes the old array
+static void table_internal_realloc_incremental(Table *table_,
+                                               const TableVTable *vtable,
+                                               usize end, Allocator *allocator,
+                                               Error *error) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(end > 0);
+  debug_check(allocator);
+
+  Table(byte) *table = table_;
+  debug_check(!table->old_element);
+  TABLE_INTERNAL_STATS(const clock_t stats_start = clock();)
+
+  Table(byte) table_new;
+  table_internal_init(&table_new, vtable, end, allocator, error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+
+  table_new.length = table->length;
+  table_new.old_element = table->element;
+  table_new.old_end = table->end;
+  builtin_memcpy(table, &table_new, sizeof(*table));
+  TABLE_INTERNAL_STATS(table_internal_stats_rehash(vtable, stats_start, 1, 0);)
+
+  table_internal_migrate(table, vtable,
+                         vtable->migrate_groups * TABLE_GROUP_WIDTH, allocator);
+}
+
+static void table_internal_swap(byte *a, byte *b, usize num_bytes) {
+  debug_check(a);
+  debug_check(b);
+
+  for (usize i = 0; i < num_bytes; ++i) {
+    const byte tmp = a[i];
+    a[i] = b[i];
+    b[i] = tmp;
+  }
+}
+
+// rehashes the table in place to get rid of all tombs without allocating a
+// second array. Every set slot is turned into a tomb and every tomb into a
+// free slot, afterwards each remaining tomb is an element which still has to
+// be placed. An element stays where it is if it is already in the first
+// group of its probe sequence which has a non set slot, otherwise it is moved
+// to that slot, possibly swapping places with another element which has not
+// been placed yet.
+static void table_internal_purge(Table *table_, const TableVTable *vtable) {
+  debug_check(table_);
+  debug_check(vtable);
+
+  Table(byte) *table = table_;
+  debug_check(!table->old_element);
+
+  const usize mask = table->end - 1;
+  byte *control = table_internal_control_array(table, vtable);
+  TABLE_INTERNAL_STATS(const clock_t stats_start = clock();)
+
+  for (usize i = 0; i < table->end; ++i) {
+    control[i] = control[i] & TABLE_INTERNAL_CONTROL_ISSET_MASK
+                     ? TABLE_INTERNAL_CONTROL_TOMB
+                     : TABLE_INTERNAL_CONTROL_FREE;
+  }
+  builtin_memcpy(control + table->end, control, TABLE_GROUP_WIDTH);
+
+  for (usize i = 0; i < table->end; ++i) {
+    while (control[i] == TABLE_INTERNAL_CONTROL_TOMB) {
+      byte *element = table->element + vtable->element_size * i;
+      const u64 hash = table_internal_slot_hash(table, vtable, i);
+      const u8 control_byte = table_internal_hash_to_control_byte(hash);
+      const usize home = hash & mask;
+      const usize j = table_internal_find_non_full(table, vtable, hash);
+
+      if ((((i - home) & mask) / TABLE_GROUP_WIDTH) ==
+          (((j - home) & mask) / TABLE_GROUP_WIDTH)) {
+        table_internal_set_control(control, table->end, i, control_byte);
+        break;
+      }
+
+      byte *dest = table->element + vtable->element_size * j;
+      if (control[j] == TABLE_INTERNAL_CONTROL_FREE) {
+        table_internal_move_slot(table, j, table, i, vtable);
+        table_internal_set_control(control, table->end, j, control_byte);
+        table_internal_set_control(control, table->end, i,
+                                   TABLE_INTERNAL_CONTROL_FREE);
+        break;
+      }
+
+      // slot `j` holds an element which still has to be placed, it is moved
+      // to slot `i` and gets processed in the next iteration
+      table_internal_set_control(control, table->end, j, control_byte);
+      table_internal_swap(dest, element, vtable->element_size);
+      if (vtable->store_hash) {
+        u64 *hashes = table_internal_hash_array(table, vtable);
+        const u64 tmp = hashes[i];
+        hashes[i] = hashes[j];
+        hashes[j] = tmp;
+      }
+      if (vtable->value_size) {
+        byte *values = table_internal_value_array(table, vtable);
+        table_internal_swap(values + vtable->value_size * i,
+                            values + vtable->value_size * j,
+                            vtable->value_size);
+      }
+    }
+  }
+  table->tombs = 0;
+  TABLE_INTERNAL_STATS(table_internal_stats_rehash(vtable, stats_start, 0, 1);)
 }
 
 static void table_shrink(Table *table_, const TableVTable *vtable,
@@ -431,13 +1315,38 @@ static void table_internal_should_grow(Table *table_, const TableVTable *vtable,
   debug_check(allocator);
 
   Table(byte) *table = table_;
-  if (table->length + table->tombs >= table->end - table->end / 8) {
+  if (table->old_element) {
+    table_internal_migrate(table, vtable,
+                           vtable->migrate_groups * TABLE_GROUP_WIDTH,
+                           allocator);
+  }
+
+  if (LIKELY(table->length + table->tombs < table->end - table->end / 8)) {
+    return;
+  }
+
+  if (table->old_element) {
+    table_internal_migrate(table, vtable, table->old_end, allocator);
+  }
+
+  // purging leaves at least `end / 4` free slots, which amortizes its cost
+  // over the next `end / 4` inserts just like doubling would
+  if (table->tombs >= table->end / 4) {
+    table_internal_purge(table, vtable);
+    return;
+  }
+
+  if (vtable->migrate_groups) {
+    table_internal_realloc_incremental(table, vtable, table->end * 2,
+                                       allocator, error);
+  } else {
     table_internal_realloc(table, vtable, table->end * 2, allocator, error);
   }
 }
 
-static void table_internal_insert(Table *table_, const TableVTable *vtable,
-                                  const void *element, u64 hash, usize index) {
+// constructs `element` in the non set slot `index` without touching `length`
+static void table_internal_place(Table *table_, const TableVTable *vtable,
+                                 const void *element, u64 hash, usize index) {
   debug_check(table_);
   debug_check(vtable);
   debug_check(element);
@@ -445,18 +1354,28 @@ static void table_internal_insert(Table *table_, const TableVTable *vtable,
 
   Table(byte) *table = table_;
   byte *control = table_internal_control_array(table, vtable);
-  control[index] = table_internal_hash_to_control_byte(hash);
-  if (index < 16) {
-    control[index + table->end] = table_internal_hash_to_control_byte(hash);
+  table_internal_set_control(control, table->end, index,
+                             table_internal_hash_to_control_byte(hash));
+  if (vtable->store_hash) {
+    table_internal_hash_array(table, vtable)[index] = hash;
   }
   vtable->insert(table->element + index * vtable->element_size, element,
                  vtable->ctx);
-  table->length += 1;
 }
 
-static usize table_insert(Table *table_, const TableVTable *vtable,
-                          const void *element, Allocator *allocator,
-                          Error *error) {
+static void table_internal_insert(Table *table_, const TableVTable *vtable,
+                                  const void *element, u64 hash, usize index) {
+  table_internal_place(table_, vtable, element, hash, index);
+  ((Table(byte) *)table_)->length += 1;
+}
+
+// inserts `element` whose hash is `hash`. If an equal element is already
+// present it is overwritten when `overwrite` is set and left alone otherwise
+static usize table_internal_insert_hashed(Table *table_,
+                                          const TableVTable *vtable,
+                                          const void *element, u64 hash,
+                                          bool overwrite, Allocator *allocator,
+                                          Error *error) {
   debug_check(table_);
   debug_check(vtable);
   debug_check(element);
@@ -468,41 +1387,146 @@ static usize table_insert(Table *table_, const TableVTable *vtable,
     return -1;
   }
 
-  const u64 hash = vtable->hash(element, vtable->ctx);
-  usize index = table_internal_find(table, vtable, element, hash);
+  usize index = table_internal_lookup(table, vtable, element, hash);
+  if (UNLIKELY(index >= table->end)) {
+    index =
+        table_internal_migrate_slot(table, vtable, index - table->end, hash);
+  }
 
   byte *control = table_internal_control_array(table, vtable);
-
-  if (control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK) {
+  if (!(control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK)) {
+    table_internal_insert(table, vtable, element, hash, index);
+  } else if (overwrite) {
     vtable->overwrite(table->element + index * vtable->element_size, element,
                       vtable->ctx);
-  } else {
-    table_internal_insert(table, vtable, element, hash, index);
   }
   return index;
 }
 
-static usize table_upsert(Table *table_, const TableVTable *vtable,
+static usize table_insert(Table *table, const TableVTable *vtable,
                           const void *element, Allocator *allocator,
                           Error *error) {
+  debug_check(vtable);
+  debug_check(element);
+
+  return table_internal_insert_hashed(table, vtable, element,
+                                      vtable->hash(element, vtable->ctx), true,
+                                      allocator, error);
+}
+
+static usize table_upsert(Table *table, const TableVTable *vtable,
+                          const void *element, Allocator *allocator,
+                          Error *error) {
+  debug_check(vtable);
+  debug_check(element);
+
+  return table_internal_insert_hashed(table, vtable, element,
+                                      vtable->hash(element, vtable->ctx), false,
+                                      allocator, error);
+}
+
+/***
+ * @doc(function): table_insert_hashed
+ * @tag: all
+ *
+ * @brief: Like `table_insert` with the hash of `element` supplied by the
+ * caller, see `table_find_hashed`.
+ */
+static usize table_insert_hashed(Table *table, const TableVTable *vtable,
+                                 const void *element, u64 hash,
+                                 Allocator *allocator, Error *error) {
+  return table_internal_insert_hashed(table, vtable, element, hash, true,
+                                      allocator, error);
+}
+
+/***
+ * @doc(function): table_upsert_hashed
+ * @tag: all
+ *
+ * @brief: Like `table_upsert` with the hash of `element` supplied by the
+ * caller, see `table_find_hashed`.
+ */
+static usize table_upsert_hashed(Table *table, const TableVTable *vtable,
+                                 const void *element, u64 hash,
+                                 Allocator *allocator, Error *error) {
+  return table_internal_insert_hashed(table, vtable, element, hash, false,
+                                      allocator, error);
+}
+
+// removes the element equal to `element` whose hash is `hash`
+static bool table_internal_remove_hashed(Table *table_,
+                                         const TableVTable *vtable,
+                                         const void *element, u64 hash) {
   debug_check(table_);
   debug_check(vtable);
   debug_check(element);
-  debug_check(allocator);
 
   Table(byte) *table = table_;
-  table_internal_should_grow(table, vtable, allocator, error);
-  if (UNLIKELY(error && *error)) {
-    return -1;
+  const usize index = table_internal_lookup(table, vtable, element, hash);
+  if (!table_isset(table, vtable, index)) {
+    return false;
+  }
+
+  if (vtable->destroy) {
+    vtable->destroy(table_get(table, vtable, index), vtable->ctx);
+  }
+  table->length -= 1;
+
+  if (UNLIKELY(index >= table->end)) {
+    // the old array is never inserted into, tombs do not matter there
+    Table(byte) old = {0};
+    old.element = table->old_element;
+    old.end = table->old_end;
+    byte *old_control = table_internal_control_array(&old, vtable);
+    table_internal_set_control(old_control, table->old_end,
+                               index - table->end,
+                               TABLE_INTERNAL_CONTROL_TOMB);
+    return true;
   }
 
-  const u64 hash = vtable->hash(element, vtable->ctx);
   byte *control = table_internal_control_array(table, vtable);
-  usize index = table_internal_find(table, vtable, element, hash);
-  if (!(control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK)) {
-    table_internal_insert(table, vtable, element, hash, index);
+  if (table_internal_control_erase(control, table->end, index)) {
+    table->tombs += 1;
   }
-  return index;
+  return true;
+}
+
+/***
+ * @doc(function): table_remove
+ * @tag: all
+ *
+ * @brief: Removes an element from the table.
+ *
+ * @detailed: Removes the element which compares equal to `element` and calls
+ * `vtable->destroy` on it. The slot is marked as free if no group which
+ * contains it can be completely set, only otherwise a tomb is
+ * left behind, this way probe sequences stay as short as possible. Tombs are
+ * cleared in place once they make up a significant part of the table.
+ *
+ * @param(element): element which is to be removed
+ * @assert(element): `element != NULL`
+ *
+ * @return: `true` if the element was present
+ */
+static bool table_remove(Table *table, const TableVTable *vtable,
+                         const void *element) {
+  debug_check(vtable);
+  debug_check(element);
+
+  return table_internal_remove_hashed(table, vtable, element,
+                                      vtable->hash(element, vtable->ctx));
+}
+
+/***
+ * @doc(function): table_remove_hashed
+ * @tag: all
+ *
+ * @brief: Like `table_remove` with the hash of `element` supplied by the
+ * caller, see `table_find_hashed`.
+ */
+static bool table_remove_hashed(Table *table, const TableVTable *vtable,
+                                const void *element, u64 hash) {
+  return table_internal_remove_hashed(table, vtable, element, hash);
 }
 
 // NOTE: this is really stupid but we need to get rid of unwanted unused
@@ -514,13 +1538,24 @@ static void table_dummy_caller__(void) {
 
   table_insert(NULL, NULL, NULL, NULL, NULL);
   table_upsert(NULL, NULL, NULL, NULL, NULL);
+  table_remove(NULL, NULL, NULL);
+  table_insert_hashed(NULL, NULL, NULL, 0, NULL, NULL);
+  table_upsert_hashed(NULL, NULL, NULL, 0, NULL, NULL);
+  table_remove_hashed(NULL, NULL, NULL, 0);
 
   table_reserve(NULL, NULL, 0, NULL, NULL);
   table_shrink(NULL, NULL, NULL, NULL);
 
   table_find(NULL, NULL, NULL);
+  table_find_hashed(NULL, NULL, NULL, 0);
+  table_find_key(NULL, NULL, NULL, 0, NULL);
   table_isset(NULL, NULL, 0);
+  table_get(NULL, NULL, 0);
+  table_value(NULL, NULL, 0);
   table_contains(NULL, NULL, NULL);
+  table_find_many(NULL, NULL, NULL, 0, NULL);
+  table_contains_many(NULL, NULL, NULL, 0, NULL);
+  table_next(NULL, NULL, NULL);
   table_dummy_callee__();
 }
 static void table_dummy_callee__(void) { table_dummy_caller__(); }
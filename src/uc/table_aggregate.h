@@ -0,0 +1,332 @@
+#ifndef TABLE_AGGREGATE_H_
+#define TABLE_AGGREGATE_H_
+
+#include <uc/table.h>
+
+/***
+ * @file
+ * Group by aggregation of columns into a table.
+ *
+ * The keys of the rows are the elements of the table, the aggregates of a
+ * group are stored as its value (see `TableVTable.value_size`): one `i64`
+ * per aggregate, so `vtable->value_size` has to be
+ * `num_aggregates * sizeof(i64)`. Rows are processed in batches of
+ * `TABLE_INTERNAL_BATCH`: the table is grown once for the whole batch, every
+ * key is hashed and its control group prefetched, the first candidate slot
+ * and value of every key are prefetched unless the table is small enough to
+ * be cached, then all keys are probed and finally every aggregate is applied
+ * to the whole batch at once.
+ *
+ * The table grows with full resizes only, `vtable->migrate_groups` has to be
+ * `0`.
+ *
+ * @example:
+ * ```c
+ * const TableAggregate aggregates[] = {
+ *     {TABLE_AGGREGATE_COUNT, 0},
+ *     {TABLE_AGGREGATE_SUM, 0},
+ * };
+ * const i64 *columns[] = {prices};
+ * table_aggregate(&table, &vtable, aggregates, 2, customer_ids, columns,
+ *                 num_rows, 0, allocator, NULL);
+ * table_foreach(&table, &vtable, iter) {
+ *   const i64 *result = table_value(&table, &vtable, iter.index);
+ *   // result[0] is the number of rows, result[1] the sum of their prices
+ * }
+ * ```
+ */
+
+/***
+ * @doc(type): TableAggregateOp
+ * @tag: all
+ *
+ * @brief: Aggregate function applied to a column.
+ *
+ * @member(TABLE_AGGREGATE_COUNT): number of rows, ignores the column
+ *
+ * @member(TABLE_AGGREGATE_SUM): sum of the column, wrapping on overflow
+ *
+ * @member(TABLE_AGGREGATE_MIN): minimum of the column
+ *
+ * @member(TABLE_AGGREGATE_MAX): maximum of the column
+ */
+typedef enum {
+  TABLE_AGGREGATE_COUNT,
+  TABLE_AGGREGATE_SUM,
+  TABLE_AGGREGATE_MIN,
+  TABLE_AGGREGATE_MAX,
+} TableAggregateOp;
+
+/***
+ * @doc(type): TableAggregate
+ * @tag: all
+ *
+ * @member(op): function to apply
+ *
+ * @member(column): index of the value column it is applied to
+ */
+typedef struct TableAggregate TableAggregate;
+struct TableAggregate {
+  TableAggregateOp op;
+  usize column;
+};
+
+// tables whose arrays are smaller than this are assumed to be cached and
+// skip prefetching candidate slots
+#define TABLE_AGGREGATE_INTERNAL_PREFETCH_BYTES ((usize)1 << 20)
+
+// number of smallest hashes kept by `table_aggregate_estimate`
+#define TABLE_AGGREGATE_INTERNAL_ESTIMATE_K 64
+
+/***
+ * @doc(function): table_aggregate_estimate
+ * @tag: all
+ *
+ * @brief: Estimates the number of distinct keys among `rows` keys.
+ *
+ * @detailed: Hashes every key and keeps the `64` smallest distinct hashes,
+ * the distance of the largest of them to `0` estimates the number of
+ * distinct hashes (the k minimum values sketch). Exact below `64` distinct
+ * keys, otherwise typically within 15%.
+ *
+ * @param(keys): contiguous array of `rows` keys each `vtable->element_size`
+ * bytes big
+ */
+static usize table_aggregate_estimate(const TableVTable *vtable,
+                                      const void *keys, usize rows) {
+  debug_check(vtable);
+  debug_check(keys || !rows);
+
+  // sorted ascending, `minimum[count - 1]` is the current threshold
+  u64 minimum[TABLE_AGGREGATE_INTERNAL_ESTIMATE_K];
+  usize count = 0;
+  const byte *key = keys;
+  for (usize row = 0; row < rows; ++row) {
+    const u64 hash = vtable->hash(key + row * vtable->element_size,
+                                  vtable->ctx);
+    if (count == TABLE_AGGREGATE_INTERNAL_ESTIMATE_K &&
+        hash >= minimum[count - 1]) {
+      continue;
+    }
+    usize i = count;
+    while (i > 0 && minimum[i - 1] > hash) {
+      i -= 1;
+    }
+    if (i > 0 && minimum[i - 1] == hash) {
+      continue;
+    }
+    if (count < TABLE_AGGREGATE_INTERNAL_ESTIMATE_K) {
+      count += 1;
+    }
+    for (usize j = count - 1; j > i; --j) {
+      minimum[j] = minimum[j - 1];
+    }
+    minimum[i] = hash;
+  }
+
+  if (count < TABLE_AGGREGATE_INTERNAL_ESTIMATE_K) {
+    return count;
+  }
+  // the k smallest of n uniform hashes span about k / n of the hash space
+  const double estimate = (double)(TABLE_AGGREGATE_INTERNAL_ESTIMATE_K - 1) *
+                          18446744073709551616.0 /
+                          ((double)minimum[count - 1] + 1.0);
+  return estimate < (double)rows ? (usize)estimate : rows;
+}
+
+// makes room for `rows` new groups so that no insert of the batch has to
+// grow the table
+static void table_aggregate_internal_make_room(Table *table_,
+                                               const TableVTable *vtable,
+                                               usize rows,
+                                               Allocator *allocator,
+                                               Error *error) {
+  Table(byte) *table = table_;
+  if (LIKELY(table->length + table->tombs + rows <
+             table->end - table->end / 8)) {
+    return;
+  }
+  if (table->tombs >= table->end / 4) {
+    table_internal_purge(table, vtable);
+    if (table->length + rows < table->end - table->end / 8) {
+      return;
+    }
+  }
+  table_reserve(table, vtable, 2 * (table->length + rows), allocator, error);
+}
+
+// initial value of a new group's aggregate, before the first row is applied
+static i64 table_aggregate_internal_identity(TableAggregateOp op) {
+  switch (op) {
+  case TABLE_AGGREGATE_MIN:
+    return INT64_MAX;
+  case TABLE_AGGREGATE_MAX:
+    return INT64_MIN;
+  default:
+    return 0;
+  }
+}
+
+// applies `aggregate` to `count` rows starting at `row`, whose groups'
+// values start at `value[i]`
+static void table_aggregate_internal_apply(const TableAggregate *aggregate,
+                                           usize offset,
+                                           const i64 *const *columns,
+                                           usize row, i64 *const *value,
+                                           usize count) {
+  const i64 *column = aggregate->op == TABLE_AGGREGATE_COUNT
+                           ? NULL
+                           : columns[aggregate->column] + row;
+  switch (aggregate->op) {
+  case TABLE_AGGREGATE_COUNT:
+    for (usize i = 0; i < count; ++i) {
+      value[i][offset] += 1;
+    }
+    break;
+  case TABLE_AGGREGATE_SUM:
+    for (usize i = 0; i < count; ++i) {
+      value[i][offset] = (i64)((u64)value[i][offset] + (u64)column[i]);
+    }
+    break;
+  case TABLE_AGGREGATE_MIN:
+    for (usize i = 0; i < count; ++i) {
+      if (column[i] < value[i][offset]) {
+        value[i][offset] = column[i];
+      }
+    }
+    break;
+  case TABLE_AGGREGATE_MAX:
+    for (usize i = 0; i < count; ++i) {
+      if (column[i] > value[i][offset]) {
+        value[i][offset] = column[i];
+      }
+    }
+    break;
+  }
+}
+
+/***
+ * @doc(function): table_aggregate
+ * @tag: all
+ *
+ * @brief: Adds `rows` rows to the groups in `table`, creating missing
+ * groups.
+ *
+ * @detailed: Row `i` has the key at `keys + i * vtable->element_size` and
+ * the values `columns[c][i]`. Keys of new groups are copied in with
+ * `vtable->insert`. May be called repeatedly to aggregate a stream in
+ * chunks, the table is never shrunk.
+ *
+ * @param(vtable): `value_size` has to be `num_aggregates * sizeof(i64)` and
+ * `migrate_groups` has to be `0`
+ *
+ * @param(aggregates): `num_aggregates` aggregates, aggregate `a` of a group
+ * is `((i64 *)table_value(table, vtable, index))[a]`
+ *
+ * @param(columns): value columns, each of at least `rows` values. May be
+ * `NULL` if all aggregates are `TABLE_AGGREGATE_COUNT`
+ *
+ * @param(cardinality): expected number of groups, the table is reserved for
+ * it up front. `0` reserves for the estimate of `table_aggregate_estimate`,
+ * which costs one more hash per row
+ *
+ * @error: any error of the allocator. The rows of every batch completed
+ * before are aggregated
+ */
+static void table_aggregate(Table *table_, const TableVTable *vtable,
+                            const TableAggregate *aggregates,
+                            usize num_aggregates, const void *keys,
+                            const i64 *const *columns, usize rows,
+                            usize cardinality, Allocator *allocator,
+                            Error *error) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(vtable->value_size == num_aggregates * sizeof(i64));
+  debug_check(!vtable->migrate_groups);
+  debug_check(aggregates || !num_aggregates);
+  debug_check(keys || !rows);
+  debug_check(allocator);
+
+  Table(byte) *table = table_;
+  debug_check(!table->old_element);
+  if (!cardinality) {
+    cardinality = table_aggregate_estimate(vtable, keys, rows);
+  }
+  if (cardinality > table->length) {
+    table_reserve(table, vtable, cardinality, allocator, error);
+    if (UNLIKELY(error && *error)) {
+      return;
+    }
+  }
+
+  const byte *key = keys;
+  u64 hash[TABLE_INTERNAL_BATCH];
+  i64 *value[TABLE_INTERNAL_BATCH];
+
+  for (usize row = 0; row < rows; row += TABLE_INTERNAL_BATCH) {
+    const usize count =
+        rows - row < TABLE_INTERNAL_BATCH ? rows - row : TABLE_INTERNAL_BATCH;
+    table_aggregate_internal_make_room(table, vtable, count, allocator, error);
+    if (UNLIKELY(error && *error)) {
+      return;
+    }
+
+    const usize mask = table->end - 1;
+    byte *control = table_internal_control_array(table, vtable);
+    byte *values = table_internal_value_array(table, vtable);
+    for (usize i = 0; i < count; ++i) {
+      hash[i] = vtable->hash(key + (row + i) * vtable->element_size,
+                             vtable->ctx);
+      builtin_prefetch(control + (hash[i] & mask));
+    }
+
+    // the slot of an existing group is usually the first tag match
+    if (table_internal_chunk_size(vtable, table->end) >
+        TABLE_AGGREGATE_INTERNAL_PREFETCH_BYTES) {
+      for (usize i = 0; i < count; ++i) {
+        const usize index = hash[i] & mask;
+        const TableGroupMask poss_bitmask = table_group_match(
+            control + index, table_internal_hash_to_control_byte(hash[i]));
+        if (poss_bitmask) {
+          const usize real_index =
+              (index + table_group_mask_lowest(poss_bitmask)) & mask;
+          builtin_prefetch(table->element + vtable->element_size * real_index);
+          builtin_prefetch(values + vtable->value_size * real_index);
+        }
+      }
+    }
+
+    for (usize i = 0; i < count; ++i) {
+      const byte *element = key + (row + i) * vtable->element_size;
+      // a miss returns a free slot of the probe sequence, which the new
+      // group can take right away as no insert of the batch grows the table
+      const usize index =
+          table_internal_lookup(table, vtable, element, hash[i]);
+      value[i] = (i64 *)(values + vtable->value_size * index);
+      if (control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK) {
+        continue;
+      }
+      table_internal_insert(table, vtable, element, hash[i], index);
+      for (usize a = 0; a < num_aggregates; ++a) {
+        value[i][a] = table_aggregate_internal_identity(aggregates[a].op);
+      }
+    }
+
+    for (usize a = 0; a < num_aggregates; ++a) {
+      table_aggregate_internal_apply(&aggregates[a], a, columns, row, value,
+                                     count);
+    }
+  }
+}
+
+static void table_aggregate_dummy_callee__(void);
+static void table_aggregate_dummy_caller__(void) {
+  table_aggregate_estimate(NULL, NULL, 0);
+  table_aggregate(NULL, NULL, NULL, 0, NULL, NULL, 0, 0, NULL, NULL);
+  table_aggregate_dummy_callee__();
+}
+static void table_aggregate_dummy_callee__(void) {
+  table_aggregate_dummy_caller__();
+}
+
+#endif // TABLE_AGGREGATE_H_
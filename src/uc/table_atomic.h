@@ -0,0 +1,480 @@
+#ifndef TABLE_ATOMIC_H_
+#define TABLE_ATOMIC_H_
+
+#include <uc/epoch.h>
+#include <uc/table.h>
+#include <uc/thread.h>
+
+/***
+ * @file
+ * Table with lock free readers for read mostly workloads. Requires `thread.h`
+ * and therefore `-pthread`.
+ *
+ * Readers never write to shared memory. They enter an `Epoch`, load the
+ * published array and probe it like `table_find` does. Writers are serialized
+ * by a mutex and never change a slot which readers may be looking at:
+ *
+ * - an element is written before its control byte is published
+ * - removed slots become tombs which are never reused within the same array
+ * - overwriting inserts a new copy and only then tombs the old one
+ * - growing, or getting rid of the tombs, builds a new array which is
+ *   published with a single atomic pointer store
+ *
+ * Old arrays and removed elements are released through `epoch_retire` once
+ * no reader can see them, in the order they were retired. Stored hashes and
+ * values are not supported, `vtable->store_hash` and `vtable->value_size`
+ * have to be `0`.
+ *
+ * On targets with a weaker memory model than x86, the group loads of the
+ * control bytes rely on the acquire fence issued before an element is
+ * compared, as vector loads cannot be atomic.
+ */
+
+/***
+ * @doc(type): TableAtomicArray
+ * @tag: all
+ *
+ * @brief: Header of a published array, followed by the `end` elements and
+ * the control bytes.
+ */
+typedef struct TableAtomicArray TableAtomicArray;
+struct TableAtomicArray {
+  usize end;
+  // keeps the elements 16 byte aligned
+  usize reserved;
+};
+
+/***
+ * @doc(type): TableAtomic
+ * @tag: all
+ *
+ * @brief: Table with lock free readers, see the file documentation.
+ *
+ * @member(array): currently published array, only to be loaded atomically
+ *
+ * @member(length): number of elements, only stable under `writer`
+ *
+ * @member(tombs): number of tombs in `array`, only stable under `writer`
+ */
+typedef struct TableAtomic TableAtomic;
+struct TableAtomic {
+  TableAtomicArray *array;
+  usize length;
+  usize tombs;
+  Mutex writer;
+  Epoch *epoch;
+  Allocator *allocator;
+};
+
+// view of `array` as a regular table, for the helpers of `table.h`
+static void table_atomic_internal_view(Table *view_,
+                                       const TableAtomicArray *array) {
+  Table(byte) *view = view_;
+  builtin_memset(view, 0, sizeof(*view));
+  view->element = (byte *)(array + 1);
+  view->end = array->end;
+}
+
+static TableAtomicArray *
+table_atomic_internal_alloc(const TableVTable *vtable, usize end,
+                            Allocator *allocator, Error *error) {
+  TableAtomicArray *array = allocator_alloc(
+      allocator,
+      sizeof(TableAtomicArray) + table_internal_chunk_size(vtable, end), error);
+  if (UNLIKELY(error && *error)) {
+    return NULL;
+  }
+  array->end = end;
+  array->reserved = 0;
+
+  Table(byte) view;
+  table_atomic_internal_view(&view, array);
+  builtin_memset(table_internal_control_array(&view, vtable),
+                 TABLE_INTERNAL_CONTROL_FREE, end + TABLE_GROUP_WIDTH);
+  return array;
+}
+
+// publishes a control byte after the element it describes was written
+static void table_atomic_internal_set_control(byte *control, usize end,
+                                              usize index, u8 value) {
+  __atomic_store_n(&control[index], value, __ATOMIC_RELEASE);
+  if (index < TABLE_GROUP_WIDTH) {
+    __atomic_store_n(&control[index + end], value, __ATOMIC_RELEASE);
+  }
+}
+
+// first free slot in the probe sequence of `hash`, tombs are not reused
+static usize table_atomic_internal_find_free(const byte *control, usize mask,
+                                             u64 hash) {
+  usize index = hash & mask;
+  while (1) {
+    const TableGroupMask free = table_group_match_free(control + index);
+    if (LIKELY(free)) {
+      return (index + table_group_mask_lowest(free)) & mask;
+    }
+    index += TABLE_GROUP_WIDTH;
+    index &= mask;
+  }
+}
+
+/***
+ * @doc(function): table_atomic_init
+ * @tag: all
+ *
+ * @param(epoch): reclamation domain of the readers, may be shared with other
+ * tables
+ * @assert(epoch): `epoch != NULL`
+ *
+ * @param(allocator): used for the arrays, has to be thread safe as arrays are
+ * freed by whichever thread collects the epoch
+ */
+static void table_atomic_init(TableAtomic *table, const TableVTable *vtable,
+                              Epoch *epoch, usize initial_capacity,
+                              Allocator *allocator, Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(!vtable->store_hash);
+  debug_check(!vtable->value_size);
+  debug_check(epoch);
+  debug_check(allocator);
+
+  builtin_memset(table, 0, sizeof(*table));
+  table->epoch = epoch;
+  table->allocator = allocator;
+  table->array = table_atomic_internal_alloc(
+      vtable,
+      table_internal_end_from_capacity(initial_capacity ? initial_capacity
+                                                        : 1),
+      allocator, error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+  mutex_init(&table->writer);
+}
+
+/***
+ * @doc(function): table_atomic_find
+ * @tag: all
+ *
+ * @brief: Returns a pointer to the element equal to `element` or `NULL`.
+ *
+ * @detailed: Lock free. Has to be called between `epoch_enter` and
+ * `epoch_exit` on the epoch of the table and the pointer must not be used
+ * after `epoch_exit`. The element must not be modified through it.
+ */
+static const void *table_atomic_find(const TableAtomic *table,
+                                     const TableVTable *vtable,
+                                     const void *element) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  const TableAtomicArray *array =
+      __atomic_load_n(&table->array, __ATOMIC_ACQUIRE);
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  const usize mask = array->end - 1;
+  const byte *elements = (const byte *)(array + 1);
+  const byte *control = elements + vtable->element_size * array->end;
+  const u8 control_byte = table_internal_hash_to_control_byte(hash);
+
+  usize index = hash & mask;
+  while (1) {
+    TableGroupMask poss_bitmask =
+        table_group_match(control + index, control_byte);
+    if (poss_bitmask) {
+      // orders the element loads after the control byte loads
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    }
+    while (poss_bitmask) {
+      const usize real_index =
+          (index + table_group_mask_lowest(poss_bitmask)) & mask;
+      const byte *slot = elements + vtable->element_size * real_index;
+      if (vtable->compare(element, slot, vtable->ctx)) {
+        return slot;
+      }
+      poss_bitmask = table_group_mask_clear_lowest(poss_bitmask);
+    }
+
+    if (LIKELY(table_group_match_free(control + index))) {
+      return NULL;
+    }
+    index += TABLE_GROUP_WIDTH;
+    index &= mask;
+  }
+}
+
+/***
+ * @doc(function): table_atomic_get
+ * @tag: all
+ *
+ * @brief: Copies the element equal to `element` into `out`. Lock free.
+ *
+ * @param(reader): epoch reader slot of the calling thread, see
+ * `epoch_register`
+ *
+ * @param(out): receives a bitwise copy of the element, may be `NULL`
+ *
+ * @return: `true` if the element was found
+ */
+static bool table_atomic_get(const TableAtomic *table,
+                             const TableVTable *vtable, usize reader,
+                             const void *element, void *out) {
+  debug_check(table);
+
+  epoch_enter(table->epoch, reader);
+  const void *found = table_atomic_find(table, vtable, element);
+  if (found && out) {
+    builtin_memmove(out, found, vtable->element_size);
+  }
+  epoch_exit(table->epoch, reader);
+  return found;
+}
+
+/***
+ * @doc(function): table_atomic_contains
+ * @tag: all
+ *
+ * @brief: Returns `true` if an element equal to `element` is present. Lock
+ * free.
+ */
+static bool table_atomic_contains(const TableAtomic *table,
+                                  const TableVTable *vtable, usize reader,
+                                  const void *element) {
+  return table_atomic_get(table, vtable, reader, element, NULL);
+}
+
+// destroys an element which was removed from an array that may still be read
+static void table_atomic_internal_retire_element(TableAtomic *table,
+                                                 const TableVTable *vtable,
+                                                 byte *slot, Error *error) {
+  if (vtable->destroy) {
+    epoch_retire(table->epoch, vtable->destroy, slot, vtable->ctx, error);
+  }
+}
+
+// frees an array which is no longer published, after the elements retired
+// from it were destroyed. If the retired list cannot grow, waits until the
+// epoch is two ahead, when no reader which saw the array is inside and the
+// elements retired before it are destroyed, and frees it directly
+static void table_atomic_internal_retire_array(TableAtomic *table,
+                                               TableAtomicArray *array) {
+  Epoch *epoch = table->epoch;
+  const u64 start = __atomic_load_n(&epoch->global, __ATOMIC_ACQUIRE);
+  Error error = 0;
+  epoch_retire(epoch, epoch_allocator_free, array, table->allocator, &error);
+  if (LIKELY(!error)) {
+    return;
+  }
+  while (__atomic_load_n(&epoch->global, __ATOMIC_ACQUIRE) < start + 2) {
+    epoch_collect(epoch);
+    (void)sched_yield();
+  }
+  // waits for a collection which advanced the epoch to finish destroying
+  epoch_collect(epoch);
+  allocator_free(table->allocator, array);
+}
+
+/***
+ * @doc(function): table_atomic_deinit
+ * @tag: all
+ *
+ * @brief: Retires the published array. No reader or writer may use the table
+ * any more, but the epoch has to outlive it: removed elements may still be
+ * waiting to be destroyed and point into the array, so the array is freed by
+ * the epoch after them, at the latest by `epoch_deinit`. Elements which are
+ * still in the table are not destroyed, as with `table_deinit`.
+ */
+static void table_atomic_deinit(TableAtomic *table) {
+  debug_check(table);
+
+  table_atomic_internal_retire_array(table, table->array);
+  mutex_deinit(&table->writer);
+}
+
+// builds an array of `end` slots with the set slots of the published one,
+// publishes it and retires the old one. `writer` has to be held
+static void table_atomic_internal_rebuild(TableAtomic *table,
+                                          const TableVTable *vtable, usize end,
+                                          Error *error) {
+  TableAtomicArray *old_array = table->array;
+  TableAtomicArray *new_array =
+      table_atomic_internal_alloc(vtable, end, table->allocator, error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+
+  Table(byte) old;
+  Table(byte) new;
+  table_atomic_internal_view(&old, old_array);
+  table_atomic_internal_view(&new, new_array);
+  const byte *old_control = table_internal_control_array(&old, vtable);
+  byte *new_control = table_internal_control_array(&new, vtable);
+
+  // elements are moved bitwise, the old copies are released without
+  // destroying them
+  for (usize i = 0; i < old.end; ++i) {
+    if (!(old_control[i] & TABLE_INTERNAL_CONTROL_ISSET_MASK)) {
+      continue;
+    }
+    const u64 hash = vtable->hash(old.element + vtable->element_size * i,
+                                  vtable->ctx);
+    const usize j =
+        table_atomic_internal_find_free(new_control, new.end - 1, hash);
+    table_internal_move_slot(&new, j, &old, i, vtable);
+    table_internal_set_control(new_control, new.end, j,
+                               table_internal_hash_to_control_byte(hash));
+  }
+
+  __atomic_store_n(&table->array, new_array, __ATOMIC_RELEASE);
+  table->tombs = 0;
+  table_atomic_internal_retire_array(table, old_array);
+}
+
+// makes sure one more slot can be taken. `writer` has to be held
+static void table_atomic_internal_reserve_slot(TableAtomic *table,
+                                               const TableVTable *vtable,
+                                               Error *error) {
+  const usize end = table->array->end;
+  if (LIKELY(table->length + table->tombs + 1 < end - end / 8)) {
+    return;
+  }
+  // if mostly tombs are in the way, rebuilding at the same size is enough
+  usize new_end = table_internal_end_from_capacity(2 * (table->length + 1));
+  if (new_end < end) {
+    new_end = end;
+  }
+  table_atomic_internal_rebuild(table, vtable, new_end, error);
+}
+
+static void table_atomic_internal_insert(TableAtomic *table,
+                                         const TableVTable *vtable,
+                                         const void *element, bool overwrite,
+                                         Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  mutex_lock(&table->writer);
+  table_atomic_internal_reserve_slot(table, vtable, error);
+  if (UNLIKELY(error && *error)) {
+    mutex_unlock(&table->writer);
+    return;
+  }
+
+  Table(byte) view;
+  table_atomic_internal_view(&view, table->array);
+  byte *control = table_internal_control_array(&view, vtable);
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  const usize existing = table_internal_lookup(&view, vtable, element, hash);
+  const bool present = control[existing] & TABLE_INTERNAL_CONTROL_ISSET_MASK;
+  if (present && !overwrite) {
+    mutex_unlock(&table->writer);
+    return;
+  }
+
+  const usize index =
+      table_atomic_internal_find_free(control, view.end - 1, hash);
+  vtable->insert(view.element + vtable->element_size * index, element,
+                 vtable->ctx);
+  table_atomic_internal_set_control(control, view.end, index,
+                                    table_internal_hash_to_control_byte(hash));
+  if (present) {
+    // readers find either copy until the old one is gone
+    table_atomic_internal_set_control(control, view.end, existing,
+                                      TABLE_INTERNAL_CONTROL_TOMB);
+    table->tombs += 1;
+    table_atomic_internal_retire_element(
+        table, vtable, view.element + vtable->element_size * existing, error);
+  } else {
+    __atomic_store_n(&table->length, table->length + 1, __ATOMIC_RELAXED);
+  }
+  mutex_unlock(&table->writer);
+}
+
+/***
+ * @doc(function): table_atomic_insert
+ * @tag: all
+ *
+ * @brief: Inserts `element`, replacing an equal element, which is destroyed
+ * once no reader can see it. Writers are serialized, readers are never
+ * blocked.
+ */
+static void table_atomic_insert(TableAtomic *table, const TableVTable *vtable,
+                                const void *element, Error *error) {
+  table_atomic_internal_insert(table, vtable, element, true, error);
+}
+
+/***
+ * @doc(function): table_atomic_upsert
+ * @tag: all
+ *
+ * @brief: Inserts `element` unless an equal element is present. Writers are
+ * serialized, readers are never blocked.
+ */
+static void table_atomic_upsert(TableAtomic *table, const TableVTable *vtable,
+                                const void *element, Error *error) {
+  table_atomic_internal_insert(table, vtable, element, false, error);
+}
+
+/***
+ * @doc(function): table_atomic_remove
+ * @tag: all
+ *
+ * @brief: Removes the element equal to `element`, which is destroyed once no
+ * reader can see it. Writers are serialized, readers are never blocked.
+ *
+ * @return: `true` if the element was present
+ */
+static bool table_atomic_remove(TableAtomic *table, const TableVTable *vtable,
+                                const void *element, Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  mutex_lock(&table->writer);
+  Table(byte) view;
+  table_atomic_internal_view(&view, table->array);
+  byte *control = table_internal_control_array(&view, vtable);
+  const usize index = table_internal_lookup(
+      &view, vtable, element, vtable->hash(element, vtable->ctx));
+  const bool present = control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK;
+  if (present) {
+    table_atomic_internal_set_control(control, view.end, index,
+                                      TABLE_INTERNAL_CONTROL_TOMB);
+    table->tombs += 1;
+    __atomic_store_n(&table->length, table->length - 1, __ATOMIC_RELAXED);
+    table_atomic_internal_retire_element(
+        table, vtable, view.element + vtable->element_size * index, error);
+  }
+  mutex_unlock(&table->writer);
+  return present;
+}
+
+/***
+ * @doc(function): table_atomic_length
+ * @tag: all
+ *
+ * @brief: Number of elements, may be outdated as soon as it is returned.
+ */
+static usize table_atomic_length(const TableAtomic *table) {
+  debug_check(table);
+
+  return __atomic_load_n(&table->length, __ATOMIC_RELAXED);
+}
+
+static void table_atomic_dummy_callee__(void);
+static void table_atomic_dummy_caller__(void) {
+  table_atomic_init(NULL, NULL, NULL, 0, NULL, NULL);
+  table_atomic_deinit(NULL);
+  table_atomic_find(NULL, NULL, NULL);
+  table_atomic_get(NULL, NULL, 0, NULL, NULL);
+  table_atomic_contains(NULL, NULL, 0, NULL);
+  table_atomic_insert(NULL, NULL, NULL, NULL);
+  table_atomic_upsert(NULL, NULL, NULL, NULL);
+  table_atomic_remove(NULL, NULL, NULL, NULL);
+  table_atomic_length(NULL);
+  table_atomic_dummy_callee__();
+}
+static void table_atomic_dummy_callee__(void) { table_atomic_dummy_caller__(); }
+
+#endif // TABLE_ATOMIC_H_
@@ -0,0 +1,222 @@
+#ifndef TABLE_DEFINE_H_
+#define TABLE_DEFINE_H_
+
+#include <uc/table.h>
+
+/***
+ * @doc(macro): TABLE_DEFINE
+ * @tag: all
+ *
+ * @brief: Generates a table specialized for a single element type.
+ *
+ * @detailed: Defines the type `NAME` as `Table(TYPE)` together with the
+ * functions `NAME_init`, `NAME_deinit`, `NAME_find`, `NAME_isset`,
+ * `NAME_contains`, `NAME_insert`, `NAME_upsert`, `NAME_remove`,
+ * `NAME_reserve`, `NAME_shrink` and `NAME_next`. They behave like their
+ * `table_*` counterparts but take no vtable, `HASH` and `EQUAL` are called
+ * directly and elements are indexed with their static type, which lets the
+ * compiler inline and vectorize the hot paths. Elements are copied by
+ * assignment and never destroyed, so `TYPE` should be plain data.
+ *
+ * The memory layout is the one of `Table(TYPE)`, so a `NAME` can also be
+ * passed to the generic `table_*` functions together with `NAME_vtable`.
+ *
+ * @param(NAME): name of the generated type and prefix of its functions
+ *
+ * @param(TYPE): element type
+ *
+ * @param(HASH): function or macro with the signature
+ * `u64 HASH(const TYPE *element)`
+ *
+ * @param(EQUAL): function or macro with the signature
+ * `bool EQUAL(const TYPE *first, const TYPE *second)`
+ *
+ * @example:
+ * ```c
+ * static u64 int_hash(const int *x) { ... }
+ * static bool int_equal(const int *a, const int *b) { return *a == *b; }
+ * TABLE_DEFINE(IntSet, int, int_hash, int_equal)
+ * ```
+ */
+#define TABLE_DEFINE(NAME, TYPE, HASH, EQUAL)                                  \
+  typedef Table(TYPE) NAME;                                                    \
+                                                                               \
+  static u64 NAME##_internal_hash(const void *element, void *ctx) {            \
+    UNUSED(ctx);                                                               \
+    return HASH((const TYPE *)element);                                        \
+  }                                                                            \
+                                                                               \
+  static bool NAME##_internal_compare(const void *first, const void *second,   \
+                                      void *ctx) {                             \
+    UNUSED(ctx);                                                               \
+    return EQUAL((const TYPE *)first, (const TYPE *)second);                   \
+  }                                                                            \
+                                                                               \
+  static void NAME##_internal_insert(void *dest, const void *src, void *ctx) { \
+    UNUSED(ctx);                                                               \
+    *(TYPE *)dest = *(const TYPE *)src;                                        \
+  }                                                                            \
+                                                                               \
+  /* used for the cold paths: allocation, resizing and purging */              \
+  static const TableVTable NAME##_vtable = {                                   \
+      .hash = NAME##_internal_hash,                                            \
+      .insert = NAME##_internal_insert,                                        \
+      .compare = NAME##_internal_compare,                                      \
+      .overwrite = NAME##_internal_insert,                                     \
+      .element_size = sizeof(TYPE),                                            \
+  };                                                                           \
+                                                                               \
+  static usize NAME##_internal_find(const NAME *table, const TYPE *element,    \
+                                    u64 hash) {                                \
+    debug_check(table);                                                        \
+    debug_check(element);                                                      \
+                                                                               \
+    const usize mask = table->end - 1;                                         \
+    const u8 control_byte = table_internal_hash_to_control_byte(hash);         \
+    const byte *control = (const byte *)(table->element + table->end);         \
+    usize index = hash & mask;                                                 \
+                                                                               \
+    while (1) {                                                                \
+      TableGroupMask poss_bitmask =                                            \
+          table_group_match(control + index, control_byte);                    \
+      while (poss_bitmask) {                                                   \
+        const usize real_index =                                               \
+            (index + table_group_mask_lowest(poss_bitmask)) & mask;            \
+        if (EQUAL(element, &table->element[real_index])) {                     \
+          return real_index;                                                   \
+        }                                                                      \
+        poss_bitmask = table_group_mask_clear_lowest(poss_bitmask);            \
+      }                                                                        \
+                                                                               \
+      const TableGroupMask empty_bitmask =                                     \
+          table_group_match_free(control + index);                             \
+      if (LIKELY(empty_bitmask)) {                                             \
+        return (index + table_group_mask_lowest(empty_bitmask)) & mask;        \
+      }                                                                        \
+      index += TABLE_GROUP_WIDTH;                                              \
+      index &= mask;                                                           \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static void NAME##_init(NAME *table, usize initial_capacity,                 \
+                          Allocator *allocator, Error *error) {                \
+    table_init(table, &NAME##_vtable, initial_capacity, allocator, error);     \
+  }                                                                            \
+                                                                               \
+  static void NAME##_deinit(NAME *table, Allocator *allocator) {               \
+    table_deinit(table, allocator);                                            \
+  }                                                                            \
+                                                                               \
+  static usize NAME##_find(const NAME *table, const TYPE *element) {           \
+    return NAME##_internal_find(table, element, HASH(element));                \
+  }                                                                            \
+                                                                               \
+  static bool NAME##_isset(const NAME *table, usize index) {                   \
+    debug_check(table);                                                        \
+    debug_check(table->end > index);                                           \
+                                                                               \
+    const byte *control = (const byte *)(table->element + table->end);         \
+    return control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK;                 \
+  }                                                                            \
+                                                                               \
+  static bool NAME##_contains(const NAME *table, const TYPE *element) {        \
+    return NAME##_isset(table, NAME##_find(table, element));                   \
+  }                                                                            \
+                                                                               \
+  /* returns the slot of `element`, inserting it if it is not present. */      \
+  /* `*inserted` tells whether it was inserted */                              \
+  static usize NAME##_internal_upsert(NAME *table, const TYPE *element,        \
+                                      bool *inserted, Allocator *allocator,    \
+                                      Error *error) {                          \
+    debug_check(table);                                                        \
+    debug_check(element);                                                      \
+    debug_check(allocator);                                                    \
+                                                                               \
+    if (UNLIKELY(table->length + table->tombs >=                               \
+                 table->end - table->end / 8)) {                               \
+      table_internal_should_grow(table, &NAME##_vtable, allocator, error);     \
+      if (UNLIKELY(error && *error)) {                                         \
+        return -1;                                                             \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    const u64 hash = HASH(element);                                            \
+    const usize index = NAME##_internal_find(table, element, hash);            \
+    byte *control = (byte *)(table->element + table->end);                     \
+    *inserted = !(control[index] & TABLE_INTERNAL_CONTROL_ISSET_MASK);         \
+    if (*inserted) {                                                           \
+      table_internal_set_control(control, table->end, index,                   \
+                                 table_internal_hash_to_control_byte(hash));   \
+      table->element[index] = *element;                                        \
+      table->length += 1;                                                      \
+    }                                                                          \
+    return index;                                                              \
+  }                                                                            \
+                                                                               \
+  static usize NAME##_insert(NAME *table, const TYPE *element,                 \
+                             Allocator *allocator, Error *error) {             \
+    bool inserted = false;                                                     \
+    const usize index =                                                        \
+        NAME##_internal_upsert(table, element, &inserted, allocator, error);   \
+    if (UNLIKELY(error && *error)) {                                           \
+      return -1;                                                               \
+    }                                                                          \
+    if (!inserted) {                                                           \
+      table->element[index] = *element;                                        \
+    }                                                                          \
+    return index;                                                              \
+  }                                                                            \
+                                                                               \
+  static usize NAME##_upsert(NAME *table, const TYPE *element,                 \
+                             Allocator *allocator, Error *error) {             \
+    bool inserted = false;                                                     \
+    return NAME##_internal_upsert(table, element, &inserted, allocator,        \
+                                  error);                                      \
+  }                                                                            \
+                                                                               \
+  static bool NAME##_remove(NAME *table, const TYPE *element) {                \
+    debug_check(table);                                                        \
+    debug_check(element);                                                      \
+                                                                               \
+    const usize index = NAME##_find(table, element);                           \
+    if (!NAME##_isset(table, index)) {                                         \
+      return false;                                                            \
+    }                                                                          \
+    byte *control = (byte *)(table->element + table->end);                     \
+    if (table_internal_control_erase(control, table->end, index)) {            \
+      table->tombs += 1;                                                       \
+    }                                                                          \
+    table->length -= 1;                                                        \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  static void NAME##_reserve(NAME *table, usize capacity,                      \
+                             Allocator *allocator, Error *error) {             \
+    table_reserve(table, &NAME##_vtable, capacity, allocator, error);          \
+  }                                                                            \
+                                                                               \
+  static void NAME##_shrink(NAME *table, Allocator *allocator,                 \
+                            Error *error) {                                    \
+    table_shrink(table, &NAME##_vtable, allocator, error);                     \
+  }                                                                            \
+                                                                               \
+  static bool NAME##_next(const NAME *table, TableIter *iter) {                \
+    return table_next(table, &NAME##_vtable, iter);                            \
+  }                                                                            \
+                                                                               \
+  static void NAME##_dummy_callee__(void);                                     \
+  static void NAME##_dummy_caller__(void) {                                    \
+    NAME##_init(NULL, 0, NULL, NULL);                                          \
+    NAME##_deinit(NULL, NULL);                                                 \
+    NAME##_contains(NULL, NULL);                                               \
+    NAME##_insert(NULL, NULL, NULL, NULL);                                     \
+    NAME##_upsert(NULL, NULL, NULL, NULL);                                     \
+    NAME##_remove(NULL, NULL);                                                 \
+    NAME##_reserve(NULL, 0, NULL, NULL);                                       \
+    NAME##_shrink(NULL, NULL, NULL);                                           \
+    NAME##_next(NULL, NULL);                                                   \
+    NAME##_dummy_callee__();                                                   \
+  }                                                                            \
+  static void NAME##_dummy_callee__(void) { NAME##_dummy_caller__(); }
+
+#endif // TABLE_DEFINE_H_
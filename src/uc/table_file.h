@@ -0,0 +1,483 @@
+#ifndef TABLE_FILE_H_
+#define TABLE_FILE_H_
+
+#include <uc/allocator.h>
+#include <uc/table.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/***
+ * @file
+ * Tables which live in a memory mapped file and survive restarts. Requires a
+ * POSIX system.
+ *
+ * The file is a `TableFileHeader` followed by the single allocations of the
+ * table, laid out exactly like in memory, so every function of `table.h`
+ * works on the mapped table. The `TableFile` is the allocator of the table:
+ * allocating extends the file and maps the new part at the end of the
+ * existing mapping, which never moves as the address space for `max_size`
+ * bytes is reserved up front. Growing is always incremental (see
+ * `TableVTable.migrate_groups`), the old array is migrated by the following
+ * inserts and then left behind as dead space, so the file is at most about
+ * twice the size of the live table.
+ *
+ * Changes reach the file whenever the kernel writes back the pages, only
+ * `table_file_sync` makes them durable. A file which was modified after its
+ * last sync is marked as dirty and refused by `table_file_open`, as a crash
+ * could have left it inconsistent.
+ *
+ * Elements are copied byte by byte, so only plain data without pointers can
+ * be stored, with the same restrictions as `table_snapshot.h`.
+ */
+
+#define TABLE_FILE_MAGIC "UCTFILE"
+#define TABLE_FILE_VERSION 1
+// written as a native u32, reads back differently on the other byte order
+#define TABLE_FILE_BYTE_ORDER 0x01020304u
+// used if `vtable->migrate_groups` is `0`
+#define TABLE_FILE_MIGRATE_GROUPS 4
+// allocations in the file start at multiples of this
+#define TABLE_FILE_INTERNAL_ALIGN 64
+
+/***
+ * @doc(type): TableFileHeader
+ * @tag: all
+ *
+ * @brief: Header at the start of every table file, 128 bytes. Offsets are
+ * relative to the start of the file.
+ *
+ * @member(size): bytes of the file which are in use
+ *
+ * @member(clean): `0` while the file has changes which were not synced
+ */
+typedef struct TableFileHeader TableFileHeader;
+struct TableFileHeader {
+  char magic[8];
+  u32 version;
+  u32 byte_order;
+  u32 group_width;
+  u32 store_hash;
+  u64 element_size;
+  u64 value_size;
+  u64 length;
+  u64 end;
+  u64 tombs;
+  u64 offset;
+  u64 old_end;
+  u64 old_offset;
+  u64 migrated;
+  u64 size;
+  u64 clean;
+  u64 reserved[2];
+};
+
+/***
+ * @doc(type): TableFile
+ * @tag: all
+ *
+ * @brief: Table in a mapped file, see the file documentation.
+ *
+ * @detailed: A `TableFile *` is also the `Allocator` of its table. Lookups
+ * use `table_find`, `table_get` and the rest of `table.h` on `table`
+ * directly, modifications go through `table_file_insert`,
+ * `table_file_upsert` and `table_file_remove`, which keep the header up to
+ * date.
+ *
+ * @member(table): the mapped table
+ */
+typedef struct TableFile TableFile;
+struct TableFile {
+  const AllocatorVTable *vtable;
+  Table(byte) table;
+  byte *base;
+  usize max_size;
+  int fd;
+};
+
+static TableFileHeader *table_file_internal_header(const TableFile *file) {
+  return (TableFileHeader *)file->base;
+}
+
+// extends the file to at least `size` bytes and maps the first `size`. Data
+// which is already in the file is never written
+static void table_file_internal_extend(TableFile *file, usize size,
+                                       Error *error) {
+  if (UNLIKELY(size > file->max_size)) {
+    if (error) {
+      *error = ENOMEM;
+    }
+    return;
+  }
+  struct stat st;
+  if (UNLIKELY(fstat(file->fd, &st) != 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+  const byte zero = 0;
+  if ((usize)st.st_size < size &&
+      UNLIKELY(lseek(file->fd, (off_t)size - 1, SEEK_SET) < 0 ||
+               write(file->fd, &zero, 1) != 1)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+  void *base = mmap(file->base, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED, file->fd, 0);
+  if (UNLIKELY(base == MAP_FAILED)) {
+    if (error) {
+      *error = errno;
+    }
+  }
+}
+
+static void *table_file_internal_alloc(Allocator *allocator, usize num_bytes,
+                                       Error *error) {
+  debug_check(allocator);
+
+  TableFile *file = allocator;
+  TableFileHeader *header = table_file_internal_header(file);
+  const usize offset = header->size;
+  const usize size = (offset + num_bytes + TABLE_FILE_INTERNAL_ALIGN - 1) &
+                     ~(usize)(TABLE_FILE_INTERNAL_ALIGN - 1);
+  Error extend_error = 0;
+  table_file_internal_extend(file, size, &extend_error);
+  if (UNLIKELY(extend_error)) {
+    if (error) {
+      *error = extend_error;
+    }
+    return NULL;
+  }
+  header->size = size;
+  return file->base + offset;
+}
+
+// the space of freed arrays is not reused
+static void table_file_internal_free(Allocator *allocator, void *chunk) {
+  UNUSED(allocator);
+  UNUSED(chunk);
+}
+
+// tables never reallocate their chunks
+static void *table_file_internal_realloc(Allocator *allocator, void *chunk,
+                                         usize num_bytes, Error *error) {
+  UNUSED(allocator);
+  UNUSED(chunk);
+  UNUSED(num_bytes);
+  if (error) {
+    *error = EINVAL;
+  }
+  return NULL;
+}
+
+static const AllocatorVTable *table_file_internal_vtable = &(AllocatorVTable){
+    .alloc = table_file_internal_alloc,
+    .realloc = table_file_internal_realloc,
+    .free = table_file_internal_free,
+};
+
+// `vtable` with incremental growing
+static void table_file_internal_table_vtable(TableVTable *internal,
+                                             const TableVTable *vtable) {
+  *internal = *vtable;
+  if (!internal->migrate_groups) {
+    internal->migrate_groups = TABLE_FILE_MIGRATE_GROUPS;
+  }
+}
+
+// writes the state of the table to the header
+static void table_file_internal_store(TableFile *file) {
+  TableFileHeader *header = table_file_internal_header(file);
+  const Table(byte) *table = (Table *)&file->table;
+  header->length = table->length;
+  header->end = table->end;
+  header->tombs = table->tombs;
+  header->offset = (usize)(table->element - file->base);
+  header->old_end = table->old_end;
+  header->old_offset =
+      table->old_element ? (usize)(table->old_element - file->base) : 0;
+  header->migrated = table->migrated;
+}
+
+// marks the file as dirty on disk before the first change after a sync,
+// returns `false` if that failed and the table must not be changed
+static bool table_file_internal_dirty(TableFile *file, Error *error) {
+  TableFileHeader *header = table_file_internal_header(file);
+  if (LIKELY(!header->clean)) {
+    return true;
+  }
+  header->clean = 0;
+  if (UNLIKELY(msync(file->base, sizeof(*header), MS_SYNC) != 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return false;
+  }
+  return true;
+}
+
+/***
+ * @doc(function): table_file_open
+ * @tag: all
+ *
+ * @brief: Opens the table file at `path`, creating it if it does not exist
+ * or is empty.
+ *
+ * @param(vtable): `element_size`, `store_hash` and `value_size` have to match
+ * the file
+ *
+ * @param(initial_capacity): capacity of a newly created table
+ *
+ * @param(max_size): maximum size of the file in bytes, the address space for
+ * it is reserved up front. `0` reserves 1 TiB on 64 bit targets
+ *
+ * @param(error): set to `errno` if the file could not be opened or mapped,
+ * or to `EINVAL` if it is not a compatible table file or is dirty
+ */
+static void table_file_open(TableFile *file, const TableVTable *vtable,
+                            const char *path, usize initial_capacity,
+                            usize max_size, Error *error) {
+  debug_check(file);
+  debug_check(vtable);
+  debug_check(path);
+  // the header is padded so that the first allocation is aligned
+  debug_check(sizeof(TableFileHeader) % TABLE_FILE_INTERNAL_ALIGN == 0);
+
+  builtin_memset(file, 0, sizeof(*file));
+  file->vtable = table_file_internal_vtable;
+  file->max_size =
+      max_size ? max_size : (usize)1 << (sizeof(usize) >= 8 ? 40 : 30);
+
+  file->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (UNLIKELY(file->fd < 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+
+  Error local_error = 0;
+  struct stat st;
+  if (UNLIKELY(fstat(file->fd, &st) != 0)) {
+    local_error = errno;
+    goto fail_close;
+  }
+
+  // reserves the address space, the file is mapped into it as it grows
+  void *base =
+      mmap(NULL, file->max_size, PROT_NONE, MAP_SHARED, file->fd, 0);
+  if (UNLIKELY(base == MAP_FAILED)) {
+    local_error = errno;
+    goto fail_close;
+  }
+  file->base = base;
+
+  if (!st.st_size) {
+    table_file_internal_extend(file, sizeof(TableFileHeader), &local_error);
+    if (UNLIKELY(local_error)) {
+      goto fail_unmap;
+    }
+    TableFileHeader *header = table_file_internal_header(file);
+    builtin_memcpy(header->magic, TABLE_FILE_MAGIC, sizeof(TABLE_FILE_MAGIC));
+    header->version = TABLE_FILE_VERSION;
+    header->byte_order = TABLE_FILE_BYTE_ORDER;
+    header->group_width = TABLE_GROUP_WIDTH;
+    header->store_hash = vtable->store_hash;
+    header->element_size = vtable->element_size;
+    header->value_size = vtable->value_size;
+    header->size = sizeof(TableFileHeader);
+
+    table_init(&file->table, vtable, initial_capacity, file, &local_error);
+    if (UNLIKELY(local_error)) {
+      goto fail_unmap;
+    }
+    table_file_internal_store(file);
+    return;
+  }
+
+  const usize size = (usize)st.st_size;
+  TableFileHeader header = {0};
+  if (UNLIKELY(size < sizeof(header) ||
+               read(file->fd, &header, sizeof(header)) !=
+                   (ssize_t)sizeof(header))) {
+    local_error = EINVAL;
+    goto fail_unmap;
+  }
+
+  const bool compatible =
+      builtin_memcmp(header.magic, TABLE_FILE_MAGIC,
+                     sizeof(TABLE_FILE_MAGIC)) == 0 &&
+      header.version == TABLE_FILE_VERSION &&
+      header.byte_order == TABLE_FILE_BYTE_ORDER &&
+      header.group_width == TABLE_GROUP_WIDTH &&
+      header.store_hash == vtable->store_hash &&
+      header.element_size == vtable->element_size &&
+      header.value_size == vtable->value_size && header.clean &&
+      header.size <= size && header.size <= file->max_size &&
+      header.offset + table_internal_chunk_size(vtable, header.end) <=
+          header.size &&
+      (!header.old_end ||
+       header.old_offset + table_internal_chunk_size(vtable, header.old_end) <=
+           header.size);
+  if (UNLIKELY(!compatible)) {
+    local_error = EINVAL;
+    goto fail_unmap;
+  }
+
+  table_file_internal_extend(file, header.size, &local_error);
+  if (UNLIKELY(local_error)) {
+    goto fail_unmap;
+  }
+  Table(byte) *table = (Table *)&file->table;
+  table->element = file->base + header.offset;
+  table->length = header.length;
+  table->end = header.end;
+  table->tombs = header.tombs;
+  table->old_element = header.old_end ? file->base + header.old_offset : NULL;
+  table->old_end = header.old_end;
+  table->migrated = header.migrated;
+  return;
+
+fail_unmap:
+  (void)munmap(file->base, file->max_size);
+fail_close:
+  (void)close(file->fd);
+  builtin_memset(file, 0, sizeof(*file));
+  if (error) {
+    *error = local_error;
+  }
+}
+
+/***
+ * @doc(function): table_file_sync
+ * @tag: all
+ *
+ * @brief: Writes all changes to the disk and marks the file as clean. Returns
+ * once they are durable.
+ *
+ * @param(error): set to `errno` if writing failed
+ */
+static void table_file_sync(TableFile *file, Error *error) {
+  debug_check(file);
+
+  TableFileHeader *header = table_file_internal_header(file);
+  table_file_internal_store(file);
+  if (UNLIKELY(msync(file->base, header->size, MS_SYNC) != 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+  header->clean = 1;
+  if (UNLIKELY(msync(file->base, sizeof(*header), MS_SYNC) != 0 && error)) {
+    *error = errno;
+  }
+}
+
+/***
+ * @doc(function): table_file_close
+ * @tag: all
+ *
+ * @brief: Syncs the file and releases the mapping. Elements are not
+ * destroyed.
+ *
+ * @param(error): set to `errno` if the final sync failed, the file is closed
+ * either way
+ */
+static void table_file_close(TableFile *file, Error *error) {
+  debug_check(file);
+
+  table_file_sync(file, error);
+  (void)munmap(file->base, file->max_size);
+  (void)close(file->fd);
+  builtin_memset(file, 0, sizeof(*file));
+}
+
+/***
+ * @doc(function): table_file_insert
+ * @tag: all
+ *
+ * @brief: `table_insert` on the table of `file`, growing the file if needed.
+ *
+ * @param(error): set to `ENOMEM` if the file would grow beyond `max_size`,
+ * or to `errno` if it could not be extended or marked as dirty, in which
+ * case `-1` is returned and the table is unchanged
+ */
+static usize table_file_insert(TableFile *file, const TableVTable *vtable,
+                               const void *element, Error *error) {
+  debug_check(file);
+  debug_check(vtable);
+
+  TableVTable internal;
+  table_file_internal_table_vtable(&internal, vtable);
+  if (UNLIKELY(!table_file_internal_dirty(file, error))) {
+    return -1;
+  }
+  const usize index =
+      table_insert(&file->table, &internal, element, file, error);
+  table_file_internal_store(file);
+  return index;
+}
+
+/***
+ * @doc(function): table_file_upsert
+ * @tag: all
+ *
+ * @brief: `table_upsert` on the table of `file`, see `table_file_insert`.
+ */
+static usize table_file_upsert(TableFile *file, const TableVTable *vtable,
+                               const void *element, Error *error) {
+  debug_check(file);
+  debug_check(vtable);
+
+  TableVTable internal;
+  table_file_internal_table_vtable(&internal, vtable);
+  if (UNLIKELY(!table_file_internal_dirty(file, error))) {
+    return -1;
+  }
+  const usize index =
+      table_upsert(&file->table, &internal, element, file, error);
+  table_file_internal_store(file);
+  return index;
+}
+
+/***
+ * @doc(function): table_file_remove
+ * @tag: all
+ *
+ * @brief: `table_remove` on the table of `file`.
+ *
+ * @param(error): set to `errno` if the file could not be marked as dirty, in
+ * which case `false` is returned and the table is unchanged
+ */
+static bool table_file_remove(TableFile *file, const TableVTable *vtable,
+                              const void *element, Error *error) {
+  debug_check(file);
+  debug_check(vtable);
+
+  if (UNLIKELY(!table_file_internal_dirty(file, error))) {
+    return false;
+  }
+  const bool removed = table_remove(&file->table, vtable, element);
+  table_file_internal_store(file);
+  return removed;
+}
+
+static void table_file_dummy_callee__(void);
+static void table_file_dummy_caller__(void) {
+  table_file_open(NULL, NULL, NULL, 0, 0, NULL);
+  table_file_sync(NULL, NULL);
+  table_file_close(NULL, NULL);
+  table_file_insert(NULL, NULL, NULL, NULL);
+  table_file_upsert(NULL, NULL, NULL, NULL);
+  table_file_remove(NULL, NULL, NULL, NULL);
+  table_file_dummy_callee__();
+}
+static void table_file_dummy_callee__(void) { table_file_dummy_caller__(); }
+
+#endif // TABLE_FILE_H_
@@ -0,0 +1,202 @@
+#ifndef TABLE_GROUP_H_
+#define TABLE_GROUP_H_
+
+#include <uc/builtin.h>
+#include <uc/types.h>
+
+/***
+ * @file
+ * Matching operations on groups of control bytes used by `table.h`.
+ *
+ * A group is `TABLE_GROUP_WIDTH` consecutive control bytes. A free slot is
+ * `0`, a tomb has the high bit cleared and a set slot has the high bit set.
+ * Each match returns a `TableGroupMask` with exactly one bit per matching
+ * slot, which has to be decoded with `table_group_mask_lowest` and friends.
+ *
+ * The implementation is selected at compile time. AVX2 (32 slots), NEON (16
+ * slots), SSE2 (16 slots) and a portable 64 bit SWAR fallback (8 slots) are
+ * available, the widest one supported by the target is used unless one is
+ * forced by defining `TABLE_GROUP_FORCE_AVX2`, `TABLE_GROUP_FORCE_NEON`,
+ * `TABLE_GROUP_FORCE_SSE2` or `TABLE_GROUP_FORCE_SWAR`.
+ */
+
+#if defined(TABLE_GROUP_FORCE_SWAR)
+#define TABLE_GROUP_SWAR
+#elif defined(TABLE_GROUP_FORCE_SSE2)
+#define TABLE_GROUP_SSE2
+#elif defined(TABLE_GROUP_FORCE_AVX2)
+#define TABLE_GROUP_AVX2
+#elif defined(TABLE_GROUP_FORCE_NEON)
+#define TABLE_GROUP_NEON
+#elif defined(__AVX2__)
+#define TABLE_GROUP_AVX2
+#elif defined(__SSE2__)
+#define TABLE_GROUP_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define TABLE_GROUP_NEON
+#else
+#define TABLE_GROUP_SWAR
+#endif
+
+typedef u64 TableGroupMask;
+
+#if defined(TABLE_GROUP_AVX2)
+#include <immintrin.h>
+#define TABLE_GROUP_NAME "avx2"
+#define TABLE_GROUP_WIDTH 32
+// log2 of the number of mask bits per slot
+#define TABLE_GROUP_INTERNAL_SHIFT 0
+// mask with the bit of every slot set
+#define TABLE_GROUP_INTERNAL_ALL 0xffffffffull
+#elif defined(TABLE_GROUP_SSE2)
+#include <emmintrin.h>
+#define TABLE_GROUP_NAME "sse2"
+#define TABLE_GROUP_WIDTH 16
+#define TABLE_GROUP_INTERNAL_SHIFT 0
+#define TABLE_GROUP_INTERNAL_ALL 0xffffull
+#elif defined(TABLE_GROUP_NEON)
+#include <arm_neon.h>
+#define TABLE_GROUP_NAME "neon"
+#define TABLE_GROUP_WIDTH 16
+#define TABLE_GROUP_INTERNAL_SHIFT 2
+#define TABLE_GROUP_INTERNAL_ALL 0x8888888888888888ull
+#else
+#define TABLE_GROUP_NAME "swar"
+#define TABLE_GROUP_WIDTH 8
+#define TABLE_GROUP_INTERNAL_SHIFT 3
+#define TABLE_GROUP_INTERNAL_ALL 0x8080808080808080ull
+#endif
+
+#if defined(TABLE_GROUP_AVX2)
+
+static TableGroupMask table_group_match(const byte *control, u8 control_byte) {
+  const __m256i data = _mm256_loadu_si256((const __m256i_u *)control);
+  return (u32)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_set1_epi8((char)control_byte), data));
+}
+
+static TableGroupMask table_group_match_free(const byte *control) {
+  const __m256i data = _mm256_loadu_si256((const __m256i_u *)control);
+  return (u32)_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_setzero_si256(), data));
+}
+
+static TableGroupMask table_group_match_non_full(const byte *control) {
+  const __m256i data = _mm256_loadu_si256((const __m256i_u *)control);
+  return (u32)~_mm256_movemask_epi8(data);
+}
+
+#elif defined(TABLE_GROUP_SSE2)
+
+static TableGroupMask table_group_match(const byte *control, u8 control_byte) {
+  const __m128i data = _mm_loadu_si128((const __m128i_u *)control);
+  return (u32)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_set1_epi8((char)control_byte), data));
+}
+
+static TableGroupMask table_group_match_free(const byte *control) {
+  const __m128i data = _mm_loadu_si128((const __m128i_u *)control);
+  return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_setzero_si128(), data));
+}
+
+static TableGroupMask table_group_match_non_full(const byte *control) {
+  const __m128i data = _mm_loadu_si128((const __m128i_u *)control);
+  return ~(u32)_mm_movemask_epi8(data) & TABLE_GROUP_INTERNAL_ALL;
+}
+
+#elif defined(TABLE_GROUP_NEON)
+
+// NEON has no movemask, narrowing each 16 bit lane by 4 bits leaves 4 bits
+// per slot, of which only the highest one is kept
+static TableGroupMask table_group_internal_neon_mask(uint8x16_t compared) {
+  const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(compared), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) &
+         TABLE_GROUP_INTERNAL_ALL;
+}
+
+static TableGroupMask table_group_match(const byte *control, u8 control_byte) {
+  return table_group_internal_neon_mask(
+      vceqq_u8(vld1q_u8(control), vdupq_n_u8(control_byte)));
+}
+
+static TableGroupMask table_group_match_free(const byte *control) {
+  return table_group_internal_neon_mask(vceqzq_u8(vld1q_u8(control)));
+}
+
+static TableGroupMask table_group_match_non_full(const byte *control) {
+  return table_group_internal_neon_mask(
+      vcgezq_s8(vreinterpretq_s8_u8(vld1q_u8(control))));
+}
+
+#else
+
+static u64 table_group_internal_swar_load(const byte *control) {
+  u64 data;
+  builtin_memcpy(&data, control, sizeof(data));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  data = builtin_bswap64(data);
+#endif
+  return data;
+}
+
+// sets the high bit of every zero byte. Unlike the common `(x - 0x01..) & ~x`
+// trick this never carries into the next byte, so there are no false positives
+static u64 table_group_internal_swar_zero(u64 data) {
+  const u64 low = 0x7f7f7f7f7f7f7f7full;
+  return ~(((data & low) + low) | data) & TABLE_GROUP_INTERNAL_ALL;
+}
+
+static TableGroupMask table_group_match(const byte *control, u8 control_byte) {
+  const u64 broadcast = 0x0101010101010101ull * control_byte;
+  return table_group_internal_swar_zero(
+      table_group_internal_swar_load(control) ^ broadcast);
+}
+
+static TableGroupMask table_group_match_free(const byte *control) {
+  return table_group_internal_swar_zero(
+      table_group_internal_swar_load(control));
+}
+
+static TableGroupMask table_group_match_non_full(const byte *control) {
+  return ~table_group_internal_swar_load(control) & TABLE_GROUP_INTERNAL_ALL;
+}
+
+#endif
+
+// bitmask of the set slots in the group starting at `control`
+static TableGroupMask table_group_match_full(const byte *control) {
+  return table_group_match_non_full(control) ^ TABLE_GROUP_INTERNAL_ALL;
+}
+
+// index of the first matching slot
+// @assert: `mask != 0`
+static usize table_group_mask_lowest(TableGroupMask mask) {
+  return builtin_ctzll(mask) >> TABLE_GROUP_INTERNAL_SHIFT;
+}
+
+// number of non matching slots at the end of the group
+// @assert: `mask != 0`
+static usize table_group_mask_leading(TableGroupMask mask) {
+  return (builtin_clzll(mask) -
+          (64 - (TABLE_GROUP_WIDTH << TABLE_GROUP_INTERNAL_SHIFT))) >>
+         TABLE_GROUP_INTERNAL_SHIFT;
+}
+
+// removes the first matching slot from `mask`
+static TableGroupMask table_group_mask_clear_lowest(TableGroupMask mask) {
+  return mask & (mask - 1);
+}
+
+static void table_group_dummy_callee__(void);
+static void table_group_dummy_caller__(void) {
+  table_group_match(NULL, 0);
+  table_group_match_free(NULL);
+  table_group_match_full(NULL);
+  table_group_mask_lowest(0);
+  table_group_mask_leading(0);
+  table_group_mask_clear_lowest(0);
+  table_group_dummy_callee__();
+}
+static void table_group_dummy_callee__(void) { table_group_dummy_caller__(); }
+
+#endif // TABLE_GROUP_H_
@@ -0,0 +1,291 @@
+#ifndef TABLE_SHARDED_H_
+#define TABLE_SHARDED_H_
+
+#include <uc/table.h>
+#include <uc/thread.h>
+
+/***
+ * @file
+ * Table which can be used from multiple threads at once. Requires `thread.h`
+ * and therefore `-pthread`.
+ *
+ * The elements are split into independent `Table` shards by the hash bits
+ * right below the 7 bits stored in the control bytes, which are not used for
+ * the slot index of any reasonably sized shard. Every shard has its own
+ * `RwLock` and grows on its own, so threads working on different shards never
+ * wait for each other and lookups within a shard run in parallel.
+ *
+ * Elements never leave the table by reference, they are copied out while the
+ * shard is locked, so `vtable->value_size` has to be `0`. The allocator has to
+ * be thread safe, like `allocator_global`.
+ */
+
+// shards start on their own cache lines to avoid false sharing. The
+// alignment rounds the size up to whole lines and the shard array is aligned
+// by hand, as allocators only guarantee 16 bytes
+#define TABLE_SHARDED_INTERNAL_CACHE_LINE 64
+
+typedef struct TableShard TableShard;
+struct __attribute__((aligned(TABLE_SHARDED_INTERNAL_CACHE_LINE))) TableShard {
+  RwLock lock;
+  Table(byte) table;
+};
+
+/***
+ * @doc(type): TableSharded
+ * @tag: all
+ *
+ * @brief: Concurrent table, see the file documentation.
+ *
+ * @member(shard): array of `num_shards` shards, aligned to a cache line
+ *
+ * @member(memory): allocation holding `shard`
+ *
+ * @member(num_shards): power of two
+ *
+ * @member(shift): shard of a hash is `(hash >> shift) & (num_shards - 1)`
+ */
+typedef struct TableSharded TableSharded;
+struct TableSharded {
+  TableShard *shard;
+  void *memory;
+  usize num_shards;
+  usize shift;
+};
+
+#define TABLE_SHARDED_INTERNAL_MAX_BITS 16
+
+static TableShard *table_sharded_internal_shard(const TableSharded *table,
+                                                u64 hash) {
+  return &table->shard[(hash >> table->shift) & (table->num_shards - 1)];
+}
+
+/***
+ * @doc(function): table_sharded_init
+ * @tag: all
+ *
+ * @brief: Initializes a sharded table. Not thread safe.
+ *
+ * @param(num_shards): rounded up to a power of two and at most `1 << 16`. A
+ * few times the number of threads using the table is a good choice
+ *
+ * @param(initial_capacity): capacity of the whole table, split evenly
+ * between the shards
+ */
+static void table_sharded_init(TableSharded *table, const TableVTable *vtable,
+                               usize num_shards, usize initial_capacity,
+                               Allocator *allocator, Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(!vtable->value_size);
+  debug_check(allocator);
+
+  usize bits = 0;
+  while (((usize)1 << bits) < num_shards &&
+         bits < TABLE_SHARDED_INTERNAL_MAX_BITS) {
+    bits += 1;
+  }
+  table->num_shards = (usize)1 << bits;
+  // the control byte uses the top 7 bits
+  table->shift = 57 - bits;
+
+  const uintptr_t line = TABLE_SHARDED_INTERNAL_CACHE_LINE;
+  table->memory = allocator_alloc(
+      allocator, table->num_shards * sizeof(*table->shard) + line - 1, error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+  table->shard =
+      (TableShard *)(((uintptr_t)table->memory + line - 1) & ~(line - 1));
+  builtin_memset(table->shard, 0, table->num_shards * sizeof(*table->shard));
+
+  const usize capacity = initial_capacity / table->num_shards;
+  for (usize i = 0; i < table->num_shards; ++i) {
+    table_init(&table->shard[i].table, vtable, capacity ? capacity : 1,
+               allocator, error);
+    if (UNLIKELY(error && *error)) {
+      for (usize j = 0; j < i; ++j) {
+        table_deinit(&table->shard[j].table, allocator);
+      }
+      allocator_free(allocator, table->memory);
+      return;
+    }
+  }
+}
+
+/***
+ * @doc(function): table_sharded_deinit
+ * @tag: all
+ *
+ * @brief: Frees all shards. Not thread safe. Elements are not destroyed, as
+ * with `table_deinit`.
+ */
+static void table_sharded_deinit(TableSharded *table, Allocator *allocator) {
+  debug_check(table);
+  debug_check(allocator);
+
+  for (usize i = 0; i < table->num_shards; ++i) {
+    table_deinit(&table->shard[i].table, allocator);
+  }
+  allocator_free(allocator, table->memory);
+}
+
+/***
+ * @doc(function): table_sharded_get
+ * @tag: all
+ *
+ * @brief: Copies the element equal to `element` into `out`.
+ *
+ * @param(out): receives a bitwise copy of the found element, may be `NULL`
+ * if only the presence is of interest. May be the same as `element`
+ *
+ * @return: `true` if the element was found
+ */
+static bool table_sharded_get(const TableSharded *table,
+                              const TableVTable *vtable, const void *element,
+                              void *out) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  TableShard *shard = table_sharded_internal_shard(table, hash);
+
+  rw_lock_read(&shard->lock);
+  const usize index =
+      table_internal_lookup(&shard->table, vtable, element, hash);
+  const bool found = table_isset(&shard->table, vtable, index);
+  if (found && out) {
+    builtin_memmove(out, table_get(&shard->table, vtable, index),
+                    vtable->element_size);
+  }
+  rw_lock_read_unlock(&shard->lock);
+  return found;
+}
+
+/***
+ * @doc(function): table_sharded_contains
+ * @tag: all
+ *
+ * @brief: Returns `true` if an element equal to `element` is present.
+ */
+static bool table_sharded_contains(const TableSharded *table,
+                                   const TableVTable *vtable,
+                                   const void *element) {
+  return table_sharded_get(table, vtable, element, NULL);
+}
+
+/***
+ * @doc(function): table_sharded_insert
+ * @tag: all
+ *
+ * @brief: Inserts `element`, overwriting an equal element, like
+ * `table_insert`.
+ */
+static void table_sharded_insert(TableSharded *table,
+                                 const TableVTable *vtable,
+                                 const void *element, Allocator *allocator,
+                                 Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  TableShard *shard = table_sharded_internal_shard(table, hash);
+
+  rw_lock_write(&shard->lock);
+  table_internal_insert_hashed(&shard->table, vtable, element, hash, true,
+                               allocator, error);
+  rw_lock_write_unlock(&shard->lock);
+}
+
+/***
+ * @doc(function): table_sharded_upsert
+ * @tag: all
+ *
+ * @brief: Inserts `element` unless an equal element is present, like
+ * `table_upsert`.
+ *
+ * @return: `true` if `element` was inserted
+ */
+static bool table_sharded_upsert(TableSharded *table,
+                                 const TableVTable *vtable,
+                                 const void *element, Allocator *allocator,
+                                 Error *error) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  TableShard *shard = table_sharded_internal_shard(table, hash);
+
+  rw_lock_write(&shard->lock);
+  const usize length = shard->table.length;
+  table_internal_insert_hashed(&shard->table, vtable, element, hash, false,
+                               allocator, error);
+  const bool inserted = shard->table.length != length;
+  rw_lock_write_unlock(&shard->lock);
+  return inserted;
+}
+
+/***
+ * @doc(function): table_sharded_remove
+ * @tag: all
+ *
+ * @brief: Removes the element equal to `element`, like `table_remove`.
+ *
+ * @return: `true` if the element was present
+ */
+static bool table_sharded_remove(TableSharded *table,
+                                 const TableVTable *vtable,
+                                 const void *element) {
+  debug_check(table);
+  debug_check(vtable);
+  debug_check(element);
+
+  const u64 hash = vtable->hash(element, vtable->ctx);
+  TableShard *shard = table_sharded_internal_shard(table, hash);
+
+  rw_lock_write(&shard->lock);
+  const bool removed =
+      table_internal_remove_hashed(&shard->table, vtable, element, hash);
+  rw_lock_write_unlock(&shard->lock);
+  return removed;
+}
+
+/***
+ * @doc(function): table_sharded_length
+ * @tag: all
+ *
+ * @brief: Number of elements. Shards are counted one after another, so with
+ * concurrent writers the result is only approximate.
+ */
+static usize table_sharded_length(const TableSharded *table) {
+  debug_check(table);
+
+  usize length = 0;
+  for (usize i = 0; i < table->num_shards; ++i) {
+    TableShard *shard = &table->shard[i];
+    rw_lock_read(&shard->lock);
+    length += shard->table.length;
+    rw_lock_read_unlock(&shard->lock);
+  }
+  return length;
+}
+
+static void table_sharded_dummy_callee__(void);
+static void table_sharded_dummy_caller__(void) {
+  table_sharded_init(NULL, NULL, 0, 0, NULL, NULL);
+  table_sharded_deinit(NULL, NULL);
+  table_sharded_contains(NULL, NULL, NULL);
+  table_sharded_insert(NULL, NULL, NULL, NULL, NULL);
+  table_sharded_upsert(NULL, NULL, NULL, NULL, NULL);
+  table_sharded_remove(NULL, NULL, NULL);
+  table_sharded_length(NULL);
+  table_sharded_dummy_callee__();
+}
+static void table_sharded_dummy_callee__(void) {
+  table_sharded_dummy_caller__();
+}
+
+#endif // TABLE_SHARDED_H_
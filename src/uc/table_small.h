@@ -0,0 +1,190 @@
+#ifndef TABLE_SMALL_H_
+#define TABLE_SMALL_H_
+
+#include <uc/allocator.h>
+#include <uc/table.h>
+
+/***
+ * @file
+ * Allocation free storage for tables which usually stay small.
+ *
+ * `TableSmall` is an `Allocator` which hands out caller provided storage for
+ * the first chunk and forwards everything else to a backing allocator. A
+ * table initialized through it with a capacity of at most
+ * `TABLE_SMALL_CAPACITY` lives entirely in that storage and has a single
+ * group of `TABLE_GROUP_WIDTH` slots on SIMD targets, so every lookup is one
+ * group compare without any allocator traffic. Once the table outgrows the
+ * storage it moves to the backing allocator and the storage becomes
+ * available again, e.g. for `table_shrink`.
+ *
+ * One `TableSmall` serves one table and has to be passed wherever that table
+ * takes an allocator.
+ *
+ * @example:
+ * ```c
+ * u64 storage[TABLE_SMALL_STORAGE_SIZE(sizeof(int)) / sizeof(u64)];
+ * TableSmall small;
+ * table_small_init(&small, storage, sizeof(storage), allocator_global);
+ *
+ * Table(int) table;
+ * table_init(&table, &vtable, 0, &small, NULL);
+ * table_insert(&table, &vtable, &x, &small, NULL);
+ * table_deinit(&table, &small);
+ * ```
+ */
+
+/***
+ * @doc(macro): TABLE_SMALL_CAPACITY
+ * @tag: all
+ *
+ * @brief: Number of elements a table in `TABLE_SMALL_STORAGE_SIZE` bytes can
+ * hold before it has to grow.
+ */
+#define TABLE_SMALL_CAPACITY                                                   \
+  (TABLE_INTERNAL_MIN_END - TABLE_INTERNAL_MIN_END / 8)
+
+/***
+ * @doc(macro): TABLE_SMALL_STORAGE_SIZE
+ * @tag: all
+ *
+ * @brief: Bytes of storage needed for a small table of elements of
+ * `ELEMENT_SIZE` bytes, rounded up to a multiple of 8. Tables with
+ * `store_hash` or `value_size` need `table_small_storage_size` instead.
+ */
+#define TABLE_SMALL_STORAGE_SIZE(ELEMENT_SIZE)                                 \
+  (((ELEMENT_SIZE) * TABLE_INTERNAL_MIN_END + TABLE_INTERNAL_MIN_END +         \
+    TABLE_GROUP_WIDTH + 7) &                                                   \
+   ~(usize)7)
+
+/***
+ * @doc(type): TableSmall
+ * @tag: all
+ *
+ * @brief: Allocator serving a single chunk from caller provided storage, see
+ * the file documentation.
+ */
+typedef struct TableSmall TableSmall;
+struct TableSmall {
+  const AllocatorVTable *vtable;
+  Allocator *backing;
+  byte *storage;
+  usize storage_size;
+  bool in_use;
+};
+
+static void *table_small_internal_alloc(Allocator *allocator, usize num_bytes,
+                                        Error *error) {
+  debug_check(allocator);
+
+  TableSmall *small = allocator;
+  if (!small->in_use && num_bytes <= small->storage_size) {
+    small->in_use = true;
+    return small->storage;
+  }
+  return allocator_alloc(small->backing, num_bytes, error);
+}
+
+static void table_small_internal_free(Allocator *allocator, void *chunk) {
+  debug_check(allocator);
+
+  TableSmall *small = allocator;
+  if (chunk == small->storage) {
+    small->in_use = false;
+    return;
+  }
+  allocator_free(small->backing, chunk);
+}
+
+static void *table_small_internal_realloc(Allocator *allocator, void *chunk,
+                                          usize num_bytes, Error *error) {
+  debug_check(allocator);
+
+  TableSmall *small = allocator;
+  if (chunk != small->storage) {
+    if (!chunk) {
+      return table_small_internal_alloc(small, num_bytes, error);
+    }
+    return allocator_realloc(small->backing, chunk, num_bytes, error);
+  }
+  if (num_bytes <= small->storage_size) {
+    return chunk;
+  }
+
+  void *chunk_new = allocator_alloc(small->backing, num_bytes, error);
+  if (UNLIKELY(!chunk_new)) {
+    return NULL;
+  }
+  builtin_memcpy(chunk_new, small->storage, small->storage_size);
+  small->in_use = false;
+  return chunk_new;
+}
+
+static const AllocatorVTable *table_small_internal_vtable = &(AllocatorVTable){
+    .alloc = table_small_internal_alloc,
+    .realloc = table_small_internal_realloc,
+    .free = table_small_internal_free,
+};
+
+/***
+ * @doc(function): table_small_storage_size
+ * @tag: all
+ *
+ * @brief: Bytes of storage needed for a small table with `vtable`, including
+ * stored hashes and values.
+ */
+static usize table_small_storage_size(const TableVTable *vtable) {
+  debug_check(vtable);
+
+  return table_internal_chunk_size(vtable, TABLE_INTERNAL_MIN_END);
+}
+
+/***
+ * @doc(function): table_small_init
+ * @tag: all
+ *
+ * @param(storage): used for the first chunk, has to be aligned for the
+ * elements and outlive the table. Usually `TABLE_SMALL_STORAGE_SIZE` or
+ * `table_small_storage_size` bytes, an array of `u64` on the stack works
+ * @assert(storage): `storage != NULL || storage_size == 0`
+ *
+ * @param(backing): allocator for everything which does not fit
+ * @assert(backing): `backing != NULL`
+ */
+static void table_small_init(TableSmall *small, void *storage,
+                             usize storage_size, Allocator *backing) {
+  debug_check(small);
+  debug_check(storage || !storage_size);
+  debug_check(backing);
+
+  *small = (TableSmall){0};
+  small->vtable = table_small_internal_vtable;
+  small->backing = backing;
+  small->storage = storage;
+  small->storage_size = storage_size;
+}
+
+/***
+ * @doc(function): table_small_is_inline
+ * @tag: all
+ *
+ * @brief: Returns `true` if the table still lives in the storage of `small`.
+ */
+static bool table_small_is_inline(const TableSmall *small,
+                                  const Table *table_) {
+  debug_check(small);
+  debug_check(table_);
+
+  const Table(byte) *table = table_;
+  return table->element == small->storage;
+}
+
+static void table_small_dummy_callee__(void);
+static void table_small_dummy_caller__(void) {
+  table_small_storage_size(NULL);
+  table_small_init(NULL, NULL, 0, NULL);
+  table_small_is_inline(NULL, NULL);
+  table_small_dummy_callee__();
+}
+static void table_small_dummy_callee__(void) { table_small_dummy_caller__(); }
+
+#endif // TABLE_SMALL_H_
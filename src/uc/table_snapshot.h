@@ -0,0 +1,277 @@
+#ifndef TABLE_SNAPSHOT_H_
+#define TABLE_SNAPSHOT_H_
+
+#include <uc/table.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/***
+ * @file
+ * Saving tables to files and mapping them back without rehashing. Requires a
+ * POSIX system.
+ *
+ * A snapshot is a `TableSnapshotHeader` followed by the single allocation of
+ * the table, i.e. the elements, the stored hashes and the control bytes, as
+ * they are in memory. Mapping a snapshot therefore only validates the header
+ * and sets the pointers of the table, the elements are paged in on first
+ * access.
+ *
+ * Elements are copied byte by byte, so only plain data without pointers can
+ * be saved. The table has to be used with the same hash function it was
+ * saved with, and snapshots can only be mapped by programs built with the same
+ * `TABLE_GROUP_WIDTH` and byte order.
+ */
+
+#define TABLE_SNAPSHOT_MAGIC "UCTABLE"
+#define TABLE_SNAPSHOT_VERSION 1
+// written as a native u32, reads back differently on the other byte order
+#define TABLE_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/***
+ * @doc(type): TableSnapshotHeader
+ * @tag: all
+ *
+ * @brief: Header at the start of every snapshot file. It is 64 bytes, which
+ * keeps the element array following it aligned for any element type.
+ */
+typedef struct TableSnapshotHeader TableSnapshotHeader;
+struct TableSnapshotHeader {
+  char magic[8];
+  u32 version;
+  u32 byte_order;
+  u32 group_width;
+  u32 store_hash;
+  u64 element_size;
+  u64 length;
+  u64 end;
+  u64 tombs;
+  u64 value_size;
+};
+
+/***
+ * @doc(type): TableMapping
+ * @tag: all
+ *
+ * @brief: Mapped snapshot file, released with `table_unmap`.
+ *
+ * @member(base): start of the mapping
+ *
+ * @member(size): number of mapped bytes
+ */
+typedef struct TableMapping TableMapping;
+struct TableMapping {
+  void *base;
+  usize size;
+};
+
+/***
+ * @doc(type): TableMapMode
+ * @tag: all
+ *
+ * @brief: Access to a mapped table.
+ *
+ * @member(TABLE_MAP_READ_ONLY): the table may only be read, modifying it
+ * crashes the program. Pages are shared with every other process mapping the
+ * same file.
+ *
+ * @member(TABLE_MAP_COPY_ON_WRITE): the table may be modified in place with
+ * `table_upsert`, `table_insert` and `table_remove` as long as it does not
+ * have to grow. Modified pages are copied, the file is never changed.
+ */
+typedef enum {
+  TABLE_MAP_READ_ONLY,
+  TABLE_MAP_COPY_ON_WRITE,
+} TableMapMode;
+
+/***
+ * @doc(function): table_save
+ * @tag: all
+ *
+ * @brief: Writes `table` to the file at `path`, replacing it.
+ *
+ * @detailed: Finishes an incremental resize if one is in progress, so that
+ * the table is a single allocation which can be written as is.
+ *
+ * @param(path): path of the file
+ * @assert(path): `path != NULL`
+ *
+ * @param(error): set to `errno` if the file could not be written
+ */
+static void table_save(Table *table_, const TableVTable *vtable,
+                       const char *path, Allocator *allocator, Error *error) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(path);
+  debug_check(allocator);
+
+  Table(byte) *table = table_;
+  if (table->old_element) {
+    table_internal_migrate(table, vtable, table->old_end, allocator);
+  }
+
+  TableSnapshotHeader header = {0};
+  builtin_memcpy(header.magic, TABLE_SNAPSHOT_MAGIC,
+                 sizeof(TABLE_SNAPSHOT_MAGIC));
+  header.version = TABLE_SNAPSHOT_VERSION;
+  header.byte_order = TABLE_SNAPSHOT_BYTE_ORDER;
+  header.group_width = TABLE_GROUP_WIDTH;
+  header.store_hash = vtable->store_hash;
+  header.element_size = vtable->element_size;
+  header.value_size = vtable->value_size;
+  header.length = table->length;
+  header.end = table->end;
+  header.tombs = table->tombs;
+
+  FILE *file = fopen(path, "wb");
+  if (UNLIKELY(!file)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+
+  const usize chunk_size = table_internal_chunk_size(vtable, table->end);
+  errno = 0;
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(table->element, chunk_size, 1, file) == 1;
+  written = (fclose(file) == 0) && written;
+  if (UNLIKELY(!written && error)) {
+    *error = errno ? errno : EIO;
+  }
+}
+
+/***
+ * @doc(function): table_map
+ * @tag: all
+ *
+ * @brief: Maps a file written by `table_save` and points `table` into it.
+ *
+ * @detailed: No element is hashed or copied. The table must not be passed to
+ * `table_deinit` and must not grow, release it with `table_unmap` instead.
+ * It stays valid after the file is deleted.
+ *
+ * @param(table): table which is pointed into the mapping
+ * @assert(table): `table != NULL`
+ *
+ * @param(vtable): vtable the snapshot was saved with, `element_size`,
+ * `store_hash` and `value_size` have to match the file
+ *
+ * @param(mapping): receives the mapping
+ * @assert(mapping): `mapping != NULL`
+ *
+ * @param(error): set to `errno` if the file could not be mapped, or to
+ * `EINVAL` if it is not a compatible snapshot
+ */
+static void table_map(Table *table_, const TableVTable *vtable,
+                      const char *path, TableMapMode mode,
+                      TableMapping *mapping, Error *error) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(path);
+  debug_check(mapping);
+
+  Table(byte) *table = table_;
+  builtin_memset(table, 0, sizeof(*table));
+  builtin_memset(mapping, 0, sizeof(*mapping));
+
+  const int fd = open(path, O_RDONLY);
+  if (UNLIKELY(fd < 0)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+
+  struct stat st;
+  if (UNLIKELY(fstat(fd, &st) != 0)) {
+    if (error) {
+      *error = errno;
+    }
+    (void)close(fd);
+    return;
+  }
+
+  TableSnapshotHeader header = {0};
+  const usize size = (usize)st.st_size;
+  if (UNLIKELY(size < sizeof(header) ||
+               read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header))) {
+    if (error) {
+      *error = EINVAL;
+    }
+    (void)close(fd);
+    return;
+  }
+
+  const bool compatible =
+      builtin_memcmp(header.magic, TABLE_SNAPSHOT_MAGIC,
+                     sizeof(TABLE_SNAPSHOT_MAGIC)) == 0 &&
+      header.version == TABLE_SNAPSHOT_VERSION &&
+      header.byte_order == TABLE_SNAPSHOT_BYTE_ORDER &&
+      header.group_width == TABLE_GROUP_WIDTH &&
+      header.store_hash == vtable->store_hash &&
+      header.element_size == vtable->element_size &&
+      header.value_size == vtable->value_size && header.end &&
+      (header.end & (header.end - 1)) == 0 &&
+      size == sizeof(header) + table_internal_chunk_size(vtable, header.end);
+  if (UNLIKELY(!compatible)) {
+    if (error) {
+      *error = EINVAL;
+    }
+    (void)close(fd);
+    return;
+  }
+
+  const int protection =
+      mode == TABLE_MAP_READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+  const int flags = mode == TABLE_MAP_READ_ONLY ? MAP_SHARED : MAP_PRIVATE;
+  void *base = mmap(NULL, size, protection, flags, fd, 0);
+  // the mapping keeps its own reference to the file
+  (void)close(fd);
+  if (UNLIKELY(base == MAP_FAILED)) {
+    if (error) {
+      *error = errno;
+    }
+    return;
+  }
+
+  mapping->base = base;
+  mapping->size = size;
+  table->element = (byte *)base + sizeof(header);
+  table->length = header.length;
+  table->end = header.end;
+  table->tombs = header.tombs;
+}
+
+/***
+ * @doc(function): table_unmap
+ * @tag: all
+ *
+ * @brief: Releases a mapping created by `table_map`, tables pointing into it
+ * become invalid.
+ */
+static void table_unmap(TableMapping *mapping) {
+  debug_check(mapping);
+
+  if (mapping->base) {
+    (void)munmap(mapping->base, mapping->size);
+  }
+  mapping->base = NULL;
+  mapping->size = 0;
+}
+
+static void table_snapshot_dummy_callee__(void);
+static void table_snapshot_dummy_caller__(void) {
+  table_save(NULL, NULL, NULL, NULL, NULL);
+  table_map(NULL, NULL, NULL, TABLE_MAP_READ_ONLY, NULL, NULL);
+  table_unmap(NULL);
+  table_snapshot_dummy_callee__();
+}
+static void table_snapshot_dummy_callee__(void) {
+  table_snapshot_dummy_caller__();
+}
+
+#endif // TABLE_SNAPSHOT_H_
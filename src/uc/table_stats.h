@@ -0,0 +1,142 @@
+#ifndef TABLE_STATS_H_
+#define TABLE_STATS_H_
+
+#include <uc/table.h>
+
+#include <stdio.h>
+#include <time.h>
+
+/***
+ * @file
+ * Reporting the state of a table and the counters of its `TableStats`.
+ *
+ * Counters are only collected if `TABLE_STATS` is defined before `table.h`
+ * is included and `vtable->stats` points to a `TableStats`. The load and tomb
+ * ratios are read from the table itself and are always available.
+ */
+
+/***
+ * @doc(function): table_stats_load
+ * @tag: all
+ *
+ * @brief: Ratio of elements to slots, counting the slots of the old array
+ * during an incremental resize.
+ */
+static double table_stats_load(const Table *table_) {
+  debug_check(table_);
+
+  const Table(byte) *table = table_;
+  return (double)table->length / (double)(table->end + table->old_end);
+}
+
+/***
+ * @doc(function): table_stats_tomb_ratio
+ * @tag: all
+ *
+ * @brief: Ratio of tombs to all slots of the current element array. Tombs
+ * lengthen probe sequences just like elements do, until they are purged.
+ */
+static double table_stats_tomb_ratio(const Table *table_) {
+  debug_check(table_);
+
+  const Table(byte) *table = table_;
+  return (double)table->tombs / (double)table->end;
+}
+
+/***
+ * @doc(function): table_stats_reset
+ * @tag: all
+ *
+ * @brief: Sets all counters of `stats` to zero. Not atomic, the tables using
+ * `stats` must not be in use.
+ */
+static void table_stats_reset(TableStats *stats) {
+  debug_check(stats);
+
+  builtin_memset(stats, 0, sizeof(*stats));
+}
+
+/***
+ * @doc(function): table_stats
+ * @tag: all
+ *
+ * @brief: Writes a human readable report of `table` and `vtable->stats` to
+ * `stream`.
+ *
+ * @detailed: Reports length, slots, load and tomb ratio. If `vtable->stats`
+ * is set, also the average groups and compares per find, the rate of tag
+ * matches which were not the element, the resize and purge counts with the
+ * time they took, and the probe length histogram.
+ *
+ * @param(stream): stream the report is written to, e.g. `stderr`
+ * @assert(stream): `stream != NULL`
+ */
+static void table_stats(const Table *table_, const TableVTable *vtable,
+                        FILE *stream) {
+  debug_check(table_);
+  debug_check(vtable);
+  debug_check(stream);
+
+  const Table(byte) *table = table_;
+  (void)fprintf(stream, "length:          %zu\n", table->length);
+  (void)fprintf(stream, "slots:           %zu\n", table->end + table->old_end);
+  (void)fprintf(stream, "load:            %.3f\n", table_stats_load(table));
+  (void)fprintf(stream, "tombs:           %zu (%.3f)\n", table->tombs,
+                table_stats_tomb_ratio(table));
+  if (table->old_element) {
+    (void)fprintf(stream, "migrating:       %zu of %zu old slots done\n",
+                  table->migrated, table->old_end);
+  }
+
+  const TableStats *stats = vtable->stats;
+  if (!stats) {
+    return;
+  }
+
+  // avoids dividing by zero before anything was counted
+  const double finds = stats->finds ? (double)stats->finds : 1.0;
+  const double tag_matches =
+      stats->tag_matches ? (double)stats->tag_matches : 1.0;
+  u64 groups = 0;
+  for (usize i = 0; i < TABLE_STATS_PROBE_BUCKETS; ++i) {
+    groups += (i + 1) * stats->probe_groups[i];
+  }
+
+  (void)fprintf(stream, "finds:           %llu\n",
+                (unsigned long long)stats->finds);
+  (void)fprintf(stream, "groups/find:     %.3f\n", (double)groups / finds);
+  (void)fprintf(stream, "compares/find:   %.3f\n",
+                (double)stats->compares / finds);
+  (void)fprintf(stream, "false positives: %llu (%.4f of tag matches)\n",
+                (unsigned long long)stats->false_positives,
+                (double)stats->false_positives / tag_matches);
+  (void)fprintf(stream, "resizes:         %llu\n",
+                (unsigned long long)stats->resizes);
+  (void)fprintf(stream, "purges:          %llu\n",
+                (unsigned long long)stats->purges);
+  (void)fprintf(stream, "rehash time:     %.6f s\n",
+                (double)stats->rehash_clocks / (double)CLOCKS_PER_SEC);
+
+  (void)fprintf(stream, "groups per find:\n");
+  for (usize i = 0; i < TABLE_STATS_PROBE_BUCKETS; ++i) {
+    if (!stats->probe_groups[i]) {
+      continue;
+    }
+    (void)fprintf(stream, "  %2zu%s %12llu  %.4f\n", i + 1,
+                  i + 1 == TABLE_STATS_PROBE_BUCKETS ? "+" : " ",
+                  (unsigned long long)stats->probe_groups[i],
+                  (double)stats->probe_groups[i] / finds);
+  }
+}
+
+static void table_stats_dummy_callee__(void);
+static void table_stats_dummy_caller__(void) {
+  table_stats_load(NULL);
+  table_stats_tomb_ratio(NULL);
+  table_stats_reset(NULL);
+  table_stats(NULL, NULL, NULL);
+  table_stats_dummy_callee__();
+}
+static void table_stats_dummy_callee__(void) { table_stats_dummy_caller__(); }
+
+#endif // TABLE_STATS_H_
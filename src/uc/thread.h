@@ -0,0 +1,222 @@
+#ifndef THREAD_H_
+#define THREAD_H_
+
+#include <uc/debug_check.h>
+#include <uc/error.h>
+#include <uc/macro_util.h>
+#include <uc/types.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+/***
+ * @file
+ * Thin wrapper around POSIX threads and a few synchronization primitives.
+ * Programs including it have to be built with `-pthread`.
+ */
+
+/***
+ * @doc(type): thread_f
+ * @tag: all
+ *
+ * @brief: Entry point of a thread, `arg` is the pointer passed to
+ * `thread_spawn`.
+ */
+typedef void (*thread_f)(void *arg);
+
+/***
+ * @doc(type): Thread
+ * @tag: all
+ *
+ * @brief: Handle of a running thread, has to be joined with `thread_join`.
+ */
+typedef struct Thread Thread;
+struct Thread {
+  pthread_t handle;
+  thread_f function;
+  void *arg;
+};
+
+static void *thread_internal_start(void *thread_) {
+  Thread *thread = thread_;
+  thread->function(thread->arg);
+  return NULL;
+}
+
+/***
+ * @doc(function): thread_spawn
+ * @tag: all
+ *
+ * @brief: Starts a thread running `function(arg)`.
+ *
+ * @param(thread): receives the handle, has to stay at the same address until
+ * the thread is joined
+ * @assert(thread): `thread != NULL`
+ *
+ * @param(function): entry point
+ * @assert(function): `function != NULL`
+ *
+ * @param(error): set if the thread could not be created, e.g. to `EAGAIN`
+ */
+static void thread_spawn(Thread *thread, thread_f function, void *arg,
+                         Error *error) {
+  debug_check(thread);
+  debug_check(function);
+
+  thread->function = function;
+  thread->arg = arg;
+  const int result =
+      pthread_create(&thread->handle, NULL, thread_internal_start, thread);
+  if (UNLIKELY(result && error)) {
+    *error = result;
+  }
+}
+
+/***
+ * @doc(function): thread_join
+ * @tag: all
+ *
+ * @brief: Waits for a thread started with `thread_spawn` to finish.
+ */
+static void thread_join(Thread *thread) {
+  debug_check(thread);
+
+  (void)pthread_join(thread->handle, NULL);
+}
+
+/***
+ * @doc(type): Mutex
+ * @tag: all
+ *
+ * @brief: Mutual exclusion lock, initialized with `mutex_init`.
+ */
+typedef struct Mutex Mutex;
+struct Mutex {
+  pthread_mutex_t handle;
+};
+
+static void mutex_init(Mutex *mutex) {
+  debug_check(mutex);
+
+  (void)pthread_mutex_init(&mutex->handle, NULL);
+}
+
+static void mutex_deinit(Mutex *mutex) {
+  debug_check(mutex);
+
+  (void)pthread_mutex_destroy(&mutex->handle);
+}
+
+static void mutex_lock(Mutex *mutex) {
+  debug_check(mutex);
+
+  (void)pthread_mutex_lock(&mutex->handle);
+}
+
+static void mutex_unlock(Mutex *mutex) {
+  debug_check(mutex);
+
+  (void)pthread_mutex_unlock(&mutex->handle);
+}
+
+// backs off while spinning on a lock, giving up the time slice after a few
+// rounds so that waiting on an oversubscribed machine does not burn it
+static void thread_internal_relax(usize *spins) {
+  if (*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+    *spins += 1;
+    return;
+  }
+  (void)sched_yield();
+}
+
+#define RW_LOCK_INTERNAL_WRITER ((u32)1 << 31)
+#define RW_LOCK_INTERNAL_WAITING ((u32)1 << 30)
+
+/***
+ * @doc(type): RwLock
+ * @tag: all
+ *
+ * @brief: Reader writer spin lock, valid when zero initialized.
+ *
+ * @detailed: Any number of readers or a single writer may hold the lock.
+ * Readers only perform a single compare and swap on an uncontended lock. A
+ * waiting writer blocks new readers, so writers are not starved. Meant for
+ * short critical sections, waiters spin and then yield.
+ */
+typedef struct RwLock RwLock;
+struct RwLock {
+  u32 state;
+};
+
+static void rw_lock_read(RwLock *lock) {
+  debug_check(lock);
+
+  usize spins = 0;
+  while (1) {
+    const u32 blocked = RW_LOCK_INTERNAL_WRITER | RW_LOCK_INTERNAL_WAITING;
+    u32 state = __atomic_load_n(&lock->state, __ATOMIC_RELAXED);
+    if (LIKELY(!(state & blocked)) &&
+        __atomic_compare_exchange_n(&lock->state, &state, state + 1, true,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return;
+    }
+    thread_internal_relax(&spins);
+  }
+}
+
+static void rw_lock_read_unlock(RwLock *lock) {
+  debug_check(lock);
+
+  (void)__atomic_fetch_sub(&lock->state, 1, __ATOMIC_RELEASE);
+}
+
+static void rw_lock_write(RwLock *lock) {
+  debug_check(lock);
+
+  usize spins = 0;
+  while (1) {
+    u32 state = __atomic_load_n(&lock->state, __ATOMIC_RELAXED);
+    if (!(state & ~RW_LOCK_INTERNAL_WAITING) &&
+        __atomic_compare_exchange_n(&lock->state, &state,
+                                    RW_LOCK_INTERNAL_WRITER, true,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return;
+    }
+    if (!(state & RW_LOCK_INTERNAL_WAITING)) {
+      (void)__atomic_fetch_or(&lock->state, RW_LOCK_INTERNAL_WAITING,
+                              __ATOMIC_RELAXED);
+    }
+    thread_internal_relax(&spins);
+  }
+}
+
+static void rw_lock_write_unlock(RwLock *lock) {
+  debug_check(lock);
+
+  // keeps the waiting bit of other writers
+  (void)__atomic_fetch_and(&lock->state, ~RW_LOCK_INTERNAL_WRITER,
+                           __ATOMIC_RELEASE);
+}
+
+static void thread_dummy_callee__(void);
+static void thread_dummy_caller__(void) {
+  thread_spawn(NULL, NULL, NULL, NULL);
+  thread_join(NULL);
+  mutex_init(NULL);
+  mutex_deinit(NULL);
+  mutex_lock(NULL);
+  mutex_unlock(NULL);
+  rw_lock_read(NULL);
+  rw_lock_read_unlock(NULL);
+  rw_lock_write(NULL);
+  rw_lock_write_unlock(NULL);
+  thread_dummy_callee__();
+}
+static void thread_dummy_callee__(void) { thread_dummy_caller__(); }
+
+#endif // THREAD_H_
@@ -12,7 +12,9 @@
 
 #include <uc/ucx.h>
 
-// ********************************Allocator*************************************
+#include <stddef.h>
+
+// ********************************Allocator************************************
 /***
  * @brief Allocate a chunk of memory through `allocator`
  *
@@ -101,6 +103,20 @@ void ucx_vec_shrink(ucx_Vec *vec, usize element_size, ucx_Allocator *allocator,
 
 // ********************************Table****************************************
 
+// fails to compile if `CONDITION` is false
+#define UCX_INTERNAL_STATIC_ASSERT(NAME, CONDITION)                            \
+  typedef char ucx_internal_static_assert_##NAME[(CONDITION) ? 1 : -1]
+
+// the wrappers cast the vtable, so both structs have to be layout identical
+UCX_INTERNAL_STATIC_ASSERT(table_vtable_size,
+                           sizeof(ucx_TableVTable) == sizeof(TableVTable));
+UCX_INTERNAL_STATIC_ASSERT(table_vtable_stats,
+                           offsetof(ucx_TableVTable, stats) ==
+                               offsetof(TableVTable, stats));
+UCX_INTERNAL_STATIC_ASSERT(table_vtable_value_size,
+                           offsetof(ucx_TableVTable, value_size) ==
+                               offsetof(TableVTable, value_size));
+
 void ucx_table_deinit(ucx_Table *table_, ucx_Allocator *allocator) {
   table_deinit(table_, allocator);
 }
@@ -121,11 +137,28 @@ bool ucx_table_isset(const ucx_Table *table, const ucx_TableVTable *vtable,
   return table_isset(table, (void *)vtable, index);
 }
 
+void *ucx_table_get(const ucx_Table *table, const ucx_TableVTable *vtable,
+                    usize index) {
+  return table_get(table, (void *)vtable, index);
+}
+
 bool ucx_table_contains(const ucx_Table *table_, const ucx_TableVTable *vtable,
                         const void *element) {
   return table_contains(table_, (void *)vtable, element);
 }
 
+void ucx_table_find_many(const ucx_Table *table, const ucx_TableVTable *vtable,
+                         const void *elements, usize count, usize *indices) {
+  table_find_many(table, (void *)vtable, elements, count, indices);
+}
+
+void ucx_table_contains_many(const ucx_Table *table,
+                             const ucx_TableVTable *vtable,
+                             const void *elements, usize count,
+                             bool *contains) {
+  table_contains_many(table, (void *)vtable, elements, count, contains);
+}
+
 void ucx_table_shrink(ucx_Table *table_, const ucx_TableVTable *vtable,
                       ucx_Allocator *allocator, ucx_Error *error) {
   table_shrink(table_, (void *)vtable, allocator, error);
@@ -148,3 +181,13 @@ usize ucx_table_upsert(ucx_Table *table_, const ucx_TableVTable *vtable,
                        ucx_Error *error) {
   return table_upsert(table_, (void *)vtable, element, allocator, error);
 }
+
+bool ucx_table_remove(ucx_Table *table_, const ucx_TableVTable *vtable,
+                      const void *element) {
+  return table_remove(table_, (void *)vtable, element);
+}
+
+bool ucx_table_next(const ucx_Table *table, const ucx_TableVTable *vtable,
+                    ucx_TableIter *iter) {
+  return table_next(table, (void *)vtable, (void *)iter);
+}
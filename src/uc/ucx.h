@@ -46,7 +46,7 @@ void ucx_vec_reserve(ucx_Vec *vec, usize element_size, usize new_capacity,
 void ucx_vec_shrink(ucx_Vec *vec, usize element_size, ucx_Allocator *allocator,
                     ucx_Error *error);
 
-// ********************************Table*****************************************
+// ********************************Table****************************************
 
 typedef void (*ucx_table_element_insert_f)(void *dest, const void *src,
                                            void *ctx);
@@ -65,6 +65,11 @@ struct ucx_TableVTable {
   ucx_table_element_overwrite_f overwrite;
   usize element_size;
   void *ctx;
+  usize migrate_groups;
+  bool store_hash;
+  // `TableStats *`, only used if the library is built with `TABLE_STATS`
+  void *stats;
+  usize value_size;
 };
 typedef void ucx_Table;
 #define ucx_Table(TYPE)                                                        \
@@ -73,6 +78,9 @@ typedef void ucx_Table;
     usize length;                                                              \
     usize end;                                                                 \
     usize tombs;                                                               \
+    TYPE *old_element;                                                         \
+    usize old_end;                                                             \
+    usize migrated;                                                            \
   }
 
 void ucx_table_deinit(ucx_Table *table_, ucx_Allocator *allocator);
@@ -87,9 +95,20 @@ usize ucx_table_find(const ucx_Table *table, const ucx_TableVTable *vtable,
 bool ucx_table_isset(const ucx_Table *table, const ucx_TableVTable *vtable,
                      usize index);
 
+void *ucx_table_get(const ucx_Table *table, const ucx_TableVTable *vtable,
+                    usize index);
+
 bool ucx_table_contains(const ucx_Table *table_, const ucx_TableVTable *vtable,
                         const void *element);
 
+void ucx_table_find_many(const ucx_Table *table, const ucx_TableVTable *vtable,
+                         const void *elements, usize count, usize *indices);
+
+void ucx_table_contains_many(const ucx_Table *table,
+                             const ucx_TableVTable *vtable,
+                             const void *elements, usize count,
+                             bool *contains);
+
 void ucx_table_shrink(ucx_Table *table_, const ucx_TableVTable *vtable,
                       ucx_Allocator *allocator, ucx_Error *error);
 
@@ -103,3 +122,17 @@ usize ucx_table_insert(ucx_Table *table_, const ucx_TableVTable *vtable,
 usize ucx_table_upsert(ucx_Table *table_, const ucx_TableVTable *vtable,
                        const void *element, ucx_Allocator *allocator,
                        ucx_Error *error);
+
+bool ucx_table_remove(ucx_Table *table_, const ucx_TableVTable *vtable,
+                      const void *element);
+
+typedef struct ucx_TableIter ucx_TableIter;
+struct ucx_TableIter {
+  usize index;
+  usize next_group;
+  u64 mask;
+};
+bool ucx_table_next(const ucx_Table *table, const ucx_TableVTable *vtable,
+                    ucx_TableIter *iter);
+#define ucx_table_foreach(TABLE, VTABLE, ITER)                                 \
+  for (ucx_TableIter ITER = {0}; ucx_table_next((TABLE), (VTABLE), &ITER);)
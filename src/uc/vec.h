@@ -2,12 +2,31 @@
 #define VEC_H_
 
 #include <uc/allocator.h>
+#include <uc/builtin.h>
 #include <uc/debug_check.h>
 #include <uc/error.h>
 #include <uc/types.h>
 
+// the filter kernels of `vec_retain_range_u32` and `vec_retain_range_u64` use
+// AVX2 if the target supports it, unless `VEC_FORCE_SCALAR` is defined. SSE2
+// has no variable shuffle to compact with and does not beat the branchless
+// scalar loop
+#if defined(VEC_FORCE_SCALAR)
+#define VEC_INTERNAL_SCALAR
+#define VEC_SIMD_NAME "scalar"
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define VEC_INTERNAL_AVX2
+#define VEC_SIMD_NAME "avx2"
+#else
+#define VEC_INTERNAL_SCALAR
+#define VEC_SIMD_NAME "scalar"
+#endif
+
 typedef void Vec;
 
+typedef bool (*vec_element_keep_f)(const void *element, void *ctx);
+
 #define Vec(TYPE)                                                              \
   struct {                                                                     \
     TYPE *element;                                                             \
@@ -32,7 +51,8 @@ typedef void Vec;
  * initial capacity greater than the provider number but never less
  * @assert(initial_capacity): `initial_capacity > 0`
  *
- * @param(allocator): allocator used for allocating the internal element buffer
+ * @param(allocator): allocator used for allocating the internal element buffer,
+ * `allocator_pages` grows large buffers without copying them
  * @assert(allocator): `allocator != NULL`
  *
  * @param(error): error pointer used in case of an error. this might be `NULl`
@@ -267,6 +287,173 @@ static void vec_reserve(Vec *vec, usize element_size, usize new_capacity,
 static void vec_shrink(Vec *vec, usize element_size, Allocator *allocator,
                        Error *error);
 
+/***
+ * @doc(function): vec_append_uninit
+ * @tag: all
+ *
+ * @brief: appends `count` uninitialized elements and returns a pointer to the
+ * first of them
+ *
+ * @detailed: grows the internal array at most once, to at least twice its
+ * capacity so that repeated appends stay amortized constant per element
+ *
+ * @param(vec): vec the elements are appended to
+ * @assert(vec): `vec != NULL`
+ * @assert(vec): `vec` must have been initilized with `vec_init`
+ *
+ * @param(element_size): size of the elements in the vec
+ * @assert(element_size): `element_size > 0`
+ *
+ * @param(count): number of elements to append
+ *
+ * @param(allocator): allocator used for reallocing the internal array if
+ * necessary
+ * @assert(allocator): `allocator != NULl`
+ * @assert(allocator): must be the same as in `vec_init` or be able to handle
+ * data pointers return from the one used in `vec_init`
+ *
+ * @param(error): error pointer used to track errors which occure inside
+ * `vec_append_uninit`
+ *
+ * @error: each error which the provided allocator may invoke, the vec is left
+ * unchanged and `NULL` is returned
+ */
+static void *vec_append_uninit(Vec *vec, usize element_size, usize count,
+                               Allocator *allocator, Error *error);
+
+/***
+ * @doc(function): vec_extend
+ * @tag: all
+ *
+ * @brief: appends `count` elements copied from `elements`
+ *
+ * @detailed: grows the internal array at most once, see `vec_append_uninit`
+ *
+ * @param(elements): contiguous array of `count` elements, must not point into
+ * the vec itself
+ * @assert(elements): `elements != NULL || count == 0`
+ *
+ * @error: each error which the provided allocator may invoke, the vec is left
+ * unchanged
+ */
+static void vec_extend(Vec *vec, usize element_size, const void *elements,
+                       usize count, Allocator *allocator, Error *error);
+
+/***
+ * @doc(function): vec_insert_many
+ * @tag: all
+ *
+ * @brief: inserts `count` elements copied from `elements` at `index`
+ *
+ * @detailed: grows the internal array at most once and moves the tail once,
+ * instead of once per element like repeated `vec_insert`
+ *
+ * @param(index): index of the first inserted element, `vec->length` appends
+ * @assert(index): `index <= vec->length`
+ *
+ * @param(elements): contiguous array of `count` elements, must not point into
+ * the vec itself
+ * @assert(elements): `elements != NULL || count == 0`
+ *
+ * @error: each error which the provided allocator may invoke, the vec is left
+ * unchanged
+ */
+static void vec_insert_many(Vec *vec, usize element_size, usize index,
+                            const void *elements, usize count,
+                            Allocator *allocator, Error *error);
+
+/***
+ * @doc(function): vec_remove_range
+ * @tag: all
+ *
+ * @brief: removes the `count` elements starting at `index`, moving the tail
+ * once
+ *
+ * @assert(index): `index + count <= vec->length`
+ */
+static void vec_remove_range(Vec *vec, usize element_size, usize index,
+                             usize count);
+
+/***
+ * @doc(function): vec_resize
+ * @tag: all
+ *
+ * @brief: sets the length of the vec to `length`
+ *
+ * @detailed: shrinking drops the elements at the end and keeps the capacity.
+ * Growing appends elements copied from `fill`, or zeroed if `fill` is `NULL`,
+ * and reallocates at most once to exactly `length` elements if the capacity
+ * does not suffice
+ *
+ * @param(fill): element the new elements are copied from, may be `NULL`
+ *
+ * @error: each error which the provided allocator may invoke, the vec is left
+ * unchanged
+ */
+static void vec_resize(Vec *vec, usize element_size, usize length,
+                       const void *fill, Allocator *allocator, Error *error);
+
+/***
+ * @doc(function): vec_swap_remove
+ * @tag: all
+ *
+ * @brief: removes the element at `index` by moving the last element into its
+ * place
+ *
+ * @detailed: constant time, but does not keep the order of the elements. Use
+ * it instead of `vec_remove` for vecs whose order does not matter
+ *
+ * @assert(index): `index < vec->length`
+ */
+static void vec_swap_remove(Vec *vec, usize element_size, usize index);
+
+/***
+ * @doc(function): vec_retain
+ * @tag: all
+ *
+ * @brief: removes every element for which `keep` returns `false`, keeping the
+ * order of the remaining ones
+ *
+ * @detailed: a single pass, each run of kept elements is moved once. Removing
+ * many scattered elements with `vec_remove` moves the tail every time
+ *
+ * @param(keep): called once per element in order
+ * @assert(keep): `keep != NULL`
+ *
+ * @param(ctx): passed to `keep`
+ */
+static void vec_retain(Vec *vec, usize element_size, vec_element_keep_f keep,
+                       void *ctx);
+
+/***
+ * @doc(function): vec_retain_range_u32
+ * @tag: all
+ *
+ * @brief: keeps the elements of a `Vec(u32)` which are in `[low, high]`,
+ * keeping their order
+ *
+ * @detailed: like `vec_retain`, but the predicate is known, which lets the
+ * filter run without branches. With AVX2 eight elements are compared at once
+ * and the kept ones shuffled together with a single permute, otherwise every
+ * element is stored and only the kept ones advance the write position
+ *
+ * @assert(range): `low <= high`
+ */
+static void vec_retain_range_u32(Vec *vec, u32 low, u32 high);
+
+/***
+ * @doc(function): vec_retain_range_u64
+ * @tag: all
+ *
+ * @brief: keeps the elements of a `Vec(u64)` which are in `[low, high]`, see
+ * `vec_retain_range_u32`
+ *
+ * @detailed: with AVX2 four elements are compared and compacted at once
+ *
+ * @assert(range): `low <= high`
+ */
+static void vec_retain_range_u64(Vec *vec, u64 low, u64 high);
+
 // ********************************INTERNAL***********************************
 
 static void vec_internal_realloc(Vec *vec_, usize element_size,
@@ -459,6 +646,315 @@ static void vec_shrink(Vec *vec_, usize element_size, Allocator *allocator,
   vec_internal_realloc(vec, element_size, vec->length, allocator, error);
 }
 
+// makes room for `count` more elements, growing to at least twice the
+// capacity
+static void vec_internal_grow_for(Vec *vec_, usize element_size, usize count,
+                                  Allocator *allocator, Error *error) {
+  Vec(byte) *vec = vec_;
+  if (LIKELY(vec->end - vec->length >= count)) {
+    return;
+  }
+  const usize needed = vec->length + count;
+  vec_internal_realloc(vec, element_size,
+                       needed > vec->end << 1 ? needed : vec->end << 1,
+                       allocator, error);
+}
+
+static void *vec_append_uninit(Vec *vec_, usize element_size, usize count,
+                               Allocator *allocator, Error *error) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(allocator);
+
+  Error local_error = 0;
+  vec_internal_grow_for(vec_, element_size, count, allocator, &local_error);
+  if (UNLIKELY(local_error)) {
+    if (error) {
+      *error = local_error;
+    }
+    return NULL;
+  }
+
+  Vec(byte) *vec = vec_;
+  void *p = vec->element + vec->length * element_size;
+  vec->length += count;
+  return p;
+}
+
+static void vec_extend(Vec *vec, usize element_size, const void *elements,
+                       usize count, Allocator *allocator, Error *error) {
+  debug_check(elements || !count);
+
+  void *dest = vec_append_uninit(vec, element_size, count, allocator, error);
+  if (UNLIKELY(!dest)) {
+    return;
+  }
+  if (count) {
+    builtin_memcpy(dest, elements, count * element_size);
+  }
+}
+
+static void vec_insert_many(Vec *vec_, usize element_size, usize index,
+                            const void *elements, usize count,
+                            Allocator *allocator, Error *error) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(elements || !count);
+  debug_check(allocator);
+
+  Vec(byte) *vec = vec_;
+  debug_check(index <= vec->length);
+
+  Error local_error = 0;
+  vec_internal_grow_for(vec, element_size, count, allocator, &local_error);
+  if (UNLIKELY(local_error)) {
+    if (error) {
+      *error = local_error;
+    }
+    return;
+  }
+  if (!count) {
+    return;
+  }
+
+  byte *src = vec->element + index * element_size;
+  (void)builtin_memmove(src + count * element_size, src,
+                        (vec->length - index) * element_size);
+  (void)builtin_memcpy(src, elements, count * element_size);
+  vec->length += count;
+}
+
+static void vec_remove_range(Vec *vec_, usize element_size, usize index,
+                             usize count) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+
+  Vec(byte) *vec = vec_;
+  debug_check(index <= vec->length && count <= vec->length - index);
+
+  byte *dest = vec->element + index * element_size;
+  (void)builtin_memmove(dest, dest + count * element_size,
+                        (vec->length - index - count) * element_size);
+  vec->length -= count;
+}
+
+static void vec_resize(Vec *vec_, usize element_size, usize length,
+                       const void *fill, Allocator *allocator, Error *error) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(allocator);
+
+  Vec(byte) *vec = vec_;
+  if (length <= vec->length) {
+    vec->length = length;
+    return;
+  }
+  if (length > vec->end) {
+    Error local_error = 0;
+    vec_internal_realloc(vec, element_size, length, allocator, &local_error);
+    if (UNLIKELY(local_error)) {
+      if (error) {
+        *error = local_error;
+      }
+      return;
+    }
+  }
+
+  byte *dest = vec->element + vec->length * element_size;
+  const usize count = length - vec->length;
+  if (!fill) {
+    builtin_memset(dest, 0, count * element_size);
+  } else {
+    for (usize i = 0; i < count; ++i) {
+      builtin_memcpy(dest + i * element_size, fill, element_size);
+    }
+  }
+  vec->length = length;
+}
+
+static void vec_swap_remove(Vec *vec_, usize element_size, usize index) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+
+  Vec(byte) *vec = vec_;
+  debug_check(index < vec->length);
+
+  vec->length -= 1;
+  if (index != vec->length) {
+    (void)builtin_memcpy(vec->element + index * element_size,
+                         vec->element + vec->length * element_size,
+                         element_size);
+  }
+}
+
+static void vec_retain(Vec *vec_, usize element_size, vec_element_keep_f keep,
+                       void *ctx) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(keep);
+
+  Vec(byte) *vec = vec_;
+
+  // [run, i) are kept elements not yet moved to `write`
+  usize write = 0;
+  usize run = 0;
+  for (usize i = 0; i < vec->length; ++i) {
+    if (keep(vec->element + i * element_size, ctx)) {
+      continue;
+    }
+    if (write != run) {
+      (void)builtin_memmove(vec->element + write * element_size,
+                            vec->element + run * element_size,
+                            (i - run) * element_size);
+    }
+    write += i - run;
+    run = i + 1;
+  }
+  if (write != run) {
+    (void)builtin_memmove(vec->element + write * element_size,
+                          vec->element + run * element_size,
+                          (vec->length - run) * element_size);
+  }
+  vec->length = write + vec->length - run;
+}
+
+#if defined(VEC_INTERNAL_AVX2)
+
+// for each 8 bit mask the indices of its set bits packed in nibbles, lowest
+// first. Used as the `_mm256_permutevar8x32_epi32` which moves the kept
+// elements of a vector to its front
+static const u32 vec_internal_compress[256] = {
+    0x00000000, 0x00000000, 0x00000001, 0x00000010, 0x00000002, 0x00000020,
+    0x00000021, 0x00000210, 0x00000003, 0x00000030, 0x00000031, 0x00000310,
+    0x00000032, 0x00000320, 0x00000321, 0x00003210, 0x00000004, 0x00000040,
+    0x00000041, 0x00000410, 0x00000042, 0x00000420, 0x00000421, 0x00004210,
+    0x00000043, 0x00000430, 0x00000431, 0x00004310, 0x00000432, 0x00004320,
+    0x00004321, 0x00043210, 0x00000005, 0x00000050, 0x00000051, 0x00000510,
+    0x00000052, 0x00000520, 0x00000521, 0x00005210, 0x00000053, 0x00000530,
+    0x00000531, 0x00005310, 0x00000532, 0x00005320, 0x00005321, 0x00053210,
+    0x00000054, 0x00000540, 0x00000541, 0x00005410, 0x00000542, 0x00005420,
+    0x00005421, 0x00054210, 0x00000543, 0x00005430, 0x00005431, 0x00054310,
+    0x00005432, 0x00054320, 0x00054321, 0x00543210, 0x00000006, 0x00000060,
+    0x00000061, 0x00000610, 0x00000062, 0x00000620, 0x00000621, 0x00006210,
+    0x00000063, 0x00000630, 0x00000631, 0x00006310, 0x00000632, 0x00006320,
+    0x00006321, 0x00063210, 0x00000064, 0x00000640, 0x00000641, 0x00006410,
+    0x00000642, 0x00006420, 0x00006421, 0x00064210, 0x00000643, 0x00006430,
+    0x00006431, 0x00064310, 0x00006432, 0x00064320, 0x00064321, 0x00643210,
+    0x00000065, 0x00000650, 0x00000651, 0x00006510, 0x00000652, 0x00006520,
+    0x00006521, 0x00065210, 0x00000653, 0x00006530, 0x00006531, 0x00065310,
+    0x00006532, 0x00065320, 0x00065321, 0x00653210, 0x00000654, 0x00006540,
+    0x00006541, 0x00065410, 0x00006542, 0x00065420, 0x00065421, 0x00654210,
+    0x00006543, 0x00065430, 0x00065431, 0x00654310, 0x00065432, 0x00654320,
+    0x00654321, 0x06543210, 0x00000007, 0x00000070, 0x00000071, 0x00000710,
+    0x00000072, 0x00000720, 0x00000721, 0x00007210, 0x00000073, 0x00000730,
+    0x00000731, 0x00007310, 0x00000732, 0x00007320, 0x00007321, 0x00073210,
+    0x00000074, 0x00000740, 0x00000741, 0x00007410, 0x00000742, 0x00007420,
+    0x00007421, 0x00074210, 0x00000743, 0x00007430, 0x00007431, 0x00074310,
+    0x00007432, 0x00074320, 0x00074321, 0x00743210, 0x00000075, 0x00000750,
+    0x00000751, 0x00007510, 0x00000752, 0x00007520, 0x00007521, 0x00075210,
+    0x00000753, 0x00007530, 0x00007531, 0x00075310, 0x00007532, 0x00075320,
+    0x00075321, 0x00753210, 0x00000754, 0x00007540, 0x00007541, 0x00075410,
+    0x00007542, 0x00075420, 0x00075421, 0x00754210, 0x00007543, 0x00075430,
+    0x00075431, 0x00754310, 0x00075432, 0x00754320, 0x00754321, 0x07543210,
+    0x00000076, 0x00000760, 0x00000761, 0x00007610, 0x00000762, 0x00007620,
+    0x00007621, 0x00076210, 0x00000763, 0x00007630, 0x00007631, 0x00076310,
+    0x00007632, 0x00076320, 0x00076321, 0x00763210, 0x00000764, 0x00007640,
+    0x00007641, 0x00076410, 0x00007642, 0x00076420, 0x00076421, 0x00764210,
+    0x00007643, 0x00076430, 0x00076431, 0x00764310, 0x00076432, 0x00764320,
+    0x00764321, 0x07643210, 0x00000765, 0x00007650, 0x00007651, 0x00076510,
+    0x00007652, 0x00076520, 0x00076521, 0x00765210, 0x00007653, 0x00076530,
+    0x00076531, 0x00765310, 0x00076532, 0x00765320, 0x00765321, 0x07653210,
+    0x00007654, 0x00076540, 0x00076541, 0x00765410, 0x00076542, 0x00765420,
+    0x00765421, 0x07654210, 0x00076543, 0x00765430, 0x00765431, 0x07654310,
+    0x00765432, 0x07654320, 0x07654321, 0x76543210,
+};
+
+// stores the lanes of `data` selected by the 8 bit `mask` to `dest`, packed.
+// Always writes 32 bytes
+static void vec_internal_compress_store(byte *dest, __m256i data, u32 mask) {
+  const __m256i shift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+  const __m256i index = _mm256_and_si256(
+      _mm256_srlv_epi32(
+          _mm256_set1_epi32((int)vec_internal_compress[mask]), shift),
+      _mm256_set1_epi32(0xf));
+  _mm256_storeu_si256((__m256i_u *)dest,
+                      _mm256_permutevar8x32_epi32(data, index));
+}
+
+#endif
+
+static void vec_retain_range_u32(Vec *vec_, u32 low, u32 high) {
+  debug_check(vec_);
+  debug_check(low <= high);
+
+  Vec(u32) *vec = vec_;
+  u32 *element = vec->element;
+  const usize length = vec->length;
+  // `low <= x && x <= high` is `x - low <= high - low` with wrapping
+  const u32 span = high - low;
+
+  usize write = 0;
+  usize i = 0;
+#if defined(VEC_INTERNAL_AVX2)
+  // the 32 bytes written never pass the 32 bytes just read
+  const __m256i bias = _mm256_set1_epi32((int)(low + 0x80000000u));
+  const __m256i limit = _mm256_set1_epi32((int)(span ^ 0x80000000u));
+  for (; i + 8 <= length; i += 8) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    // signed comparison of the biased values is the unsigned one
+    const __m256i out =
+        _mm256_cmpgt_epi32(_mm256_sub_epi32(data, bias), limit);
+    const u32 mask =
+        ~(u32)_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xffu;
+    vec_internal_compress_store((byte *)&element[write], data, mask);
+    write += (usize)builtin_popcountll(mask);
+  }
+#endif
+  // branchless: every element is written, only the kept ones advance
+  for (; i < length; ++i) {
+    const u32 x = element[i];
+    element[write] = x;
+    write += x - low <= span;
+  }
+  vec->length = write;
+}
+
+static void vec_retain_range_u64(Vec *vec_, u64 low, u64 high) {
+  debug_check(vec_);
+  debug_check(low <= high);
+
+  Vec(u64) *vec = vec_;
+  u64 *element = vec->element;
+  const usize length = vec->length;
+  const u64 span = high - low;
+
+  usize write = 0;
+  usize i = 0;
+#if defined(VEC_INTERNAL_AVX2)
+  const __m256i bias =
+      _mm256_set1_epi64x((long long)(low + 0x8000000000000000ull));
+  const __m256i limit =
+      _mm256_set1_epi64x((long long)(span ^ 0x8000000000000000ull));
+  for (; i + 4 <= length; i += 4) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    const __m256i out =
+        _mm256_cmpgt_epi64(_mm256_sub_epi64(data, bias), limit);
+    // both 32 bit halves of an element have its bit, so the 8 bit mask moves
+    // them together
+    const u32 mask =
+        ~(u32)_mm256_movemask_ps(_mm256_castsi256_ps(out)) & 0xffu;
+    vec_internal_compress_store((byte *)&element[write], data, mask);
+    write += (usize)builtin_popcountll(mask) >> 1;
+  }
+#endif
+  for (; i < length; ++i) {
+    const u64 x = element[i];
+    element[write] = x;
+    write += x - low <= span;
+  }
+  vec->length = write;
+}
+
 //*********************************UNUSED*WRAPPER************************************************/
 //
 static void vec_internal_dummy_wrapper_wrapper__(void);
@@ -473,6 +969,15 @@ static void vec_internal_dummy_wrapper__(void) {
   vec_clear(NULL, 0);
   vec_reserve(NULL, 0, 0, NULL, NULL);
   vec_shrink(NULL, 0, NULL, NULL);
+  vec_append_uninit(NULL, 0, 0, NULL, NULL);
+  vec_extend(NULL, 0, NULL, 0, NULL, NULL);
+  vec_insert_many(NULL, 0, 0, NULL, 0, NULL, NULL);
+  vec_remove_range(NULL, 0, 0, 0);
+  vec_resize(NULL, 0, 0, NULL, NULL, NULL);
+  vec_swap_remove(NULL, 0, 0);
+  vec_retain(NULL, 0, NULL, NULL);
+  vec_retain_range_u32(NULL, 0, 0);
+  vec_retain_range_u64(NULL, 0, 0);
   vec_internal_dummy_wrapper_wrapper__();
 }
 
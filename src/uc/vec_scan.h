@@ -0,0 +1,640 @@
+#ifndef VEC_SCAN_H_
+#define VEC_SCAN_H_
+
+#include <uc/builtin.h>
+#include <uc/debug_check.h>
+#include <uc/types.h>
+#include <uc/vec.h>
+
+#include <math.h>
+
+/***
+ * @file
+ * Linear scans over vecs of primitive types: search, count, sum and min/max.
+ * Each kernel works directly on the `element` and `length` of a `Vec(TYPE)`
+ * of the type in its name.
+ *
+ * The implementation is selected at compile time. AVX2, SSE2 and NEON are
+ * available, the widest one supported by the target is used and a scalar
+ * loop handles the rest of the elements. Defining `VEC_SCAN_FORCE_SCALAR`
+ * disables them.
+ */
+
+#if defined(VEC_SCAN_FORCE_SCALAR)
+#define VEC_SCAN_SCALAR
+#elif defined(__AVX2__)
+#define VEC_SCAN_AVX2
+#elif defined(__SSE2__)
+#define VEC_SCAN_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define VEC_SCAN_NEON
+#else
+#define VEC_SCAN_SCALAR
+#endif
+
+#if defined(VEC_SCAN_AVX2)
+#include <immintrin.h>
+#define VEC_SCAN_NAME "avx2"
+#elif defined(VEC_SCAN_SSE2)
+#include <emmintrin.h>
+#define VEC_SCAN_NAME "sse2"
+#elif defined(VEC_SCAN_NEON)
+#include <arm_neon.h>
+#define VEC_SCAN_NAME "neon"
+#else
+#define VEC_SCAN_NAME "scalar"
+#endif
+
+// rounds after which the per lane counters of `vec_count_eq_u32` are added
+// up, before they could overflow
+#define VEC_SCAN_INTERNAL_ROUNDS_U32 ((usize)1 << 28)
+
+/***
+ * @doc(function): vec_find_u8
+ * @tag: all
+ *
+ * @brief: Index of the first element of a `Vec(u8)` equal to `value`, or
+ * `vec->length` if there is none.
+ *
+ * @param(vec): vec to search
+ * @assert(vec): `vec != NULL`
+ */
+static usize vec_find_u8(const Vec *vec_, u8 value) {
+  debug_check(vec_);
+
+  const Vec(u8) *vec = vec_;
+  const u8 *element = vec->element;
+  const usize length = vec->length;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  const __m256i needle = _mm256_set1_epi8((char)value);
+  for (; i + 32 <= length; i += 32) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    const u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, needle));
+    if (mask) {
+      return i + (usize)builtin_ctz(mask);
+    }
+  }
+#elif defined(VEC_SCAN_SSE2)
+  const __m128i needle = _mm_set1_epi8((char)value);
+  for (; i + 16 <= length; i += 16) {
+    const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+    const u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(data, needle));
+    if (mask) {
+      return i + (usize)builtin_ctz(mask);
+    }
+  }
+#elif defined(VEC_SCAN_NEON)
+  // NEON has no movemask, the scalar loop locates the match
+  const uint8x16_t needle = vdupq_n_u8(value);
+  for (; i + 16 <= length; i += 16) {
+    if (vmaxvq_u8(vceqq_u8(vld1q_u8(&element[i]), needle))) {
+      break;
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if (element[i] == value) {
+      return i;
+    }
+  }
+  return length;
+}
+
+/***
+ * @doc(function): vec_find_u32
+ * @tag: all
+ *
+ * @brief: Index of the first element of a `Vec(u32)` equal to `value`, or
+ * `vec->length` if there is none.
+ */
+static usize vec_find_u32(const Vec *vec_, u32 value) {
+  debug_check(vec_);
+
+  const Vec(u32) *vec = vec_;
+  const u32 *element = vec->element;
+  const usize length = vec->length;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  const __m256i needle = _mm256_set1_epi32((int)value);
+  for (; i + 8 <= length; i += 8) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    const u32 mask = (u32)_mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(data, needle)));
+    if (mask) {
+      return i + (usize)builtin_ctz(mask);
+    }
+  }
+#elif defined(VEC_SCAN_SSE2)
+  const __m128i needle = _mm_set1_epi32((int)value);
+  for (; i + 4 <= length; i += 4) {
+    const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+    const u32 mask = (u32)_mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmpeq_epi32(data, needle)));
+    if (mask) {
+      return i + (usize)builtin_ctz(mask);
+    }
+  }
+#elif defined(VEC_SCAN_NEON)
+  const uint32x4_t needle = vdupq_n_u32(value);
+  for (; i + 4 <= length; i += 4) {
+    if (vmaxvq_u32(vceqq_u32(vld1q_u32(&element[i]), needle))) {
+      break;
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if (element[i] == value) {
+      return i;
+    }
+  }
+  return length;
+}
+
+/***
+ * @doc(function): vec_find_u64
+ * @tag: all
+ *
+ * @brief: Index of the first element of a `Vec(u64)` equal to `value`, or
+ * `vec->length` if there is none.
+ */
+static usize vec_find_u64(const Vec *vec_, u64 value) {
+  debug_check(vec_);
+
+  const Vec(u64) *vec = vec_;
+  const u64 *element = vec->element;
+  const usize length = vec->length;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  const __m256i needle = _mm256_set1_epi64x((long long)value);
+  for (; i + 4 <= length; i += 4) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    const u32 mask = (u32)_mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(data, needle)));
+    if (mask) {
+      return i + (usize)builtin_ctz(mask);
+    }
+  }
+#elif defined(VEC_SCAN_SSE2)
+  // SSE2 only compares 32 bit lanes, an element matches if both halves do.
+  // Two vectors are checked at once, the scalar loop locates the match
+  const __m128i needle = _mm_set1_epi64x((long long)value);
+  for (; i + 4 <= length; i += 4) {
+    const __m128i a = _mm_cmpeq_epi32(
+        _mm_loadu_si128((const __m128i_u *)&element[i]), needle);
+    const __m128i b = _mm_cmpeq_epi32(
+        _mm_loadu_si128((const __m128i_u *)&element[i + 2]), needle);
+    const __m128i any = _mm_or_si128(
+        _mm_and_si128(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1))),
+        _mm_and_si128(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1))));
+    if (_mm_movemask_pd(_mm_castsi128_pd(any))) {
+      break;
+    }
+  }
+#elif defined(VEC_SCAN_NEON)
+  const uint64x2_t needle = vdupq_n_u64(value);
+  for (; i + 2 <= length; i += 2) {
+    const uint64x2_t eq = vceqq_u64(vld1q_u64(&element[i]), needle);
+    if (vgetq_lane_u64(eq, 0) | vgetq_lane_u64(eq, 1)) {
+      break;
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if (element[i] == value) {
+      return i;
+    }
+  }
+  return length;
+}
+
+/***
+ * @doc(function): vec_count_eq_u8
+ * @tag: all
+ *
+ * @brief: Number of elements of a `Vec(u8)` equal to `value`.
+ *
+ * @detailed: The vectorized versions count in byte lanes, which are added up
+ * every 255 rounds.
+ */
+static usize vec_count_eq_u8(const Vec *vec_, u8 value) {
+  debug_check(vec_);
+
+  const Vec(u8) *vec = vec_;
+  const u8 *element = vec->element;
+  const usize length = vec->length;
+  usize count = 0;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  const __m256i needle = _mm256_set1_epi8((char)value);
+  while (i + 32 <= length) {
+    usize rounds = (length - i) / 32;
+    rounds = rounds < 255 ? rounds : 255;
+    __m256i counter = _mm256_setzero_si256();
+    for (; rounds; --rounds, i += 32) {
+      const __m256i data =
+          _mm256_loadu_si256((const __m256i_u *)&element[i]);
+      // a match is `-1`
+      counter = _mm256_sub_epi8(counter, _mm256_cmpeq_epi8(data, needle));
+    }
+    u64 sums[4];
+    _mm256_storeu_si256((__m256i_u *)sums,
+                        _mm256_sad_epu8(counter, _mm256_setzero_si256()));
+    count += sums[0] + sums[1] + sums[2] + sums[3];
+  }
+#elif defined(VEC_SCAN_SSE2)
+  const __m128i needle = _mm_set1_epi8((char)value);
+  while (i + 16 <= length) {
+    usize rounds = (length - i) / 16;
+    rounds = rounds < 255 ? rounds : 255;
+    __m128i counter = _mm_setzero_si128();
+    for (; rounds; --rounds, i += 16) {
+      const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+      counter = _mm_sub_epi8(counter, _mm_cmpeq_epi8(data, needle));
+    }
+    u64 sums[2];
+    _mm_storeu_si128((__m128i_u *)sums,
+                     _mm_sad_epu8(counter, _mm_setzero_si128()));
+    count += sums[0] + sums[1];
+  }
+#elif defined(VEC_SCAN_NEON)
+  const uint8x16_t needle = vdupq_n_u8(value);
+  while (i + 16 <= length) {
+    usize rounds = (length - i) / 16;
+    rounds = rounds < 255 ? rounds : 255;
+    uint8x16_t counter = vdupq_n_u8(0);
+    for (; rounds; --rounds, i += 16) {
+      counter = vsubq_u8(counter, vceqq_u8(vld1q_u8(&element[i]), needle));
+    }
+    count += vaddlvq_u8(counter);
+  }
+#endif
+  for (; i < length; ++i) {
+    count += element[i] == value;
+  }
+  return count;
+}
+
+/***
+ * @doc(function): vec_count_eq_u32
+ * @tag: all
+ *
+ * @brief: Number of elements of a `Vec(u32)` equal to `value`.
+ */
+static usize vec_count_eq_u32(const Vec *vec_, u32 value) {
+  debug_check(vec_);
+
+  const Vec(u32) *vec = vec_;
+  const u32 *element = vec->element;
+  const usize length = vec->length;
+  usize count = 0;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  const __m256i needle = _mm256_set1_epi32((int)value);
+  while (i + 8 <= length) {
+    usize rounds = (length - i) / 8;
+    if (rounds > VEC_SCAN_INTERNAL_ROUNDS_U32) {
+      rounds = VEC_SCAN_INTERNAL_ROUNDS_U32;
+    }
+    __m256i counter = _mm256_setzero_si256();
+    for (; rounds; --rounds, i += 8) {
+      const __m256i data =
+          _mm256_loadu_si256((const __m256i_u *)&element[i]);
+      counter = _mm256_sub_epi32(counter, _mm256_cmpeq_epi32(data, needle));
+    }
+    u32 lanes[8];
+    _mm256_storeu_si256((__m256i_u *)lanes, counter);
+    for (usize l = 0; l < 8; ++l) {
+      count += lanes[l];
+    }
+  }
+#elif defined(VEC_SCAN_SSE2)
+  const __m128i needle = _mm_set1_epi32((int)value);
+  while (i + 4 <= length) {
+    usize rounds = (length - i) / 4;
+    if (rounds > VEC_SCAN_INTERNAL_ROUNDS_U32) {
+      rounds = VEC_SCAN_INTERNAL_ROUNDS_U32;
+    }
+    __m128i counter = _mm_setzero_si128();
+    for (; rounds; --rounds, i += 4) {
+      const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+      counter = _mm_sub_epi32(counter, _mm_cmpeq_epi32(data, needle));
+    }
+    u32 lanes[4];
+    _mm_storeu_si128((__m128i_u *)lanes, counter);
+    count += (usize)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+#elif defined(VEC_SCAN_NEON)
+  const uint32x4_t needle = vdupq_n_u32(value);
+  while (i + 4 <= length) {
+    usize rounds = (length - i) / 4;
+    if (rounds > VEC_SCAN_INTERNAL_ROUNDS_U32) {
+      rounds = VEC_SCAN_INTERNAL_ROUNDS_U32;
+    }
+    uint32x4_t counter = vdupq_n_u32(0);
+    for (; rounds; --rounds, i += 4) {
+      counter =
+          vsubq_u32(counter, vceqq_u32(vld1q_u32(&element[i]), needle));
+    }
+    count += vaddlvq_u32(counter);
+  }
+#endif
+  for (; i < length; ++i) {
+    count += element[i] == value;
+  }
+  return count;
+}
+
+/***
+ * @doc(function): vec_sum_i32
+ * @tag: all
+ *
+ * @brief: Sum of the elements of a `Vec(i32)`, added up in 64 bits so that
+ * it does not overflow like an `int` accumulator does.
+ */
+static i64 vec_sum_i32(const Vec *vec_) {
+  debug_check(vec_);
+
+  const Vec(i32) *vec = vec_;
+  const i32 *element = vec->element;
+  const usize length = vec->length;
+  // unsigned, wrapping is defined
+  u64 sum = 0;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  __m256i low = _mm256_setzero_si256();
+  __m256i high = _mm256_setzero_si256();
+  for (; i + 8 <= length; i += 8) {
+    const __m256i data = _mm256_loadu_si256((const __m256i_u *)&element[i]);
+    low = _mm256_add_epi64(
+        low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(data)));
+    high = _mm256_add_epi64(
+        high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(data, 1)));
+  }
+  u64 lanes[4];
+  _mm256_storeu_si256((__m256i_u *)lanes, _mm256_add_epi64(low, high));
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(VEC_SCAN_SSE2)
+  // SSE2 cannot sign extend, the high halves are built by a comparison
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 4 <= length; i += 4) {
+    const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+    const __m128i sign = _mm_cmpgt_epi32(_mm_setzero_si128(), data);
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(data, sign));
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(data, sign));
+  }
+  u64 lanes[2];
+  _mm_storeu_si128((__m128i_u *)lanes, acc);
+  sum = lanes[0] + lanes[1];
+#elif defined(VEC_SCAN_NEON)
+  int64x2_t acc = vdupq_n_s64(0);
+  for (; i + 4 <= length; i += 4) {
+    acc = vpadalq_s32(acc, vld1q_s32(&element[i]));
+  }
+  sum = (u64)vgetq_lane_s64(acc, 0) + (u64)vgetq_lane_s64(acc, 1);
+#endif
+  for (; i < length; ++i) {
+    sum += (u64)(i64)element[i];
+  }
+  return (i64)sum;
+}
+
+/***
+ * @doc(function): vec_sum_i64
+ * @tag: all
+ *
+ * @brief: Sum of the elements of a `Vec(i64)`, wrapping around on overflow.
+ */
+static i64 vec_sum_i64(const Vec *vec_) {
+  debug_check(vec_);
+
+  const Vec(i64) *vec = vec_;
+  const i64 *element = vec->element;
+  const usize length = vec->length;
+  u64 sum = 0;
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 4 <= length; i += 4) {
+    acc = _mm256_add_epi64(
+        acc, _mm256_loadu_si256((const __m256i_u *)&element[i]));
+  }
+  u64 lanes[4];
+  _mm256_storeu_si256((__m256i_u *)lanes, acc);
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(VEC_SCAN_SSE2)
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 2 <= length; i += 2) {
+    acc = _mm_add_epi64(acc, _mm_loadu_si128((const __m128i_u *)&element[i]));
+  }
+  u64 lanes[2];
+  _mm_storeu_si128((__m128i_u *)lanes, acc);
+  sum = lanes[0] + lanes[1];
+#elif defined(VEC_SCAN_NEON)
+  int64x2_t acc = vdupq_n_s64(0);
+  for (; i + 2 <= length; i += 2) {
+    acc = vaddq_s64(acc, vld1q_s64(&element[i]));
+  }
+  sum = (u64)vgetq_lane_s64(acc, 0) + (u64)vgetq_lane_s64(acc, 1);
+#endif
+  for (; i < length; ++i) {
+    sum += (u64)element[i];
+  }
+  return (i64)sum;
+}
+
+/***
+ * @doc(function): vec_minmax_i32
+ * @tag: all
+ *
+ * @brief: Smallest and largest element of a `Vec(i32)`.
+ *
+ * @param(min): receives the smallest element
+ * @assert(min): `min != NULL`
+ *
+ * @param(max): receives the largest element
+ * @assert(max): `max != NULL`
+ *
+ * @return: `false` if the vec is empty, then `min` and `max` are unchanged
+ */
+static bool vec_minmax_i32(const Vec *vec_, i32 *min, i32 *max) {
+  debug_check(vec_);
+  debug_check(min);
+  debug_check(max);
+
+  const Vec(i32) *vec = vec_;
+  const i32 *element = vec->element;
+  const usize length = vec->length;
+  if (!length) {
+    return false;
+  }
+  i32 low = element[0];
+  i32 high = element[0];
+  usize i = 0;
+#if defined(VEC_SCAN_AVX2)
+  if (length >= 8) {
+    __m256i lows = _mm256_loadu_si256((const __m256i_u *)element);
+    __m256i highs = lows;
+    for (i = 8; i + 8 <= length; i += 8) {
+      const __m256i data =
+          _mm256_loadu_si256((const __m256i_u *)&element[i]);
+      lows = _mm256_min_epi32(lows, data);
+      highs = _mm256_max_epi32(highs, data);
+    }
+    i32 lanes[2][8];
+    _mm256_storeu_si256((__m256i_u *)lanes[0], lows);
+    _mm256_storeu_si256((__m256i_u *)lanes[1], highs);
+    for (usize l = 0; l < 8; ++l) {
+      low = lanes[0][l] < low ? lanes[0][l] : low;
+      high = lanes[1][l] > high ? lanes[1][l] : high;
+    }
+  }
+#elif defined(VEC_SCAN_SSE2)
+  // SSE2 has no 32 bit min and max, they are selected by comparisons
+  if (length >= 4) {
+    __m128i lows = _mm_loadu_si128((const __m128i_u *)element);
+    __m128i highs = lows;
+    for (i = 4; i + 4 <= length; i += 4) {
+      const __m128i data = _mm_loadu_si128((const __m128i_u *)&element[i]);
+      const __m128i less = _mm_cmplt_epi32(data, lows);
+      const __m128i greater = _mm_cmpgt_epi32(data, highs);
+      lows = _mm_or_si128(_mm_and_si128(less, data),
+                          _mm_andnot_si128(less, lows));
+      highs = _mm_or_si128(_mm_and_si128(greater, data),
+                           _mm_andnot_si128(greater, highs));
+    }
+    i32 lanes[2][4];
+    _mm_storeu_si128((__m128i_u *)lanes[0], lows);
+    _mm_storeu_si128((__m128i_u *)lanes[1], highs);
+    for (usize l = 0; l < 4; ++l) {
+      low = lanes[0][l] < low ? lanes[0][l] : low;
+      high = lanes[1][l] > high ? lanes[1][l] : high;
+    }
+  }
+#elif defined(VEC_SCAN_NEON)
+  if (length >= 4) {
+    int32x4_t lows = vld1q_s32(element);
+    int32x4_t highs = lows;
+    for (i = 4; i + 4 <= length; i += 4) {
+      const int32x4_t data = vld1q_s32(&element[i]);
+      lows = vminq_s32(lows, data);
+      highs = vmaxq_s32(highs, data);
+    }
+    low = vminvq_s32(lows);
+    high = vmaxvq_s32(highs);
+  }
+#endif
+  for (; i < length; ++i) {
+    low = element[i] < low ? element[i] : low;
+    high = element[i] > high ? element[i] : high;
+  }
+  *min = low;
+  *max = high;
+  return true;
+}
+
+/***
+ * @doc(function): vec_minmax_f32
+ * @tag: all
+ *
+ * @brief: Smallest and largest element of a `Vec(float)`, ignoring NaNs.
+ *
+ * @detailed: If the vec holds both `-0.0` and `0.0` either may be returned.
+ *
+ * @param(min): receives the smallest element
+ * @assert(min): `min != NULL`
+ *
+ * @param(max): receives the largest element
+ * @assert(max): `max != NULL`
+ *
+ * @return: `false` if the vec is empty or only holds NaNs, then `min` and
+ * `max` are unchanged
+ */
+static bool vec_minmax_f32(const Vec *vec_, float *min, float *max) {
+  debug_check(vec_);
+  debug_check(min);
+  debug_check(max);
+
+  const Vec(float) *vec = vec_;
+  const float *element = vec->element;
+  const usize length = vec->length;
+  float low = INFINITY;
+  float high = -INFINITY;
+  usize i = 0;
+  // the min and max instructions return their second operand if either is
+  // NaN, so the accumulators go second and never become NaN
+#if defined(VEC_SCAN_AVX2)
+  __m256 lows[2] = {_mm256_set1_ps(INFINITY), _mm256_set1_ps(INFINITY)};
+  __m256 highs[2] = {_mm256_set1_ps(-INFINITY), _mm256_set1_ps(-INFINITY)};
+  // two accumulators hide the latency of the comparisons
+  for (; i + 16 <= length; i += 16) {
+    for (usize a = 0; a < 2; ++a) {
+      const __m256 data = _mm256_loadu_ps(&element[i + 8 * a]);
+      lows[a] = _mm256_min_ps(data, lows[a]);
+      highs[a] = _mm256_max_ps(data, highs[a]);
+    }
+  }
+  float lanes[2][8];
+  _mm256_storeu_ps(lanes[0], _mm256_min_ps(lows[0], lows[1]));
+  _mm256_storeu_ps(lanes[1], _mm256_max_ps(highs[0], highs[1]));
+  for (usize l = 0; l < 8; ++l) {
+    low = lanes[0][l] < low ? lanes[0][l] : low;
+    high = lanes[1][l] > high ? lanes[1][l] : high;
+  }
+#elif defined(VEC_SCAN_SSE2)
+  __m128 lows[2] = {_mm_set1_ps(INFINITY), _mm_set1_ps(INFINITY)};
+  __m128 highs[2] = {_mm_set1_ps(-INFINITY), _mm_set1_ps(-INFINITY)};
+  for (; i + 8 <= length; i += 8) {
+    for (usize a = 0; a < 2; ++a) {
+      const __m128 data = _mm_loadu_ps(&element[i + 4 * a]);
+      lows[a] = _mm_min_ps(data, lows[a]);
+      highs[a] = _mm_max_ps(data, highs[a]);
+    }
+  }
+  float lanes[2][4];
+  _mm_storeu_ps(lanes[0], _mm_min_ps(lows[0], lows[1]));
+  _mm_storeu_ps(lanes[1], _mm_max_ps(highs[0], highs[1]));
+  for (usize l = 0; l < 4; ++l) {
+    low = lanes[0][l] < low ? lanes[0][l] : low;
+    high = lanes[1][l] > high ? lanes[1][l] : high;
+  }
+#elif defined(VEC_SCAN_NEON)
+  // the `nm` variants ignore NaNs
+  float32x4_t lows = vdupq_n_f32(INFINITY);
+  float32x4_t highs = vdupq_n_f32(-INFINITY);
+  for (; i + 4 <= length; i += 4) {
+    const float32x4_t data = vld1q_f32(&element[i]);
+    lows = vminnmq_f32(lows, data);
+    highs = vmaxnmq_f32(highs, data);
+  }
+  low = vminnmvq_f32(lows);
+  high = vmaxnmvq_f32(highs);
+#endif
+  for (; i < length; ++i) {
+    low = element[i] < low ? element[i] : low;
+    high = element[i] > high ? element[i] : high;
+  }
+  if (!(low <= high)) {
+    return false;
+  }
+  *min = low;
+  *max = high;
+  return true;
+}
+
+static void vec_scan_dummy_callee__(void);
+static void vec_scan_dummy_caller__(void) {
+  vec_find_u8(NULL, 0);
+  vec_find_u32(NULL, 0);
+  vec_find_u64(NULL, 0);
+  vec_count_eq_u8(NULL, 0);
+  vec_count_eq_u32(NULL, 0);
+  vec_sum_i32(NULL);
+  vec_sum_i64(NULL);
+  vec_minmax_i32(NULL, NULL, NULL);
+  vec_minmax_f32(NULL, NULL, NULL);
+  vec_scan_dummy_callee__();
+}
+static void vec_scan_dummy_callee__(void) { vec_scan_dummy_caller__(); }
+
+#endif // VEC_SCAN_H_
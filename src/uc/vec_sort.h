@@ -0,0 +1,759 @@
+#ifndef VEC_SORT_H_
+#define VEC_SORT_H_
+
+#include <uc/thread.h>
+#include <uc/vec.h>
+
+/***
+ * @file
+ * Sorting of vecs. `vec_sort` is a comparison sort for any order,
+ * `vec_sort_by_key` a radix sort for orders given by an integer key which may
+ * use several threads. Requires `thread.h` and therefore `-pthread`.
+ */
+
+/***
+ * @doc(type): vec_element_less_f
+ * @tag: all
+ *
+ * @brief: Strict weak order of the elements, `true` if `first` is sorted
+ * before `second`.
+ */
+typedef bool (*vec_element_less_f)(const void *first, const void *second,
+                                   void *ctx);
+
+/***
+ * @doc(type): vec_element_key_f
+ * @tag: all
+ *
+ * @brief: Key of an element, elements are sorted by ascending keys.
+ * `vec_sort_key_i64` and `vec_sort_key_f64` map signed and floating point
+ * keys to ones which sort the same.
+ */
+typedef u64 (*vec_element_key_f)(const void *element, void *ctx);
+
+// ranges shorter than this are insertion sorted
+#define VEC_SORT_INTERNAL_INSERTION 24
+// ranges longer than this take the median of three medians as pivot
+#define VEC_SORT_INTERNAL_NINTHER 128
+// moves allowed to the insertion sort of a range found already partitioned
+#define VEC_SORT_INTERNAL_PARTIAL_LIMIT 8
+// radix buckets up to this length are insertion sorted by key
+#define VEC_SORT_INTERNAL_RADIX_INSERTION 64
+#define VEC_SORT_INTERNAL_MAX_THREADS 64
+// vecs shorter than this are radix sorted by the calling thread alone
+#define VEC_SORT_INTERNAL_PARALLEL_MIN ((usize)1 << 16)
+
+/***
+ * @doc(function): vec_sort_key_i64
+ * @tag: all
+ *
+ * @brief: Maps a signed key to an unsigned one in the same order.
+ */
+static u64 vec_sort_key_i64(i64 value) {
+  return (u64)value ^ ((u64)1 << 63);
+}
+
+/***
+ * @doc(function): vec_sort_key_f64
+ * @tag: all
+ *
+ * @brief: Maps a floating point key to an unsigned one in the same order.
+ *
+ * @detailed: `-0.0` sorts before `0.0`, NaNs with the sign bit set before
+ * everything else and the other NaNs after everything else.
+ */
+static u64 vec_sort_key_f64(double value) {
+  u64 bits;
+  builtin_memcpy(&bits, &value, sizeof(bits));
+  return bits >> 63 ? ~bits : bits | ((u64)1 << 63);
+}
+
+// ********************************COMPARISON*********************************
+
+typedef struct VecSortInternal VecSortInternal;
+struct VecSortInternal {
+  byte *element;
+  usize element_size;
+  vec_element_less_f less;
+  void *ctx;
+};
+
+static bool vec_sort_internal_less(const VecSortInternal *sort, usize first,
+                                   usize second) {
+  return sort->less(sort->element + first * sort->element_size,
+                    sort->element + second * sort->element_size, sort->ctx);
+}
+
+static void vec_sort_internal_swap(const VecSortInternal *sort, usize first,
+                                   usize second) {
+  byte *a = sort->element + first * sort->element_size;
+  byte *b = sort->element + second * sort->element_size;
+  if (sort->element_size == sizeof(u64)) {
+    u64 t;
+    builtin_memcpy(&t, a, sizeof(u64));
+    builtin_memcpy(a, b, sizeof(u64));
+    builtin_memcpy(b, &t, sizeof(u64));
+    return;
+  }
+  byte t[64];
+  for (usize left = sort->element_size; left;) {
+    const usize n = left < sizeof(t) ? left : sizeof(t);
+    builtin_memcpy(t, a, n);
+    builtin_memcpy(a, b, n);
+    builtin_memcpy(b, t, n);
+    a += n;
+    b += n;
+    left -= n;
+  }
+}
+
+static void vec_sort_internal_sort3(const VecSortInternal *sort, usize a,
+                                    usize b, usize c) {
+  if (vec_sort_internal_less(sort, b, a)) {
+    vec_sort_internal_swap(sort, a, b);
+  }
+  if (vec_sort_internal_less(sort, c, b)) {
+    vec_sort_internal_swap(sort, b, c);
+    if (vec_sort_internal_less(sort, b, a)) {
+      vec_sort_internal_swap(sort, a, b);
+    }
+  }
+}
+
+// insertion sort of [begin, end) which gives up once more than `limit`
+// elements had to be moved, returns whether the range is sorted
+static bool vec_sort_internal_insertion(const VecSortInternal *sort,
+                                        usize begin, usize end, usize limit) {
+  usize moves = 0;
+  for (usize i = begin + 1; i < end; ++i) {
+    usize j = i;
+    while (j > begin && vec_sort_internal_less(sort, j, j - 1)) {
+      vec_sort_internal_swap(sort, j, j - 1);
+      j -= 1;
+    }
+    moves += i - j;
+    if (moves > limit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void vec_sort_internal_sift_down(const VecSortInternal *sort,
+                                        usize begin, usize root, usize n) {
+  for (usize child; (child = 2 * root + 1) < n; root = child) {
+    if (child + 1 < n &&
+        vec_sort_internal_less(sort, begin + child, begin + child + 1)) {
+      child += 1;
+    }
+    if (!vec_sort_internal_less(sort, begin + root, begin + child)) {
+      return;
+    }
+    vec_sort_internal_swap(sort, begin + root, begin + child);
+  }
+}
+
+static void vec_sort_internal_heap_sort(const VecSortInternal *sort,
+                                        usize begin, usize end) {
+  const usize n = end - begin;
+  for (usize i = n / 2; i-- > 0;) {
+    vec_sort_internal_sift_down(sort, begin, i, n);
+  }
+  for (usize i = n - 1; i > 0; --i) {
+    vec_sort_internal_swap(sort, begin, begin + i);
+    vec_sort_internal_sift_down(sort, begin, 0, i);
+  }
+}
+
+// partitions (begin, end) around the pivot at `begin` into the elements less
+// than it and the rest, moves the pivot between them and returns its index.
+// `already` is set if no element had to be moved
+static usize vec_sort_internal_partition_right(const VecSortInternal *sort,
+                                               usize begin, usize end,
+                                               bool *already) {
+  usize i = begin + 1;
+  usize j = end - 1;
+  while (i <= j && vec_sort_internal_less(sort, i, begin)) {
+    i += 1;
+  }
+  while (i <= j && !vec_sort_internal_less(sort, j, begin)) {
+    j -= 1;
+  }
+  *already = i > j;
+  // the elements just swapped stop the scans, no bounds needed
+  while (i < j) {
+    vec_sort_internal_swap(sort, i, j);
+    i += 1;
+    j -= 1;
+    while (vec_sort_internal_less(sort, i, begin)) {
+      i += 1;
+    }
+    while (!vec_sort_internal_less(sort, j, begin)) {
+      j -= 1;
+    }
+  }
+  vec_sort_internal_swap(sort, begin, i - 1);
+  return i - 1;
+}
+
+// like `vec_sort_internal_partition_right`, but the elements equal to the
+// pivot go to the left. Used when the pivot equals the one of the enclosing
+// range, then the left side only holds equal elements and is done
+static usize vec_sort_internal_partition_left(const VecSortInternal *sort,
+                                              usize begin, usize end) {
+  usize i = begin + 1;
+  usize j = end - 1;
+  while (i <= j && !vec_sort_internal_less(sort, begin, i)) {
+    i += 1;
+  }
+  while (i <= j && vec_sort_internal_less(sort, begin, j)) {
+    j -= 1;
+  }
+  while (i < j) {
+    vec_sort_internal_swap(sort, i, j);
+    i += 1;
+    j -= 1;
+    while (!vec_sort_internal_less(sort, begin, i)) {
+      i += 1;
+    }
+    while (vec_sort_internal_less(sort, begin, j)) {
+      j -= 1;
+    }
+  }
+  vec_sort_internal_swap(sort, begin, i - 1);
+  return i - 1;
+}
+
+// pattern defeating quicksort of [begin, end). `bad_allowed` unbalanced
+// partitions are tolerated before falling back to heap sort, `leftmost` is
+// unset if `begin - 1` holds the pivot of an enclosing range
+static void vec_sort_internal_loop(const VecSortInternal *sort, usize begin,
+                                   usize end, usize bad_allowed,
+                                   bool leftmost) {
+  while (1) {
+    const usize n = end - begin;
+    if (n < VEC_SORT_INTERNAL_INSERTION) {
+      (void)vec_sort_internal_insertion(sort, begin, end, (usize)-1);
+      return;
+    }
+
+    const usize half = begin + n / 2;
+    if (n > VEC_SORT_INTERNAL_NINTHER) {
+      vec_sort_internal_sort3(sort, begin, half, end - 1);
+      vec_sort_internal_sort3(sort, begin + 1, half - 1, end - 2);
+      vec_sort_internal_sort3(sort, begin + 2, half + 1, end - 3);
+      vec_sort_internal_sort3(sort, half - 1, half, half + 1);
+      vec_sort_internal_swap(sort, begin, half);
+    } else {
+      vec_sort_internal_sort3(sort, half, begin, end - 1);
+    }
+
+    // many equal elements: everything equal to the pivot is put into place
+    // at once
+    if (!leftmost && !vec_sort_internal_less(sort, begin - 1, begin)) {
+      begin = vec_sort_internal_partition_left(sort, begin, end) + 1;
+      continue;
+    }
+
+    bool already = false;
+    const usize mid =
+        vec_sort_internal_partition_right(sort, begin, end, &already);
+    const usize l = mid - begin;
+    const usize r = end - mid - 1;
+
+    if (l < n / 8 || r < n / 8) {
+      if (!--bad_allowed) {
+        vec_sort_internal_heap_sort(sort, begin, end);
+        return;
+      }
+      // breaks up patterns which produce bad pivots
+      if (l >= VEC_SORT_INTERNAL_INSERTION) {
+        vec_sort_internal_swap(sort, begin, begin + l / 4);
+        vec_sort_internal_swap(sort, mid - 1, mid - l / 4);
+      }
+      if (r >= VEC_SORT_INTERNAL_INSERTION) {
+        vec_sort_internal_swap(sort, mid + 1, mid + 1 + r / 4);
+        vec_sort_internal_swap(sort, end - 1, end - r / 4);
+      }
+    } else if (already &&
+               vec_sort_internal_insertion(sort, begin, mid,
+                                           VEC_SORT_INTERNAL_PARTIAL_LIMIT) &&
+               vec_sort_internal_insertion(sort, mid + 1, end,
+                                           VEC_SORT_INTERNAL_PARTIAL_LIMIT)) {
+      // likely sorted already
+      return;
+    }
+
+    // recursing into the smaller side bounds the stack depth
+    if (l < r) {
+      vec_sort_internal_loop(sort, begin, mid, bad_allowed, leftmost);
+      begin = mid + 1;
+      leftmost = false;
+    } else {
+      vec_sort_internal_loop(sort, mid + 1, end, bad_allowed, false);
+      end = mid;
+    }
+  }
+}
+
+/***
+ * @doc(function): vec_sort
+ * @tag: all
+ *
+ * @brief: Sorts the elements of `vec` by `less`, in place and without
+ * allocating.
+ *
+ * @detailed: A pattern defeating quicksort: median of three or, for longer
+ * ranges, median of three medians pivots, insertion sort for short ranges,
+ * equal elements are put into place with a single partition and ranges
+ * found already partitioned are finished with an insertion sort if that
+ * stays cheap. Falls back to heap sort after too many unbalanced partitions,
+ * so it runs in `O(n log n)`. Not stable. `vec_sort_by_key` is much faster
+ * if the order is given by an integer key.
+ *
+ * @param(vec): vec to sort
+ * @assert(vec): `vec != NULL`
+ *
+ * @param(element_size): size of the elements in the vec
+ * @assert(element_size): `element_size > 0`
+ *
+ * @param(less): order of the elements
+ * @assert(less): `less != NULL`
+ *
+ * @param(ctx): passed to `less`
+ */
+static void vec_sort(Vec *vec_, usize element_size, vec_element_less_f less,
+                     void *ctx) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(less);
+
+  Vec(byte) *vec = vec_;
+  if (vec->length < 2) {
+    return;
+  }
+  VecSortInternal sort = {0};
+  sort.element = vec->element;
+  sort.element_size = element_size;
+  sort.less = less;
+  sort.ctx = ctx;
+  // log2 of the length
+  const usize bad_allowed = 64 - (usize)builtin_clzll(vec->length);
+  vec_sort_internal_loop(&sort, 0, vec->length, bad_allowed, true);
+}
+
+// ***********************************RADIX***********************************
+
+typedef struct VecSortInternalRadix VecSortInternalRadix;
+struct VecSortInternalRadix {
+  // `NULL` if the elements are the keys
+  byte *element;
+  byte *element_tmp;
+  u64 *key;
+  u64 *key_tmp;
+  usize element_size;
+  usize count;
+  usize num_threads;
+  vec_element_key_f key_of;
+  void *ctx;
+  u64 first;
+  // bits in which the keys differ from `first`, per thread
+  u64 diff[VEC_SORT_INTERNAL_MAX_THREADS];
+  // whether the keys of the thread's share are ascending
+  bool sorted[VEC_SORT_INTERNAL_MAX_THREADS];
+  // shift of the most significant byte in which the keys differ
+  usize shift;
+  // `num_threads` histograms of that byte, turned into write cursors
+  usize (*count_of)[256];
+  // 257 offsets of the buckets in the scattered arrays
+  usize *bucket_begin;
+  usize next_bucket;
+};
+
+typedef struct VecSortInternalWorker VecSortInternalWorker;
+struct VecSortInternalWorker {
+  VecSortInternalRadix *radix;
+  usize thread;
+};
+
+static void vec_sort_internal_copy(byte *dest, const byte *src,
+                                   usize element_size) {
+  // constant sizes let the copy be inlined
+  switch (element_size) {
+  case 4:
+    builtin_memcpy(dest, src, 4);
+    break;
+  case 8:
+    builtin_memcpy(dest, src, 8);
+    break;
+  case 16:
+    builtin_memcpy(dest, src, 16);
+    break;
+  default:
+    builtin_memcpy(dest, src, element_size);
+  }
+}
+
+// stable insertion sort by key of `n` keys and their elements
+static void vec_sort_internal_insertion_by_key(u64 *key, byte *element,
+                                               usize element_size, usize n) {
+  byte t[64];
+  for (usize i = 1; i < n; ++i) {
+    const u64 k = key[i];
+    if (key[i - 1] <= k) {
+      continue;
+    }
+    if (element && element_size > sizeof(t)) {
+      // too large to hold aside, swapped down instead
+      for (usize j = i; j > 0 && key[j - 1] > key[j]; --j) {
+        const u64 tk = key[j];
+        key[j] = key[j - 1];
+        key[j - 1] = tk;
+        VecSortInternal sort = {element, element_size, NULL, NULL};
+        vec_sort_internal_swap(&sort, j, j - 1);
+      }
+      continue;
+    }
+    usize j = i;
+    if (element) {
+      builtin_memcpy(t, element + i * element_size, element_size);
+    }
+    for (; j > 0 && key[j - 1] > k; --j) {
+      key[j] = key[j - 1];
+    }
+    if (element) {
+      (void)builtin_memmove(element + (j + 1) * element_size,
+                            element + j * element_size,
+                            (i - j) * element_size);
+      builtin_memcpy(element + j * element_size, t, element_size);
+    }
+    key[j] = k;
+  }
+}
+
+// radix sort of [begin, end) by the bytes below `shift`. The range is read
+// from the scratch arrays if `in_tmp`, else from the original ones, the
+// result always ends up in the original arrays. Keys differing in only a few
+// bytes are sorted least significant byte first. Otherwise the range is split
+// by its most significant differing byte first, as the parts often become
+// short enough for the insertion sort long before the last byte
+static void vec_sort_internal_bucket(const VecSortInternalRadix *radix,
+                                     usize begin, usize end, usize shift,
+                                     bool in_tmp) {
+  const usize n = end - begin;
+  const usize es = radix->element_size;
+  u64 *src_key = (in_tmp ? radix->key_tmp : radix->key) + begin;
+  u64 *dest_key = (in_tmp ? radix->key : radix->key_tmp) + begin;
+  byte *src = NULL;
+  byte *dest = NULL;
+  if (radix->element) {
+    src = (in_tmp ? radix->element_tmp : radix->element) + begin * es;
+    dest = (in_tmp ? radix->element : radix->element_tmp) + begin * es;
+  }
+
+  if (n <= VEC_SORT_INTERNAL_RADIX_INSERTION) {
+    vec_sort_internal_insertion_by_key(src_key, src, es, n);
+  } else {
+    const usize num_digits = shift / 8;
+    usize count_of[8][256];
+    builtin_memset(count_of, 0, num_digits * sizeof(count_of[0]));
+    for (usize i = 0; i < n; ++i) {
+      const u64 k = src_key[i];
+      for (usize d = 0; d < num_digits; ++d) {
+        count_of[d][(k >> (8 * d)) & 0xff] += 1;
+      }
+    }
+    // digits in which the keys differ, least significant first
+    usize digits[8];
+    usize num_varying = 0;
+    for (usize d = 0; d < num_digits; ++d) {
+      if (count_of[d][(src_key[0] >> (8 * d)) & 0xff] != n) {
+        digits[num_varying++] = d;
+      }
+    }
+    const bool split = num_varying > 2;
+
+    for (usize v = split ? num_varying - 1 : 0; v < num_varying; ++v) {
+      const usize d = digits[v];
+      usize offset = 0;
+      usize bucket_begin[257];
+      for (usize b = 0; b < 256; ++b) {
+        bucket_begin[b] = offset;
+        const usize c = count_of[d][b];
+        count_of[d][b] = offset;
+        offset += c;
+      }
+      bucket_begin[256] = n;
+      for (usize i = 0; i < n; ++i) {
+        const u64 k = src_key[i];
+        const usize to = count_of[d][(k >> (8 * d)) & 0xff]++;
+        dest_key[to] = k;
+        if (src) {
+          vec_sort_internal_copy(dest + to * es, src + i * es, es);
+        }
+      }
+
+      if (split) {
+        // the parts are in the other arrays now
+        for (usize b = 0; b < 256; ++b) {
+          const usize i = bucket_begin[b];
+          const usize part = bucket_begin[b + 1] - i;
+          if (part > 1) {
+            vec_sort_internal_bucket(radix, begin + i, begin + i + part,
+                                     8 * d, !in_tmp);
+          } else if (part && !in_tmp) {
+            src_key[i] = dest_key[i];
+            if (src) {
+              vec_sort_internal_copy(src + i * es, dest + i * es, es);
+            }
+          }
+        }
+        return;
+      }
+
+      u64 *t_key = src_key;
+      src_key = dest_key;
+      dest_key = t_key;
+      byte *t = src;
+      src = dest;
+      dest = t;
+    }
+  }
+
+  if (src_key != radix->key + begin) {
+    builtin_memcpy(radix->key + begin, src_key, n * sizeof(u64));
+    if (src) {
+      builtin_memcpy(radix->element + begin * es, src, n * es);
+    }
+  }
+}
+
+static void vec_sort_internal_keys(void *worker_) {
+  VecSortInternalWorker *worker = worker_;
+  VecSortInternalRadix *radix = worker->radix;
+
+  const usize begin = radix->count * worker->thread / radix->num_threads;
+  const usize end = radix->count * (worker->thread + 1) / radix->num_threads;
+  if (radix->element) {
+    const byte *element = radix->element + begin * radix->element_size;
+    for (usize i = begin; i < end; ++i) {
+      radix->key[i] = radix->key_of(element, radix->ctx);
+      element += radix->element_size;
+    }
+  }
+  u64 diff = 0;
+  usize descents = 0;
+  for (usize i = begin; i < end; ++i) {
+    diff |= radix->key[i] ^ radix->first;
+    descents += i > begin && radix->key[i - 1] > radix->key[i];
+  }
+  radix->diff[worker->thread] = diff;
+  radix->sorted[worker->thread] = !descents;
+}
+
+static void vec_sort_internal_histogram(void *worker_) {
+  VecSortInternalWorker *worker = worker_;
+  VecSortInternalRadix *radix = worker->radix;
+
+  const usize begin = radix->count * worker->thread / radix->num_threads;
+  const usize end = radix->count * (worker->thread + 1) / radix->num_threads;
+  usize *count_of = radix->count_of[worker->thread];
+  builtin_memset(count_of, 0, 256 * sizeof(usize));
+  for (usize i = begin; i < end; ++i) {
+    count_of[(radix->key[i] >> radix->shift) & 0xff] += 1;
+  }
+}
+
+static void vec_sort_internal_scatter(void *worker_) {
+  VecSortInternalWorker *worker = worker_;
+  VecSortInternalRadix *radix = worker->radix;
+
+  const usize begin = radix->count * worker->thread / radix->num_threads;
+  const usize end = radix->count * (worker->thread + 1) / radix->num_threads;
+  const usize es = radix->element_size;
+  usize *count_of = radix->count_of[worker->thread];
+  for (usize i = begin; i < end; ++i) {
+    const u64 k = radix->key[i];
+    const usize to = count_of[(k >> radix->shift) & 0xff]++;
+    radix->key_tmp[to] = k;
+    if (radix->element) {
+      vec_sort_internal_copy(radix->element_tmp + to * es,
+                             radix->element + i * es, es);
+    }
+  }
+}
+
+static void vec_sort_internal_buckets(void *worker_) {
+  VecSortInternalWorker *worker = worker_;
+  VecSortInternalRadix *radix = worker->radix;
+
+  usize b;
+  while ((b = __atomic_fetch_add(&radix->next_bucket, 1, __ATOMIC_RELAXED)) <
+         256) {
+    vec_sort_internal_bucket(radix, radix->bucket_begin[b],
+                             radix->bucket_begin[b + 1], radix->shift, true);
+  }
+}
+
+// runs `function` once for every thread of `radix`, the calling thread takes
+// the first share. Shares whose thread could not be spawned run inline
+static void vec_sort_internal_run(VecSortInternalRadix *radix,
+                                  thread_f function) {
+  VecSortInternalWorker workers[VEC_SORT_INTERNAL_MAX_THREADS];
+  Thread threads[VEC_SORT_INTERNAL_MAX_THREADS];
+  bool spawned[VEC_SORT_INTERNAL_MAX_THREADS];
+
+  for (usize t = 0; t < radix->num_threads; ++t) {
+    workers[t].radix = radix;
+    workers[t].thread = t;
+    spawned[t] = false;
+  }
+  for (usize t = 1; t < radix->num_threads; ++t) {
+    Error error = 0;
+    thread_spawn(&threads[t], function, &workers[t], &error);
+    spawned[t] = !error;
+  }
+  function(&workers[0]);
+  for (usize t = 1; t < radix->num_threads; ++t) {
+    if (spawned[t]) {
+      thread_join(&threads[t]);
+    } else {
+      function(&workers[t]);
+    }
+  }
+}
+
+/***
+ * @doc(function): vec_sort_by_key
+ * @tag: all
+ *
+ * @brief: Stably sorts the elements of `vec` by ascending `key`.
+ *
+ * @detailed: A radix sort, no comparisons. `key` is called once per element.
+ * The elements are first distributed by the most significant byte in which
+ * the keys differ, in parallel, each of the resulting 256 buckets is then
+ * sorted by the remaining bytes by one thread. Buckets whose keys differ in
+ * few bytes are sorted least significant byte first, others are split
+ * further by their most significant differing byte. Bytes which all keys of
+ * a bucket share are skipped, and vecs already sorted are detected while
+ * computing the keys. Needs a scratch buffer of about
+ * `length * (element_size + 16)` bytes, `length * 8` if `key` is `NULL`.
+ *
+ * @param(vec): vec to sort
+ * @assert(vec): `vec != NULL`
+ *
+ * @param(element_size): size of the elements in the vec
+ * @assert(element_size): `element_size > 0`
+ *
+ * @param(key): key of an element, `NULL` sorts a `Vec(u64)` by its elements
+ * @assert(key): `key != NULL || element_size == sizeof(u64)`
+ *
+ * @param(ctx): passed to `key`
+ *
+ * @param(num_threads): number of threads sorting, the calling thread is one
+ * of them. `0` is treated as `1`, vecs shorter than `65536` elements are
+ * sorted by the calling thread only
+ *
+ * @param(allocator): allocator of the scratch buffer
+ * @assert(allocator): `allocator != NULL`
+ *
+ * @error: each error which the provided allocator may invoke, the vec is left
+ * unchanged
+ */
+static void vec_sort_by_key(Vec *vec_, usize element_size,
+                            vec_element_key_f key, void *ctx,
+                            usize num_threads, Allocator *allocator,
+                            Error *error) {
+  debug_check(vec_);
+  debug_check(element_size > 0);
+  debug_check(key || element_size == sizeof(u64));
+  debug_check(allocator);
+
+  Vec(byte) *vec = vec_;
+  const usize count = vec->length;
+  if (count < 2) {
+    return;
+  }
+
+  VecSortInternalRadix radix = {0};
+  radix.element_size = element_size;
+  radix.count = count;
+  radix.key_of = key;
+  radix.ctx = ctx;
+  radix.num_threads = num_threads ? num_threads : 1;
+  if (radix.num_threads > VEC_SORT_INTERNAL_MAX_THREADS) {
+    radix.num_threads = VEC_SORT_INTERNAL_MAX_THREADS;
+  }
+  if (count < VEC_SORT_INTERNAL_PARALLEL_MIN) {
+    radix.num_threads = 1;
+  }
+
+  // element copies first to keep the keys aligned
+  const usize keys_offset =
+      key ? (count * element_size + sizeof(u64) - 1) & ~(sizeof(u64) - 1) : 0;
+  const usize num_keys = key ? 2 * count : count;
+  byte *scratch = allocator_alloc(
+      allocator,
+      keys_offset + num_keys * sizeof(u64) +
+          (radix.num_threads * 256 + 257) * sizeof(usize),
+      error);
+  if (UNLIKELY(error && *error)) {
+    return;
+  }
+  if (key) {
+    radix.element = vec->element;
+    radix.element_tmp = scratch;
+    radix.key = (u64 *)(scratch + keys_offset);
+    radix.key_tmp = radix.key + count;
+  } else {
+    radix.key = (u64 *)vec->element;
+    radix.key_tmp = (u64 *)scratch;
+  }
+  radix.count_of = (usize(*)[256])(radix.key_tmp + count);
+  radix.bucket_begin = radix.count_of[radix.num_threads];
+
+  radix.first = key ? key(vec->element, ctx) : radix.key[0];
+  vec_sort_internal_run(&radix, vec_sort_internal_keys);
+  u64 diff = 0;
+  bool sorted = true;
+  for (usize t = 0; t < radix.num_threads; ++t) {
+    const usize begin = count * t / radix.num_threads;
+    diff |= radix.diff[t];
+    sorted &= radix.sorted[t] &&
+              (!t || radix.key[begin - 1] <= radix.key[begin]);
+  }
+  if (!diff || sorted) {
+    allocator_free(allocator, scratch);
+    return;
+  }
+  radix.shift = (63 - (usize)builtin_clzll(diff)) & ~(usize)7;
+
+  vec_sort_internal_run(&radix, vec_sort_internal_histogram);
+  usize offset = 0;
+  for (usize b = 0; b < 256; ++b) {
+    radix.bucket_begin[b] = offset;
+    for (usize t = 0; t < radix.num_threads; ++t) {
+      const usize c = radix.count_of[t][b];
+      radix.count_of[t][b] = offset;
+      offset += c;
+    }
+  }
+  radix.bucket_begin[256] = offset;
+
+  vec_sort_internal_run(&radix, vec_sort_internal_scatter);
+  vec_sort_internal_run(&radix, vec_sort_internal_buckets);
+
+  allocator_free(allocator, scratch);
+}
+
+static void vec_sort_dummy_callee__(void);
+static void vec_sort_dummy_caller__(void) {
+  vec_sort_key_i64(0);
+  vec_sort_key_f64(0);
+  vec_sort(NULL, 0, NULL, NULL);
+  vec_sort_by_key(NULL, 0, NULL, NULL, 0, NULL, NULL);
+  vec_sort_dummy_callee__();
+}
+static void vec_sort_dummy_callee__(void) { vec_sort_dummy_caller__(); }
+
+#endif // VEC_SORT_H_
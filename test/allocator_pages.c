@@ -0,0 +1,78 @@
+#include "test.h"
+#include <uc/allocator_pages.h>
+#include <uc/vec.h>
+
+static void test__chunks(void) {
+  Error error = 0;
+  u64 *small = allocator_alloc(allocator_pages, 100 * sizeof(u64), &error);
+  TEST_INT(error, 0);
+  TEST_INT((usize)small % 16, 0);
+  TEST_INT(((AllocatorPagesHeader *)small - 1)->mapped, 0);
+  for (u64 i = 0; i < 100; ++i) {
+    small[i] = i;
+  }
+
+  // growing past the threshold moves the chunk into a mapping
+  u64 *large = allocator_realloc(allocator_pages, small,
+                                 ALLOCATOR_PAGES_THRESHOLD * 4, &error);
+  TEST_INT(error, 0);
+  TEST_INT(((AllocatorPagesHeader *)large - 1)->mapped, 1);
+  for (u64 i = 0; i < 100; ++i) {
+    TEST_INT(large[i], i);
+  }
+  const usize count = ALLOCATOR_PAGES_THRESHOLD * 4 / sizeof(u64);
+  for (u64 i = 0; i < count; ++i) {
+    large[i] = i;
+  }
+
+  large = allocator_realloc(allocator_pages, large,
+                            ALLOCATOR_PAGES_THRESHOLD * 64, &error);
+  TEST_INT(error, 0);
+  bool same = true;
+  for (u64 i = 0; i < count; ++i) {
+    same &= large[i] == i;
+  }
+  TEST_INT(same, 1);
+
+  // mapped chunks stay mapped when they shrink
+  large = allocator_realloc(allocator_pages, large, 16 * sizeof(u64), &error);
+  TEST_INT(error, 0);
+  TEST_INT(((AllocatorPagesHeader *)large - 1)->mapped, 1);
+  TEST_INT(large[15], 15);
+  allocator_free(allocator_pages, large);
+
+  u64 *direct =
+      allocator_alloc(allocator_pages, ALLOCATOR_PAGES_THRESHOLD, &error);
+  TEST_INT(error, 0);
+  TEST_INT(((AllocatorPagesHeader *)direct - 1)->mapped, 1);
+  TEST_INT((usize)direct % 16, 0);
+  allocator_free(allocator_pages, direct);
+}
+
+static void test__vec(void) {
+  Vec(u64) vec;
+  Error error = 0;
+  vec_init(&vec, sizeof(u64), 1, allocator_pages, &error);
+  const u64 count = 4 * ALLOCATOR_PAGES_THRESHOLD;
+  for (u64 i = 0; i < count; ++i) {
+    vec_push(&vec, sizeof(u64), &i, allocator_pages, &error);
+  }
+  TEST_INT(error, 0);
+  TEST_INT(((AllocatorPagesHeader *)vec.element - 1)->mapped, 1);
+  bool same = true;
+  for (u64 i = 0; i < count; ++i) {
+    same &= vec.element[i] == i;
+  }
+  TEST_INT(same, 1);
+  vec_shrink(&vec, sizeof(u64), allocator_pages, &error);
+  TEST_INT(error, 0);
+  TEST_INT(vec.element[count - 1], count - 1);
+  vec_deinit(&vec, sizeof(u64), allocator_pages);
+}
+
+int main(void) {
+  test__chunks();
+  test__vec();
+  TEST_OVERVIEW();
+  return 0;
+}
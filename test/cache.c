@@ -0,0 +1,139 @@
+#include "test.h"
+#include <uc/cache.h>
+#include <uc/hash.h>
+
+typedef struct Pair Pair;
+struct Pair {
+  int key;
+  int value;
+};
+
+static bool pair_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Pair *)a)->key == ((const Pair *)b)->key;
+}
+
+static void pair_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(Pair *)dest = *(const Pair *)src;
+}
+
+static u64 pair_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32((u32)((const Pair *)d)->key);
+}
+
+// counts destroyed elements in the `usize` pointed to by `ctx`
+static void pair_destroy(void *element, void *ctx) {
+  UNUSED(element);
+  *(usize *)ctx += 1;
+}
+
+static usize destroyed = 0;
+
+static const TableVTable vtable = {
+    .element_size = sizeof(Pair),
+    .compare = pair_compare,
+    .insert = pair_insert,
+    .overwrite = pair_insert,
+    .hash = pair_hash,
+    .destroy = pair_destroy,
+    .ctx = &destroyed,
+};
+
+static void test__get_put(void) {
+  Cache cache;
+  Error error = 0;
+  cache_init(&cache, &vtable, 100, allocator_global, &error);
+  TEST_INT(error, 0);
+  const usize end = cache.table.end;
+
+  destroyed = 0;
+  for (int i = 0; i < 100; ++i) {
+    cache_put(&cache, &vtable, &(Pair){i, i});
+  }
+  TEST_INT(cache_length(&cache), 100);
+  TEST_INT(cache.evictions, 0);
+
+  cache_put(&cache, &vtable, &(Pair){7, -7});
+  TEST_INT(cache_length(&cache), 100);
+  const Pair *pair = cache_get(&cache, &vtable, &(Pair){7, 0});
+  TEST_INT(pair != NULL, 1);
+  TEST_INT(pair->value, -7);
+  TEST_INT(cache_get(&cache, &vtable, &(Pair){100, 0}) == NULL, 1);
+  TEST_INT(cache.hits, 1);
+  TEST_INT(cache.misses, 1);
+
+  // the cache stays at its capacity and never reallocates
+  for (int i = 100; i < 10000; ++i) {
+    cache_put(&cache, &vtable, &(Pair){i, i});
+    TEST_INT(cache_length(&cache), 100);
+  }
+  TEST_INT(cache.table.end, end);
+  TEST_INT(cache.evictions, 9900);
+  TEST_INT(destroyed, 9900);
+
+  // everything which is still cached can be found
+  usize found = 0;
+  for (int i = 0; i < 10000; ++i) {
+    const Pair *p = cache_get(&cache, &vtable, &(Pair){i, 0});
+    if (p) {
+      TEST_INT(p->value, i);
+      found += 1;
+    }
+  }
+  TEST_INT(found, 100);
+
+  TEST_INT(cache_remove(&cache, &vtable, &(Pair){9999, 0}), 1);
+  TEST_INT(cache_remove(&cache, &vtable, &(Pair){9999, 0}), 0);
+  TEST_INT(cache_length(&cache), 99);
+  TEST_INT(destroyed, 9901);
+
+  cache_deinit(&cache, allocator_global);
+}
+
+static void test__recency(void) {
+  Cache cache;
+  cache_init(&cache, &vtable, 64, allocator_global, NULL);
+
+  // a hot set which is read between every insert survives a stream of cold
+  // elements which are never read again
+  for (int i = 0; i < 16; ++i) {
+    cache_put(&cache, &vtable, &(Pair){i, i});
+  }
+  for (int i = 1000; i < 20000; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      cache_get(&cache, &vtable, &(Pair){j, 0});
+    }
+    cache_put(&cache, &vtable, &(Pair){i, i});
+  }
+  cache.hits = 0;
+  cache.misses = 0;
+  for (int j = 0; j < 16; ++j) {
+    TEST_INT(cache_get(&cache, &vtable, &(Pair){j, 0}) != NULL, 1);
+  }
+  TEST_INT(cache.hits, 16);
+  TEST_INT(cache.misses, 0);
+
+  cache_deinit(&cache, allocator_global);
+}
+
+static void test__capacity_one(void) {
+  Cache cache;
+  cache_init(&cache, &vtable, 1, allocator_global, NULL);
+  for (int i = 0; i < 100; ++i) {
+    cache_put(&cache, &vtable, &(Pair){i, i});
+    TEST_INT(cache_length(&cache), 1);
+    TEST_INT(cache_get(&cache, &vtable, &(Pair){i, 0}) != NULL, 1);
+  }
+  TEST_INT(cache.evictions, 99);
+  cache_deinit(&cache, allocator_global);
+}
+
+int main(void) {
+  test__get_put();
+  test__recency();
+  test__capacity_one();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "test.h"
+#include <uc/hash.h>
+
+#include <stdlib.h>
+
+static int u64_order(const void *a, const void *b) {
+  const u64 x = *(const u64 *)a;
+  const u64 y = *(const u64 *)b;
+  return (x > y) - (x < y);
+}
+
+static usize count_duplicates(u64 *hashes, usize count) {
+  qsort(hashes, count, sizeof(*hashes), u64_order);
+  usize duplicates = 0;
+  for (usize i = 1; i < count; ++i) {
+    duplicates += hashes[i - 1] == hashes[i];
+  }
+  return duplicates;
+}
+
+static void test__bytes(void) {
+  byte data[256];
+  for (usize i = 0; i < sizeof(data); ++i) {
+    data[i] = (byte)(i * 7 + 3);
+  }
+
+  // deterministic and seeded
+  TEST_INT(hash_bytes(data, 100, 1) == hash_bytes(data, 100, 1), 1);
+  TEST_INT(hash_bytes(data, 100, 1) == hash_bytes(data, 100, 2), 0);
+  TEST_INT(hash_string("useful c", 0) == hash_bytes("useful c", 8, 0), 1);
+  TEST_INT(hash_string("", 0) == hash_bytes(NULL, 0, 0), 1);
+
+  // every length takes a different path through the short input branches,
+  // prefixes of the same data must still hash differently
+  u64 hashes[sizeof(data) + 1];
+  for (usize i = 0; i <= sizeof(data); ++i) {
+    hashes[i] = hash_bytes(data, i, 0);
+  }
+  TEST_INT(count_duplicates(hashes, sizeof(data) + 1), 0);
+
+  // only the bytes inside the range are read
+  byte copy[256];
+  builtin_memcpy(copy, data, sizeof(copy));
+  copy[50] ^= 1;
+  TEST_INT(hash_bytes(data, 50, 0) == hash_bytes(copy, 50, 0), 1);
+  TEST_INT(hash_bytes(data, 51, 0) == hash_bytes(copy, 51, 0), 0);
+}
+
+static void test__avalanche(void) {
+  byte data[64] = {0};
+  for (usize length = 1; length <= sizeof(data); length += 7) {
+    const u64 hash = hash_bytes(data, length, 0);
+    usize flipped = 0;
+    for (usize bit = 0; bit < length * 8; ++bit) {
+      data[bit / 8] ^= (byte)(1 << (bit % 8));
+      flipped += builtin_popcountll(hash ^ hash_bytes(data, length, 0));
+      data[bit / 8] ^= (byte)(1 << (bit % 8));
+    }
+    // on average half of the output bits should change
+    const usize average = flipped / (length * 8);
+    TEST_INT(average >= 28 && average <= 36, 1);
+  }
+}
+
+static void test__integers(void) {
+  enum { COUNT = 1 << 16 };
+  u64 *hashes = malloc(COUNT * sizeof(*hashes));
+  for (u64 i = 0; i < COUNT; ++i) {
+    hashes[i] = hash_u64(i);
+  }
+  TEST_INT(count_duplicates(hashes, COUNT), 0);
+
+  for (u32 i = 0; i < COUNT; ++i) {
+    hashes[i] = hash_u32(i);
+  }
+  TEST_INT(count_duplicates(hashes, COUNT), 0);
+
+  // sequential keys spread evenly over both the low bits used for the table
+  // index and the top 7 bits used for the control byte
+  usize low[128] = {0};
+  usize high[128] = {0};
+  for (u64 i = 0; i < COUNT; ++i) {
+    const u64 hash = hash_u64(i);
+    low[hash & 127] += 1;
+    high[hash >> 57] += 1;
+  }
+  for (usize i = 0; i < 128; ++i) {
+    TEST_INT(low[i] > COUNT / 128 * 8 / 10, 1);
+    TEST_INT(low[i] < COUNT / 128 * 12 / 10, 1);
+    TEST_INT(high[i] > COUNT / 128 * 8 / 10, 1);
+    TEST_INT(high[i] < COUNT / 128 * 12 / 10, 1);
+  }
+
+  TEST_INT(hash_combine(1, 2) == hash_combine(2, 1), 0);
+
+  free(hashes);
+}
+
+int main(void) {
+  test__bytes();
+  test__avalanche();
+  test__integers();
+  TEST_OVERVIEW();
+  return 0;
+}
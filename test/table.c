@@ -1,6 +1,9 @@
 #include "test.h"
+#include <uc/hash.h>
 #include <uc/table.h>
 
+#include <string.h>
+
 static bool int_compare(const void *a, const void *b, void *ctx) {
   UNUSED(ctx);
   return *(const int *)a == *(const int *)b;
@@ -13,13 +16,7 @@ static void int_insert(void *dest, const void *src, void *ctx) {
 
 static u64 int_hash(const void *d, void *ctx) {
   UNUSED(ctx);
-  const char *s = d;
-  u64 hash = 1111111111111111111ul;
-  for (int i = 0; i < 4; ++i) {
-    hash *= 31;
-    hash ^= s[i];
-  }
-  return hash;
+  return hash_u32(*(const u32 *)d);
 }
 
 static const TableVTable vtable = (TableVTable){
@@ -67,8 +64,375 @@ static void test__insert_find(void) {
   table_deinit(&table, allocator_global);
 }
 
+static void test__find_many(void) {
+  Table(int) table;
+  table_init(&table, &vtable, 8, allocator_global, NULL);
+
+  int elements[1000];
+  for (int i = 0; i < 1000; ++i) {
+    elements[i] = i;
+    if (i % 2 == 0) {
+      table_insert(&table, &vtable, &i, allocator_global, NULL);
+    }
+  }
+
+  usize indices[1000];
+  bool contains[1000];
+  table_find_many(&table, &vtable, elements, 1000, indices);
+  table_contains_many(&table, &vtable, elements, 1000, contains);
+
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(indices[i], table_find(&table, &vtable, &i));
+    TEST_INT(contains[i], i % 2 == 0);
+    if (i % 2 == 0) {
+      TEST_INT(table.element[indices[i]], i);
+    }
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__incremental(void) {
+  TableVTable incremental = vtable;
+  incremental.migrate_groups = 1;
+
+  Table(int) table;
+  table_init(&table, &incremental, 8, allocator_global, NULL);
+
+  bool migrated = false;
+  for (int i = 0; i < 5000; ++i) {
+    table_insert(&table, &incremental, &i, allocator_global, NULL);
+    TEST_INT(table.length, i + 1);
+    migrated |= table.old_element != NULL;
+
+    // every element has to be reachable while the migration is in progress
+    if (i % 97 == 0) {
+      for (int j = 0; j <= i; ++j) {
+        usize index = table_find(&table, &incremental, &j);
+        TEST_INT(table_isset(&table, &incremental, index), 1);
+        TEST_INT(*(int *)table_get(&table, &incremental, index), j);
+      }
+      int not_contains_entry = i + 1;
+      TEST_INT(table_contains(&table, &incremental, &not_contains_entry), 0);
+    }
+  }
+  TEST_INT(migrated, 1);
+
+  // upsert of elements still in the old array moves them into the new one
+  for (int i = 0; i < 5000; ++i) {
+    usize index =
+        table_upsert(&table, &incremental, &i, allocator_global, NULL);
+    TEST_INT(index < table.end, 1);
+    TEST_INT(table.element[index], i);
+  }
+  TEST_INT(table.length, 5000);
+
+  table_reserve(&table, &incremental, 100000, allocator_global, NULL);
+  TEST_INT(table.old_element == NULL, 1);
+  for (int i = 0; i < 5000; ++i) {
+    TEST_INT(table_contains(&table, &incremental, &i), 1);
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void int_destroy(void *element, void *ctx) {
+  UNUSED(element);
+  *(int *)ctx += 1;
+}
+
+static void test__remove(void) {
+  int destroyed = 0;
+  TableVTable counting = vtable;
+  counting.destroy = int_destroy;
+  counting.ctx = &destroyed;
+
+  Table(int) table;
+  table_init(&table, &counting, 8, allocator_global, NULL);
+
+  for (int i = 0; i < 1000; ++i) {
+    table_insert(&table, &counting, &i, allocator_global, NULL);
+  }
+
+  for (int i = 0; i < 1000; i += 2) {
+    TEST_INT(table_remove(&table, &counting, &i), 1);
+    TEST_INT(table_remove(&table, &counting, &i), 0);
+  }
+  TEST_INT(destroyed, 500);
+  TEST_INT(table.length, 500);
+
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(table_contains(&table, &counting, &i), i % 2);
+  }
+
+  // constant churn must not grow the table, tombs are purged in place
+  const usize end = table.end;
+  for (int i = 1000; i < 200000; ++i) {
+    table_insert(&table, &counting, &i, allocator_global, NULL);
+    int old = i - 500;
+    TEST_INT(table_remove(&table, &counting, &old), old % 2 || old >= 1000);
+  }
+  TEST_INT(table.end, end);
+  TEST_INT(table.length, 750);
+  for (int i = 199000; i < 200000; ++i) {
+    if (i < 199500) {
+      TEST_INT(table_contains(&table, &counting, &i), 0);
+    } else {
+      TEST_INT(table_contains(&table, &counting, &i), 1);
+    }
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__remove_incremental(void) {
+  TableVTable incremental = vtable;
+  incremental.migrate_groups = 1;
+
+  Table(int) table;
+  table_init(&table, &incremental, 8, allocator_global, NULL);
+
+  for (int i = 0; i < 5000; ++i) {
+    table_insert(&table, &incremental, &i, allocator_global, NULL);
+    if (i % 3 == 0) {
+      TEST_INT(table_remove(&table, &incremental, &i), 1);
+    }
+  }
+  for (int i = 0; i < 5000; ++i) {
+    TEST_INT(table_contains(&table, &incremental, &i), i % 3 != 0);
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__store_hash(void) {
+  TableVTable stored = vtable;
+  stored.store_hash = true;
+  stored.migrate_groups = 2;
+
+  Table(int) table;
+  table_init(&table, &stored, 8, allocator_global, NULL);
+
+  for (int i = 0; i < 20000; ++i) {
+    table_insert(&table, &stored, &i, allocator_global, NULL);
+    if (i % 4 == 0) {
+      TEST_INT(table_remove(&table, &stored, &i), 1);
+    }
+  }
+  TEST_INT(table.length, 15000);
+
+  for (int i = 0; i < 20000; ++i) {
+    usize index = table_find(&table, &stored, &i);
+    TEST_INT(table_isset(&table, &stored, index), i % 4 != 0);
+    if (i % 4) {
+      TEST_INT(*(int *)table_get(&table, &stored, index), i);
+    }
+  }
+
+  table_shrink(&table, &stored, allocator_global, NULL);
+  for (int i = 0; i < 20000; ++i) {
+    TEST_INT(table_contains(&table, &stored, &i), i % 4 != 0);
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__value(void) {
+  TableVTable split = vtable;
+  split.store_hash = true;
+  split.migrate_groups = 1;
+  split.value_size = 3 * sizeof(int);
+
+  Table(int) table;
+  table_init(&table, &split, 8, allocator_global, NULL);
+
+  // values have to follow their keys through incremental resizes and purges
+  for (int i = 0; i < 20000; ++i) {
+    const usize index =
+        table_upsert(&table, &split, &i, allocator_global, NULL);
+    int *value = table_value(&table, &split, index);
+    value[0] = i;
+    value[1] = -i;
+    value[2] = 2 * i;
+    if (i % 4 == 0) {
+      TEST_INT(table_remove(&table, &split, &i), 1);
+    }
+  }
+  for (int i = 1; i < 20000; i += 2) {
+    TEST_INT(table_remove(&table, &split, &i), 1);
+  }
+  for (int i = 0; i < 20000; ++i) {
+    const usize index = table_find(&table, &split, &i);
+    const bool present = i % 4 == 2;
+    TEST_INT(table_isset(&table, &split, index), present);
+    if (present) {
+      const int *value = table_value(&table, &split, index);
+      TEST_INT(value[0], i);
+      TEST_INT(value[1], -i);
+      TEST_INT(value[2], 2 * i);
+    }
+  }
+
+  table_shrink(&table, &split, allocator_global, NULL);
+  for (int i = 2; i < 20000; i += 4) {
+    const usize index = table_find(&table, &split, &i);
+    TEST_INT(((int *)table_value(&table, &split, index))[2], 2 * i);
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__hashed(void) {
+  TableVTable incremental = vtable;
+  incremental.migrate_groups = 1;
+
+  Table(int) table;
+  table_init(&table, &incremental, 8, allocator_global, NULL);
+  for (int i = 0; i < 3000; ++i) {
+    const u64 hash = int_hash(&i, NULL);
+    if (i % 2) {
+      table_insert_hashed(&table, &incremental, &i, hash, allocator_global,
+                          NULL);
+    } else {
+      table_upsert_hashed(&table, &incremental, &i, hash, allocator_global,
+                          NULL);
+    }
+  }
+  for (int i = 0; i < 3000; i += 3) {
+    TEST_INT(table_remove_hashed(&table, &incremental, &i, int_hash(&i, NULL)),
+             1);
+  }
+  for (int i = 0; i < 6000; ++i) {
+    const usize index =
+        table_find_hashed(&table, &incremental, &i, int_hash(&i, NULL));
+    TEST_INT(index, table_find(&table, &incremental, &i));
+    TEST_INT(table_isset(&table, &incremental, index), i < 3000 && i % 3);
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+typedef struct Slice Slice;
+struct Slice {
+  const char *data;
+  usize length;
+};
+
+static bool string_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return strcmp(*(char *const *)a, *(char *const *)b) == 0;
+}
+
+static void string_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(const char **)dest = *(const char *const *)src;
+}
+
+static u64 string_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  const char *string = *(const char *const *)d;
+  return hash_bytes(string, strlen(string), 0);
+}
+
+static bool slice_compare_string(const void *key, const void *element,
+                                 void *ctx) {
+  UNUSED(ctx);
+  const Slice *slice = key;
+  const char *string = *(const char *const *)element;
+  return strncmp(slice->data, string, slice->length) == 0 &&
+         string[slice->length] == 0;
+}
+
+static void test__find_key(void) {
+  static const char *words[] = {"alpha", "beta", "gamma", "delta", "epsilon"};
+  const TableVTable strings = {
+      .element_size = sizeof(const char *),
+      .compare = string_compare,
+      .insert = string_insert,
+      .overwrite = string_insert,
+      .hash = string_hash,
+  };
+
+  Table(const char *) table;
+  table_init(&table, &strings, 8, allocator_global, NULL);
+  for (usize i = 0; i < sizeof(words) / sizeof(*words); ++i) {
+    table_insert(&table, &strings, &words[i], allocator_global, NULL);
+  }
+
+  // slices into a larger buffer, none of them is terminated
+  const char *text = "gammabetadeltaalphas";
+  const Slice slices[] = {{text, 5}, {text + 5, 4}, {text + 9, 5},
+                          {text + 14, 5}, {text + 14, 6}, {text, 4}};
+  const bool present[] = {true, true, true, true, false, false};
+  for (usize i = 0; i < sizeof(slices) / sizeof(*slices); ++i) {
+    const u64 hash = hash_bytes(slices[i].data, slices[i].length, 0);
+    const usize index = table_find_key(&table, &strings, &slices[i], hash,
+                                       slice_compare_string);
+    TEST_INT(table_isset(&table, &strings, index), present[i]);
+    if (present[i]) {
+      const char *found = *(const char **)table_get(&table, &strings, index);
+      TEST_INT(strncmp(found, slices[i].data, slices[i].length), 0);
+    }
+  }
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__iter(void) {
+  enum { MAX = 1 << 14 };
+  static int seen[MAX];
+  TableVTable incremental = vtable;
+  incremental.migrate_groups = 1;
+
+  Table(int) table;
+  table_init(&table, &incremental, 8, allocator_global, NULL);
+  // stops in the middle of a resize, the iteration has to cover the old
+  // array as well
+  int n = 0;
+  for (; n < MAX && (n < 2000 || !table.old_end); ++n) {
+    table_insert(&table, &incremental, &n, allocator_global, NULL);
+    if (n % 3 == 0) {
+      table_remove(&table, &incremental, &n);
+    }
+  }
+  TEST_INT(table.old_end > 0, 1);
+
+  int count = 0;
+  table_foreach(&table, &incremental, iter) {
+    const int *element = table_get(&table, &incremental, iter.index);
+    seen[*element] += 1;
+    count += 1;
+  }
+  TEST_INT(count, (int)table.length);
+  for (int i = 0; i < n; ++i) {
+    TEST_INT(seen[i], i % 3 != 0);
+  }
+
+  // removing the current element is allowed
+  TableIter iter = {0};
+  while (table_next(&table, &incremental, &iter)) {
+    const int element = *(int *)table_get(&table, &incremental, iter.index);
+    TEST_INT(table_remove(&table, &incremental, &element), 1);
+  }
+  TEST_INT(table.length, 0);
+
+  iter = (TableIter){0};
+  TEST_INT(table_next(&table, &incremental, &iter), 0);
+
+  table_deinit(&table, allocator_global);
+}
+
 int main(void) {
   test__insert_find();
+  test__find_many();
+  test__incremental();
+  test__remove();
+  test__remove_incremental();
+  test__store_hash();
+  test__value();
+  test__hashed();
+  test__find_key();
+  test__iter();
   TEST_OVERVIEW();
   return 0;
 }
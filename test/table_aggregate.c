@@ -0,0 +1,148 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_aggregate.h>
+
+static bool u64_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a == *(const u64 *)b;
+}
+
+static void u64_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(u64 *)dest = *(const u64 *)src;
+}
+
+static u64 u64_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return hash_u64(*(const u64 *)element);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(u64),
+    .compare = u64_compare,
+    .insert = u64_insert,
+    .overwrite = u64_insert,
+    .hash = u64_hash,
+    .value_size = 4 * sizeof(i64),
+};
+
+static const TableAggregate aggregates[] = {
+    {TABLE_AGGREGATE_COUNT, 0},
+    {TABLE_AGGREGATE_SUM, 1},
+    {TABLE_AGGREGATE_MIN, 0},
+    {TABLE_AGGREGATE_MAX, 0},
+};
+
+typedef Table(u64) U64Table;
+
+#define ROWS 100000
+#define GROUPS 1000
+
+static u64 keys[ROWS];
+static i64 column_a[ROWS];
+static i64 column_b[ROWS];
+
+// row `i` belongs to group `i % GROUPS`, column a is `i - ROWS / 2` and
+// column b is `2`
+static void fill(void) {
+  for (usize i = 0; i < ROWS; ++i) {
+    keys[i] = i % GROUPS;
+    column_a[i] = (i64)i - ROWS / 2;
+    column_b[i] = 2;
+  }
+}
+
+static void check(const U64Table *table, const TableVTable *vtable,
+                  i64 times) {
+  TEST_INT(table->length, GROUPS);
+  for (u64 key = 0; key < GROUPS; ++key) {
+    const usize index = table_find(table, vtable, &key);
+    TEST_INT(table_isset(table, vtable, index), 1);
+    const i64 *value = table_value(table, vtable, index);
+    TEST_INT(value[0], times * ROWS / GROUPS);
+    TEST_INT(value[1], times * 2 * ROWS / GROUPS);
+    TEST_INT(value[2], (i64)key - ROWS / 2);
+    TEST_INT(value[3], (i64)(ROWS - GROUPS + key) - ROWS / 2);
+  }
+}
+
+static void test__aggregate(const TableVTable *vtable, usize cardinality) {
+  const i64 *columns[] = {column_a, column_b};
+  U64Table table;
+  Error error = 0;
+  table_init(&table, vtable, 0, allocator_global, NULL);
+  table_aggregate(&table, vtable, aggregates, 4, keys, columns, ROWS,
+                  cardinality, allocator_global, &error);
+  TEST_INT(error, 0);
+  check(&table, vtable, 1);
+
+  // a stream aggregated in uneven chunks ends up the same
+  for (usize row = 0; row < ROWS;) {
+    const usize chunk = ROWS - row < 777 ? ROWS - row : 777;
+    const i64 *chunk_columns[] = {column_a + row, column_b + row};
+    table_aggregate(&table, vtable, aggregates, 4, keys + row, chunk_columns,
+                    chunk, cardinality, allocator_global, &error);
+    row += chunk;
+  }
+  TEST_INT(error, 0);
+  check(&table, vtable, 2);
+  table_deinit(&table, allocator_global);
+}
+
+static void test__count_only(void) {
+  TableVTable count = vtable;
+  count.value_size = sizeof(i64);
+  const TableAggregate aggregate = {TABLE_AGGREGATE_COUNT, 0};
+
+  U64Table table;
+  table_init(&table, &count, 0, allocator_global, NULL);
+  table_aggregate(&table, &count, &aggregate, 1, keys, NULL, ROWS, 0,
+                  allocator_global, NULL);
+  TEST_INT(table.length, GROUPS);
+
+  // removed groups leave tombs which are purged to make room for new ones
+  for (u64 key = 0; key < GROUPS; key += 2) {
+    TEST_INT(table_remove(&table, &count, &key), 1);
+  }
+  table_aggregate(&table, &count, &aggregate, 1, keys, NULL, ROWS, 0,
+                  allocator_global, NULL);
+  TEST_INT(table.length, GROUPS);
+  for (u64 key = 0; key < GROUPS; ++key) {
+    const usize index = table_find(&table, &count, &key);
+    TEST_INT(*(const i64 *)table_value(&table, &count, index),
+             (key % 2 ? 2 : 1) * ROWS / GROUPS);
+  }
+  table_deinit(&table, allocator_global);
+}
+
+static void test__estimate(void) {
+  TEST_INT(table_aggregate_estimate(&vtable, keys, 0), 0);
+  TEST_INT(table_aggregate_estimate(&vtable, keys, 10), 10);
+  TEST_INT(table_aggregate_estimate(&vtable, keys, 63), 63);
+
+  const usize estimate = table_aggregate_estimate(&vtable, keys, ROWS);
+  TEST_INT(estimate > GROUPS * 7 / 10 && estimate < GROUPS * 13 / 10, 1);
+
+  static u64 distinct[ROWS];
+  for (usize i = 0; i < ROWS; ++i) {
+    distinct[i] = i;
+  }
+  const usize all = table_aggregate_estimate(&vtable, distinct, ROWS);
+  TEST_INT(all > ROWS * 7 / 10 && all <= ROWS, 1);
+}
+
+int main(void) {
+  fill();
+  test__aggregate(&vtable, 0);
+  test__aggregate(&vtable, 1);
+  test__aggregate(&vtable, GROUPS);
+
+  TableVTable variant = vtable;
+  variant.store_hash = true;
+  test__aggregate(&variant, 0);
+
+  test__count_only();
+  test__estimate();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,261 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_atomic.h>
+
+typedef struct Pair Pair;
+struct Pair {
+  int key;
+  int value;
+};
+
+static bool pair_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Pair *)a)->key == ((const Pair *)b)->key;
+}
+
+static void pair_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(Pair *)dest = *(const Pair *)src;
+}
+
+static u64 pair_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32((u32)((const Pair *)d)->key);
+}
+
+// counts destroyed elements in the `usize` pointed to by `ctx`
+static void pair_destroy(void *element, void *ctx) {
+  UNUSED(element);
+  (void)__atomic_fetch_add((usize *)ctx, 1, __ATOMIC_RELAXED);
+}
+
+static usize destroyed = 0;
+
+static const TableVTable vtable = {
+    .element_size = sizeof(Pair),
+    .compare = pair_compare,
+    .insert = pair_insert,
+    .overwrite = pair_insert,
+    .hash = pair_hash,
+    .destroy = pair_destroy,
+    .ctx = &destroyed,
+};
+
+// sums the keys of destroyed elements in the `usize` pointed to by `ctx`,
+// which reads the slot the element was retired from
+static void pair_destroy_read(void *element, void *ctx) {
+  *(usize *)ctx += (usize)((const Pair *)element)->key;
+}
+
+static usize destroyed_keys = 0;
+
+static const TableVTable reading_vtable = {
+    .element_size = sizeof(Pair),
+    .compare = pair_compare,
+    .insert = pair_insert,
+    .overwrite = pair_insert,
+    .hash = pair_hash,
+    .destroy = pair_destroy_read,
+    .ctx = &destroyed_keys,
+};
+
+static void test__single_thread(void) {
+  Epoch epoch;
+  TableAtomic table;
+  Error error = 0;
+  epoch_init(&epoch, 4, allocator_global, &error);
+  TEST_INT(error, 0);
+  table_atomic_init(&table, &vtable, &epoch, 0, allocator_global, &error);
+  TEST_INT(error, 0);
+  const usize reader = epoch_register(&epoch, &error);
+  TEST_INT(error, 0);
+
+  destroyed = 0;
+  for (int i = 0; i < 5000; ++i) {
+    table_atomic_upsert(&table, &vtable, &(Pair){i, i}, &error);
+  }
+  table_atomic_upsert(&table, &vtable, &(Pair){7, -1}, &error);
+  TEST_INT(error, 0);
+  TEST_INT(table_atomic_length(&table), 5000);
+
+  Pair out = {0};
+  TEST_INT(table_atomic_get(&table, &vtable, reader, &(Pair){7, 0}, &out), 1);
+  TEST_INT(out.value, 7);
+
+  // overwriting keeps the length and retires the old copy
+  for (int i = 0; i < 5000; ++i) {
+    table_atomic_insert(&table, &vtable, &(Pair){i, 2 * i}, &error);
+  }
+  TEST_INT(table_atomic_length(&table), 5000);
+  for (int i = 0; i < 10000; ++i) {
+    out.value = -1;
+    TEST_INT(table_atomic_get(&table, &vtable, reader, &(Pair){i, 0}, &out),
+             i < 5000);
+    TEST_INT(out.value, i < 5000 ? 2 * i : -1);
+  }
+
+  for (int i = 0; i < 5000; i += 2) {
+    TEST_INT(table_atomic_remove(&table, &vtable, &(Pair){i, 0}, &error), 1);
+  }
+  TEST_INT(table_atomic_remove(&table, &vtable, &(Pair){0, 0}, &error), 0);
+  TEST_INT(table_atomic_length(&table), 2500);
+  for (int i = 0; i < 5000; ++i) {
+    TEST_INT(table_atomic_contains(&table, &vtable, reader, &(Pair){i, 0}),
+             i % 2);
+  }
+
+  // nobody is inside, so a few collections free everything
+  epoch_collect(&epoch);
+  epoch_collect(&epoch);
+  TEST_INT(epoch_collect(&epoch), 0);
+  TEST_INT(destroyed, 5000 + 2500);
+
+  epoch_unregister(&epoch, reader);
+  table_atomic_deinit(&table);
+  epoch_deinit(&epoch);
+}
+
+// removed and overwritten elements are still retired when the table and the
+// epoch are torn down, their slots have to outlive them
+static void test__teardown(void) {
+  Epoch epoch;
+  TableAtomic table;
+  Error error = 0;
+  epoch_init(&epoch, 1, allocator_global, &error);
+  table_atomic_init(&table, &reading_vtable, &epoch, 64, allocator_global,
+                    &error);
+  TEST_INT(error, 0);
+
+  destroyed_keys = 0;
+  for (int i = 1; i <= 10; ++i) {
+    table_atomic_insert(&table, &reading_vtable, &(Pair){i, i}, &error);
+  }
+  table_atomic_insert(&table, &reading_vtable, &(Pair){3, 0}, &error);
+  TEST_INT(table_atomic_remove(&table, &reading_vtable, &(Pair){7, 0}, &error),
+           1);
+  TEST_INT(error, 0);
+
+  table_atomic_deinit(&table);
+  epoch_deinit(&epoch);
+  TEST_INT(destroyed_keys, 3 + 7);
+}
+
+static void test__epoch(void) {
+  Epoch epoch;
+  Error error = 0;
+  epoch_init(&epoch, 2, allocator_global, &error);
+  const usize first = epoch_register(&epoch, &error);
+  const usize second = epoch_register(&epoch, &error);
+  TEST_INT(error, 0);
+  epoch_register(&epoch, &error);
+  TEST_INT(error, EAGAIN);
+
+  usize freed = 0;
+  epoch_enter(&epoch, first);
+  epoch_retire(&epoch, pair_destroy, NULL, &freed, NULL);
+  // the reader inside may still see the retired memory
+  for (int i = 0; i < 4; ++i) {
+    TEST_INT(epoch_collect(&epoch), 1);
+  }
+  TEST_INT(freed, 0);
+  epoch_exit(&epoch, first);
+  epoch_collect(&epoch);
+  epoch_collect(&epoch);
+  TEST_INT(epoch_collect(&epoch), 0);
+  TEST_INT(freed, 1);
+
+  // memory which is still retired is freed by deinit
+  epoch_enter(&epoch, second);
+  epoch_retire(&epoch, pair_destroy, NULL, &freed, NULL);
+  epoch_exit(&epoch, second);
+  epoch_deinit(&epoch);
+  TEST_INT(freed, 2);
+}
+
+enum { READERS = 3, STABLE = 2000, ROUNDS = 20 };
+
+typedef struct Shared Shared;
+struct Shared {
+  Epoch *epoch;
+  TableAtomic *table;
+  int stop;
+};
+
+typedef struct Worker Worker;
+struct Worker {
+  Shared *shared;
+  usize bad;
+};
+
+// the stable keys are always present and their value is always the key
+// negated. The test counters are not thread safe, failures are counted in
+// `bad`
+static void reader_run(void *worker_) {
+  Worker *worker = worker_;
+  Shared *shared = worker->shared;
+  const usize reader = epoch_register(shared->epoch, NULL);
+  while (!__atomic_load_n(&shared->stop, __ATOMIC_ACQUIRE)) {
+    for (int i = 0; i < STABLE; ++i) {
+      Pair out = {0};
+      worker->bad += !table_atomic_get(shared->table, &vtable, reader,
+                                       &(Pair){i, 0}, &out) ||
+                     out.value != -i;
+    }
+  }
+  epoch_unregister(shared->epoch, reader);
+}
+
+static void test__threads(void) {
+  Epoch epoch;
+  TableAtomic table;
+  epoch_init(&epoch, READERS, allocator_global, NULL);
+  table_atomic_init(&table, &vtable, &epoch, 0, allocator_global, NULL);
+  for (int i = 0; i < STABLE; ++i) {
+    table_atomic_insert(&table, &vtable, &(Pair){i, -i}, NULL);
+  }
+
+  Shared shared = {.epoch = &epoch, .table = &table};
+  Worker workers[READERS];
+  Thread threads[READERS];
+  for (int t = 0; t < READERS; ++t) {
+    workers[t] = (Worker){.shared = &shared};
+    thread_spawn(&threads[t], reader_run, &workers[t], NULL);
+  }
+
+  // overwrites the stable keys and churns through other keys, which grows
+  // the table and rebuilds it to get rid of the tombs
+  for (int round = 0; round < ROUNDS; ++round) {
+    for (int i = 0; i < STABLE; ++i) {
+      table_atomic_insert(&table, &vtable, &(Pair){i, -i}, NULL);
+      table_atomic_insert(&table, &vtable, &(Pair){STABLE + i, round}, NULL);
+    }
+    for (int i = 0; i < STABLE; ++i) {
+      table_atomic_remove(&table, &vtable, &(Pair){STABLE + i, 0}, NULL);
+    }
+  }
+  __atomic_store_n(&shared.stop, 1, __ATOMIC_RELEASE);
+
+  for (int t = 0; t < READERS; ++t) {
+    thread_join(&threads[t]);
+    TEST_INT(workers[t].bad, 0);
+  }
+  TEST_INT(table_atomic_length(&table), STABLE);
+  const usize reader = epoch_register(&epoch, NULL);
+  for (int i = 0; i < 2 * STABLE; ++i) {
+    TEST_INT(table_atomic_contains(&table, &vtable, reader, &(Pair){i, 0}),
+             i < STABLE);
+  }
+  epoch_unregister(&epoch, reader);
+
+  table_atomic_deinit(&table);
+  epoch_deinit(&epoch);
+}
+
+int main(void) {
+  test__single_thread();
+  test__teardown();
+  test__epoch();
+  test__threads();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_build.h>
+
+typedef struct Entry Entry;
+struct Entry {
+  int key;
+  int value;
+};
+
+static bool entry_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Entry *)a)->key == ((const Entry *)b)->key;
+}
+
+static void entry_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(Entry *)dest = *(const Entry *)src;
+}
+
+static u64 entry_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32((u32)((const Entry *)d)->key);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(Entry),
+    .compare = entry_compare,
+    .insert = entry_insert,
+    .hash = entry_hash,
+    .overwrite = entry_insert,
+};
+
+// builds the same table with table_build_from_array and with table_insert
+static void test__equivalent(const TableVTable *vtable, int count,
+                             int num_keys, usize num_threads) {
+  Entry *entries = malloc(sizeof(*entries) * (count ? count : 1));
+  for (int i = 0; i < count; ++i) {
+    entries[i].key = (int)(hash_u32((u32)i) % (u32)num_keys);
+    entries[i].value = i;
+  }
+
+  Error error = 0;
+  Table(Entry) built;
+  table_build_from_array(&built, vtable, entries, count, num_threads,
+                         allocator_global, &error);
+  TEST_INT(error, 0);
+
+  Table(Entry) inserted;
+  table_init(&inserted, vtable, 8, allocator_global, NULL);
+  for (int i = 0; i < count; ++i) {
+    table_insert(&inserted, vtable, &entries[i], allocator_global, NULL);
+  }
+
+  TEST_INT(built.length, inserted.length);
+  TEST_INT(built.tombs, 0);
+  usize visited = 0;
+  table_foreach(&inserted, vtable, iter) {
+    const Entry *expected = table_get(&inserted, vtable, iter.index);
+    const usize index = table_find(&built, vtable, expected);
+    TEST_INT(table_isset(&built, vtable, index), 1);
+    // the last of several equal elements wins, as with table_insert
+    TEST_INT(built.element[index].value, expected->value);
+    visited += 1;
+  }
+  TEST_INT(visited, built.length);
+
+  // the built table keeps working as a normal table
+  for (int i = 0; i < count; ++i) {
+    table_remove(&built, vtable, &entries[i]);
+  }
+  TEST_INT(built.length, 0);
+  for (int i = 0; i < 1000; ++i) {
+    Entry entry = {i, i};
+    table_insert(&built, vtable, &entry, allocator_global, NULL);
+  }
+  TEST_INT(built.length, 1000);
+
+  table_deinit(&built, allocator_global);
+  table_deinit(&inserted, allocator_global);
+  free(entries);
+}
+
+int main(void) {
+  test__equivalent(&vtable, 0, 1, 1);
+  test__equivalent(&vtable, 1, 1, 4);
+  test__equivalent(&vtable, 15, 100, 1);
+  test__equivalent(&vtable, 100000, 1000000, 1);
+  test__equivalent(&vtable, 100000, 1000000, 4);
+  // many equal elements
+  test__equivalent(&vtable, 100000, 30000, 3);
+
+  TableVTable stored = vtable;
+  stored.store_hash = true;
+  test__equivalent(&stored, 100000, 70000, 4);
+
+  TEST_OVERVIEW();
+  return 0;
+}
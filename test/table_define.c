@@ -0,0 +1,83 @@
+#include "test.h"
+#include <uc/table_define.h>
+
+static u64 int_hash(const int *x) {
+  u64 hash = (u64)*x * 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 29);
+}
+
+static bool int_equal(const int *a, const int *b) { return *a == *b; }
+
+TABLE_DEFINE(IntSet, int, int_hash, int_equal)
+
+static void test__insert_find(void) {
+  IntSet set;
+  IntSet_init(&set, 8, allocator_global, NULL);
+
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(set.length, i);
+    IntSet_insert(&set, &i, allocator_global, NULL);
+    TEST_INT(set.length, i + 1);
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    usize index = IntSet_find(&set, &i);
+    TEST_INT(IntSet_isset(&set, index), 1);
+    TEST_INT(set.element[index], i);
+
+    int not_contains_entry = i + 1000;
+    TEST_INT(IntSet_contains(&set, &not_contains_entry), 0);
+
+    // the generic functions work on the same layout
+    TEST_INT(table_contains(&set, &IntSet_vtable, &i), 1);
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    usize index = IntSet_upsert(&set, &i, allocator_global, NULL);
+    TEST_INT(set.element[index], i);
+  }
+  TEST_INT(set.length, 1000);
+
+  IntSet_deinit(&set, allocator_global);
+}
+
+static void test__remove(void) {
+  IntSet set;
+  IntSet_init(&set, 8, allocator_global, NULL);
+
+  for (int i = 0; i < 1000; ++i) {
+    IntSet_insert(&set, &i, allocator_global, NULL);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    TEST_INT(IntSet_remove(&set, &i), 1);
+    TEST_INT(IntSet_remove(&set, &i), 0);
+  }
+  TEST_INT(set.length, 500);
+
+  // constant churn has to be handled by purging tombs in place
+  const usize end = set.end;
+  for (int i = 1000; i < 100000; ++i) {
+    IntSet_insert(&set, &i, allocator_global, NULL);
+    int old = i - 500;
+    IntSet_remove(&set, &old);
+  }
+  TEST_INT(set.end, end);
+
+  for (int i = 99000; i < 100000; ++i) {
+    TEST_INT(IntSet_contains(&set, &i), i >= 99500);
+  }
+
+  IntSet_shrink(&set, allocator_global, NULL);
+  for (int i = 99000; i < 100000; ++i) {
+    TEST_INT(IntSet_contains(&set, &i), i >= 99500);
+  }
+
+  IntSet_deinit(&set, allocator_global);
+}
+
+int main(void) {
+  test__insert_find();
+  test__remove();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,165 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_file.h>
+
+#include <stdio.h>
+
+#define PATH "/tmp/uc_test_table_file.bin"
+
+typedef struct Pair Pair;
+struct Pair {
+  int key;
+  int value;
+};
+
+static bool pair_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Pair *)a)->key == ((const Pair *)b)->key;
+}
+
+static void pair_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(Pair *)dest = *(const Pair *)src;
+}
+
+static u64 pair_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32((u32)((const Pair *)d)->key);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(Pair),
+    .compare = pair_compare,
+    .insert = pair_insert,
+    .overwrite = pair_insert,
+    .hash = pair_hash,
+};
+
+static void test__reopen(const TableVTable *vtable) {
+  (void)remove(PATH);
+  Error error = 0;
+  TableFile file;
+  table_file_open(&file, vtable, PATH, 8, 0, &error);
+  TEST_INT(error, 0);
+  TEST_INT((uintptr_t)file.table.element % TABLE_FILE_INTERNAL_ALIGN, 0);
+
+  // grows many times, every growth migrates incrementally inside the file
+  for (int i = 0; i < 20000; ++i) {
+    table_file_insert(&file, vtable, &(Pair){i, 2 * i}, &error);
+    if (i % 3 == 0) {
+      table_file_remove(&file, vtable, &(Pair){i, 0}, &error);
+    }
+  }
+  TEST_INT(error, 0);
+  table_file_insert(&file, vtable, &(Pair){1, -1}, &error);
+  table_file_upsert(&file, vtable, &(Pair){2, -2}, &error);
+  const usize length = file.table.length;
+  table_file_close(&file, &error);
+  TEST_INT(error, 0);
+
+  // reopening neither writes to nor grows the file
+  struct stat before;
+  struct stat after;
+  TEST_INT(stat(PATH, &before), 0);
+  table_file_open(&file, vtable, PATH, 8, 0, &error);
+  TEST_INT(error, 0);
+  TEST_INT(stat(PATH, &after), 0);
+  TEST_INT(after.st_size == before.st_size, 1);
+  TEST_INT(file.table.length, length);
+  TEST_INT((uintptr_t)file.table.element % TABLE_FILE_INTERNAL_ALIGN, 0);
+  for (int i = 0; i < 20000; ++i) {
+    const usize index = table_find(&file.table, vtable, &(Pair){i, 0});
+    TEST_INT(table_isset(&file.table, vtable, index), i % 3 != 0);
+    if (i % 3 != 0) {
+      TEST_INT(((const Pair *)table_get(&file.table, vtable, index))->value,
+               i == 1 ? -1 : 2 * i);
+    }
+  }
+
+  // a reopened table keeps growing where it stopped
+  for (int i = 20000; i < 30000; ++i) {
+    table_file_insert(&file, vtable, &(Pair){i, 2 * i}, &error);
+  }
+  TEST_INT(error, 0);
+  for (int i = 0; i < 30000; ++i) {
+    TEST_INT(table_contains(&file.table, vtable, &(Pair){i, 0}),
+             i >= 20000 || i % 3 != 0);
+  }
+  table_file_close(&file, &error);
+  TEST_INT(error, 0);
+  (void)remove(PATH);
+}
+
+static void test__dirty(void) {
+  (void)remove(PATH);
+  Error error = 0;
+  TableFile file;
+  table_file_open(&file, &vtable, PATH, 0, 0, &error);
+  TEST_INT(error, 0);
+  table_file_insert(&file, &vtable, &(Pair){1, 1}, &error);
+  table_file_sync(&file, &error);
+  TEST_INT(error, 0);
+  TEST_INT(table_file_internal_header(&file)->clean, 1);
+
+  // a change after the sync marks the file as dirty until the next one, so a
+  // crash in between is detected on open
+  table_file_insert(&file, &vtable, &(Pair){2, 2}, &error);
+  TEST_INT(table_file_internal_header(&file)->clean, 0);
+  TableFile other;
+  table_file_open(&other, &vtable, PATH, 0, 0, &error);
+  TEST_INT(error, EINVAL);
+  error = 0;
+  table_file_sync(&file, &error);
+  TEST_INT(error, 0);
+  TEST_INT(table_file_internal_header(&file)->clean, 1);
+  table_file_close(&file, &error);
+  TEST_INT(error, 0);
+
+  // the layout has to match
+  TableVTable hashed = vtable;
+  hashed.store_hash = true;
+  table_file_open(&other, &hashed, PATH, 0, 0, &error);
+  TEST_INT(error, EINVAL);
+  error = 0;
+  table_file_open(&other, &vtable, PATH, 0, 0, &error);
+  TEST_INT(error, 0);
+  TEST_INT(other.table.length, 2);
+  table_file_close(&other, &error);
+  (void)remove(PATH);
+}
+
+static void test__max_size(void) {
+  (void)remove(PATH);
+  Error error = 0;
+  TableFile file;
+  table_file_open(&file, &vtable, PATH, 0, 1 << 16, &error);
+  TEST_INT(error, 0);
+  int i = 0;
+  while (!error) {
+    table_file_insert(&file, &vtable, &(Pair){i, i}, &error);
+    i += 1;
+  }
+  TEST_INT(error, ENOMEM);
+  TEST_INT(table_file_internal_header(&file)->size <= 1 << 16, 1);
+  // everything inserted before the failing insert is still there
+  for (int j = 0; j + 1 < i; ++j) {
+    TEST_INT(table_contains(&file.table, &vtable, &(Pair){j, 0}), 1);
+  }
+  error = 0;
+  table_file_close(&file, &error);
+  TEST_INT(error, 0);
+  (void)remove(PATH);
+}
+
+int main(void) {
+  test__reopen(&vtable);
+  TableVTable variant = vtable;
+  variant.store_hash = true;
+  test__reopen(&variant);
+  variant.value_size = 8;
+  test__reopen(&variant);
+  test__dirty();
+  test__max_size();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_set.h>
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32(*(const u32 *)d);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(int),
+    .compare = int_compare,
+    .insert = int_insert,
+    .overwrite = int_insert,
+    .hash = int_hash,
+};
+
+typedef Table(int) IntTable;
+typedef Vec(int) IntVec;
+
+// fills `table` with the multiples of `step` below `limit`
+static void fill(IntTable *table, const TableVTable *vtable, int step,
+                 int limit) {
+  table_init(table, vtable, 8, allocator_global, NULL);
+  for (int i = 0; i < limit; i += step) {
+    table_insert(table, vtable, &i, allocator_global, NULL);
+  }
+}
+
+// checks that `vec` holds every `i < limit` for which `expected(i)` exactly
+// once
+static void check(const IntVec *vec, int limit, bool (*expected)(int)) {
+  Table(int) seen;
+  table_init(&seen, &vtable, 8, allocator_global, NULL);
+  for (usize i = 0; i < vec->length; ++i) {
+    TEST_INT(expected(vec->element[i]), 1);
+    TEST_INT(table_contains(&seen, &vtable, &vec->element[i]), 0);
+    table_insert(&seen, &vtable, &vec->element[i], allocator_global, NULL);
+  }
+  usize count = 0;
+  for (int i = 0; i < limit; ++i) {
+    count += expected(i);
+  }
+  TEST_INT(vec->length, count);
+  table_deinit(&seen, allocator_global);
+}
+
+static bool multiple_of_6(int i) { return i % 6 == 0; }
+static bool even_not_multiple_of_3(int i) { return i % 2 == 0 && i % 3 != 0; }
+static bool multiple_of_3_odd(int i) { return i % 3 == 0 && i % 2 != 0; }
+
+static void test__set(const TableVTable *vtable) {
+  IntTable a;
+  IntTable b;
+  fill(&a, vtable, 2, 30000);
+  fill(&b, vtable, 3, 30000);
+
+  IntVec out;
+  Error error = 0;
+  vec_init(&out, sizeof(int), 1, allocator_global, NULL);
+  table_intersect(&a, &b, vtable, &out, allocator_global, &error);
+  TEST_INT(error, 0);
+  check(&out, 30000, multiple_of_6);
+
+  out.length = 0;
+  table_intersect(&b, &a, vtable, &out, allocator_global, &error);
+  check(&out, 30000, multiple_of_6);
+
+  out.length = 0;
+  table_difference(&a, &b, vtable, &out, allocator_global, &error);
+  check(&out, 30000, even_not_multiple_of_3);
+
+  out.length = 0;
+  table_difference(&b, &a, vtable, &out, allocator_global, &error);
+  check(&out, 30000, multiple_of_3_odd);
+
+  // appends to what is already there
+  const usize length = out.length;
+  table_difference(&b, &a, vtable, &out, allocator_global, &error);
+  TEST_INT(out.length, 2 * length);
+
+  table_union_into(&a, &b, vtable, allocator_global, &error);
+  TEST_INT(error, 0);
+  TEST_INT(a.length, 15000 + 10000 - 5000);
+  for (int i = 0; i < 30000; ++i) {
+    TEST_INT(table_contains(&a, vtable, &i), i % 2 == 0 || i % 3 == 0);
+  }
+
+  vec_deinit(&out, sizeof(int), allocator_global);
+  table_deinit(&a, allocator_global);
+  table_deinit(&b, allocator_global);
+}
+
+static void test__empty(void) {
+  IntTable a;
+  IntTable b;
+  fill(&a, &vtable, 1, 100);
+  table_init(&b, &vtable, 0, allocator_global, NULL);
+
+  IntVec out;
+  vec_init(&out, sizeof(int), 1, allocator_global, NULL);
+  table_intersect(&a, &b, &vtable, &out, allocator_global, NULL);
+  TEST_INT(out.length, 0);
+  table_difference(&b, &a, &vtable, &out, allocator_global, NULL);
+  TEST_INT(out.length, 0);
+  table_difference(&a, &b, &vtable, &out, allocator_global, NULL);
+  TEST_INT(out.length, 100);
+
+  table_union_into(&b, &a, &vtable, allocator_global, NULL);
+  TEST_INT(b.length, 100);
+  for (int i = 0; i < 100; ++i) {
+    TEST_INT(table_contains(&b, &vtable, &i), 1);
+  }
+
+  vec_deinit(&out, sizeof(int), allocator_global);
+  table_deinit(&a, allocator_global);
+  table_deinit(&b, allocator_global);
+}
+
+int main(void) {
+  test__set(&vtable);
+
+  TableVTable variant = vtable;
+  variant.store_hash = true;
+  test__set(&variant);
+
+  // elements still waiting in the old array are visited and found as well
+  variant.migrate_groups = 1;
+  test__set(&variant);
+  variant.store_hash = false;
+  test__set(&variant);
+
+  test__empty();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_sharded.h>
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32(*(const u32 *)d);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(int),
+    .compare = int_compare,
+    .insert = int_insert,
+    .hash = int_hash,
+    .overwrite = int_insert,
+};
+
+enum { THREADS = 4, PER_THREAD = 20000 };
+
+typedef struct Worker Worker;
+struct Worker {
+  TableSharded *table;
+  int thread;
+  usize inserted;
+  usize missing;
+};
+
+// inserts its own range and then upserts the keys shared by all threads.
+// The test counters are not thread safe, failures are counted in `missing`
+static void worker_run(void *worker_) {
+  Worker *worker = worker_;
+  const int begin = worker->thread * PER_THREAD;
+  for (int i = begin; i < begin + PER_THREAD; ++i) {
+    table_sharded_insert(worker->table, &vtable, &i, allocator_global, NULL);
+  }
+  for (int i = begin; i < begin + PER_THREAD; ++i) {
+    worker->missing += !table_sharded_contains(worker->table, &vtable, &i);
+  }
+  for (int i = -1; i >= -PER_THREAD; --i) {
+    worker->inserted +=
+        table_sharded_upsert(worker->table, &vtable, &i, allocator_global,
+                             NULL);
+  }
+  for (int i = begin; i < begin + PER_THREAD; i += 2) {
+    worker->missing += !table_sharded_remove(worker->table, &vtable, &i);
+  }
+}
+
+static void test__single_thread(void) {
+  TableSharded table;
+  Error error = 0;
+  table_sharded_init(&table, &vtable, 5, 100, allocator_global, &error);
+  TEST_INT(error, 0);
+  TEST_INT(table.num_shards, 8);
+  // every shard starts on its own cache line
+  TEST_INT((uintptr_t)table.shard % 64, 0);
+  TEST_INT(sizeof(TableShard) % 64, 0);
+
+  for (int i = 0; i < 10000; ++i) {
+    TEST_INT(table_sharded_upsert(&table, &vtable, &i, allocator_global, NULL),
+             1);
+  }
+  TEST_INT(table_sharded_upsert(&table, &vtable, &(int){5}, allocator_global,
+                                NULL),
+           0);
+  TEST_INT(table_sharded_length(&table), 10000);
+
+  for (int i = 0; i < 20000; ++i) {
+    int out = -1;
+    TEST_INT(table_sharded_get(&table, &vtable, &i, &out), i < 10000);
+    TEST_INT(out, i < 10000 ? i : -1);
+  }
+  for (int i = 0; i < 10000; i += 2) {
+    TEST_INT(table_sharded_remove(&table, &vtable, &i), 1);
+  }
+  TEST_INT(table_sharded_length(&table), 5000);
+  for (int i = 0; i < 10000; ++i) {
+    TEST_INT(table_sharded_contains(&table, &vtable, &i), i % 2);
+  }
+
+  table_sharded_deinit(&table, allocator_global);
+}
+
+static void test__threads(void) {
+  TableSharded table;
+  table_sharded_init(&table, &vtable, 16, 0, allocator_global, NULL);
+
+  Worker workers[THREADS];
+  Thread threads[THREADS];
+  for (int t = 0; t < THREADS; ++t) {
+    workers[t] = (Worker){.table = &table, .thread = t};
+    thread_spawn(&threads[t], worker_run, &workers[t], NULL);
+  }
+  usize inserted = 0;
+  for (int t = 0; t < THREADS; ++t) {
+    thread_join(&threads[t]);
+    inserted += workers[t].inserted;
+    TEST_INT(workers[t].missing, 0);
+  }
+
+  // every shared key was inserted by exactly one thread
+  TEST_INT(inserted, PER_THREAD);
+  TEST_INT(table_sharded_length(&table), THREADS * PER_THREAD / 2 + PER_THREAD);
+  for (int i = 0; i < THREADS * PER_THREAD; ++i) {
+    TEST_INT(table_sharded_contains(&table, &vtable, &i), i % 2);
+  }
+
+  table_sharded_deinit(&table, allocator_global);
+}
+
+int main(void) {
+  test__single_thread();
+  test__threads();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_small.h>
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32(*(const u32 *)d);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(int),
+    .compare = int_compare,
+    .insert = int_insert,
+    .overwrite = int_insert,
+    .hash = int_hash,
+};
+
+// counts the calls which reach the backing allocator
+static usize backing_allocs = 0;
+
+static void *counting_alloc(Allocator *allocator, usize num_bytes,
+                            Error *error) {
+  UNUSED(allocator);
+  backing_allocs += 1;
+  return allocator_alloc(allocator_global, num_bytes, error);
+}
+
+static void counting_free(Allocator *allocator, void *chunk) {
+  UNUSED(allocator);
+  allocator_free(allocator_global, chunk);
+}
+
+static void *counting_realloc(Allocator *allocator, void *chunk,
+                              usize num_bytes, Error *error) {
+  UNUSED(allocator);
+  backing_allocs += 1;
+  return allocator_realloc(allocator_global, chunk, num_bytes, error);
+}
+
+static AllocatorVTable counting_vtable = {
+    .alloc = counting_alloc,
+    .free = counting_free,
+    .realloc = counting_realloc,
+};
+
+static AllocatorInternal counting = {.vtable = &counting_vtable};
+
+static void test__inline(void) {
+  u64 storage[TABLE_SMALL_STORAGE_SIZE(sizeof(int)) / sizeof(u64)];
+  TEST_INT(sizeof(storage) >= table_small_storage_size(&vtable), 1);
+  TableSmall small;
+  table_small_init(&small, storage, sizeof(storage), &counting);
+
+  backing_allocs = 0;
+  Table(int) table;
+  table_init(&table, &vtable, 0, &small, NULL);
+  TEST_INT(table_small_is_inline(&small, &table), 1);
+  TEST_INT(table.end, TABLE_INTERNAL_MIN_END);
+
+  for (int i = 0; i < TABLE_SMALL_CAPACITY; ++i) {
+    table_insert(&table, &vtable, &i, &small, NULL);
+  }
+  for (int i = 0; i < 2 * TABLE_SMALL_CAPACITY; ++i) {
+    TEST_INT(table_contains(&table, &vtable, &i), i < TABLE_SMALL_CAPACITY);
+  }
+  for (int i = 0; i < TABLE_SMALL_CAPACITY; i += 2) {
+    TEST_INT(table_remove(&table, &vtable, &i), 1);
+  }
+  TEST_INT(table_small_is_inline(&small, &table), 1);
+  TEST_INT(backing_allocs, 0);
+
+  table_deinit(&table, &small);
+  TEST_INT(small.in_use, 0);
+}
+
+static void test__grow(void) {
+  u64 storage[TABLE_SMALL_STORAGE_SIZE(sizeof(int)) / sizeof(u64)];
+  TableSmall small;
+  table_small_init(&small, storage, sizeof(storage), &counting);
+
+  backing_allocs = 0;
+  Table(int) table;
+  table_init(&table, &vtable, 4, &small, NULL);
+  for (int i = 0; i < 1000; ++i) {
+    table_insert(&table, &vtable, &i, &small, NULL);
+  }
+  TEST_INT(table_small_is_inline(&small, &table), 0);
+  TEST_INT(small.in_use, 0);
+  TEST_INT(backing_allocs > 0, 1);
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(table_contains(&table, &vtable, &i), 1);
+  }
+
+  // shrinking back below the capacity moves the table into the storage again
+  for (int i = 5; i < 1000; ++i) {
+    TEST_INT(table_remove(&table, &vtable, &i), 1);
+  }
+  table_shrink(&table, &vtable, &small, NULL);
+  TEST_INT(table_small_is_inline(&small, &table), 1);
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(table_contains(&table, &vtable, &i), i < 5);
+  }
+
+  table_deinit(&table, &small);
+}
+
+static void test__incremental(void) {
+  TableVTable incremental = vtable;
+  incremental.migrate_groups = 1;
+  incremental.store_hash = true;
+
+  const usize storage_size = table_small_storage_size(&incremental);
+  u64 storage[64];
+  TEST_INT(storage_size <= sizeof(storage), 1);
+  TableSmall small;
+  table_small_init(&small, storage, storage_size, allocator_global);
+
+  Table(int) table;
+  table_init(&table, &incremental, 0, &small, NULL);
+  TEST_INT(table_small_is_inline(&small, &table), 1);
+  for (int i = 0; i < 200; ++i) {
+    table_insert(&table, &incremental, &i, &small, NULL);
+  }
+  for (int i = 0; i < 200; ++i) {
+    TEST_INT(table_contains(&table, &incremental, &i), 1);
+  }
+  TEST_INT(small.in_use, 0);
+
+  table_deinit(&table, &small);
+}
+
+int main(void) {
+  test__inline();
+  test__grow();
+  test__incremental();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_snapshot.h>
+
+#define PATH "/tmp/uc_test_table_snapshot.bin"
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32(*(const u32 *)d);
+}
+
+static const TableVTable vtable = {
+    .element_size = sizeof(int),
+    .compare = int_compare,
+    .insert = int_insert,
+    .hash = int_hash,
+    .overwrite = int_insert,
+};
+
+static void test__save_map(const TableVTable *vtable) {
+  Error error = 0;
+  TableVTable incremental = *vtable;
+  incremental.migrate_groups = 1;
+
+  Table(int) table;
+  table_init(&table, &incremental, 8, allocator_global, NULL);
+  for (int i = 0; i < 10000; ++i) {
+    table_insert(&table, &incremental, &i, allocator_global, NULL);
+    if (i % 5 == 0) {
+      table_remove(&table, &incremental, &i);
+    }
+  }
+
+  // an unfinished resize is completed before saving
+  table_save(&table, &incremental, PATH, allocator_global, &error);
+  TEST_INT(error, 0);
+  TEST_INT(table.old_end, 0);
+
+  Table(int) mapped;
+  TableMapping mapping;
+  table_map(&mapped, &incremental, PATH, TABLE_MAP_READ_ONLY, &mapping,
+            &error);
+  TEST_INT(error, 0);
+  TEST_INT(mapped.length, table.length);
+  TEST_INT(mapped.end, table.end);
+  TEST_INT(mapped.tombs, table.tombs);
+  for (int i = 0; i < 20000; ++i) {
+    TEST_INT(table_contains(&mapped, &incremental, &i),
+             i < 10000 && i % 5 != 0);
+  }
+
+  // copy on write mappings can be modified without touching the file
+  Table(int) private;
+  TableMapping private_mapping;
+  table_map(&private, &incremental, PATH, TABLE_MAP_COPY_ON_WRITE,
+            &private_mapping, &error);
+  TEST_INT(error, 0);
+  for (int i = 0; i < 100; ++i) {
+    TEST_INT(table_remove(&private, &incremental, &i), i % 5 != 0);
+  }
+  TEST_INT(private.length, table.length - 80);
+  for (int i = 0; i < 100; ++i) {
+    TEST_INT(table_contains(&mapped, &incremental, &i), i % 5 != 0);
+  }
+
+  table_unmap(&private_mapping);
+  table_unmap(&mapping);
+  TEST_INT(mapping.base == NULL, 1);
+  table_deinit(&table, allocator_global);
+  (void)remove(PATH);
+}
+
+static void test__errors(void) {
+  Error error = 0;
+  Table(int) table;
+  table_init(&table, &vtable, 100, allocator_global, NULL);
+  table_save(&table, &vtable, PATH, allocator_global, &error);
+  TEST_INT(error, 0);
+
+  Table(int) mapped;
+  TableMapping mapping;
+
+  // the element size has to match
+  TableVTable other = vtable;
+  other.element_size = 8;
+  table_map(&mapped, &other, PATH, TABLE_MAP_READ_ONLY, &mapping, &error);
+  TEST_INT(error, EINVAL);
+  TEST_INT(mapping.base == NULL, 1);
+
+  // as well as whether hashes are stored
+  error = 0;
+  other = vtable;
+  other.store_hash = true;
+  table_map(&mapped, &other, PATH, TABLE_MAP_READ_ONLY, &mapping, &error);
+  TEST_INT(error, EINVAL);
+
+  // truncated files are rejected
+  error = 0;
+  FILE *file = fopen(PATH, "r+b");
+  char header[100];
+  TEST_INT(fread(header, 1, sizeof(header), file), sizeof(header));
+  TEST_INT(fclose(file), 0);
+  file = fopen(PATH, "wb");
+  TEST_INT(fwrite(header, 1, sizeof(header), file), sizeof(header));
+  TEST_INT(fclose(file), 0);
+  table_map(&mapped, &vtable, PATH, TABLE_MAP_READ_ONLY, &mapping, &error);
+  TEST_INT(error, EINVAL);
+
+  error = 0;
+  (void)remove(PATH);
+  table_map(&mapped, &vtable, PATH, TABLE_MAP_READ_ONLY, &mapping, &error);
+  TEST_INT(error, ENOENT);
+
+  table_deinit(&table, allocator_global);
+}
+
+int main(void) {
+  test__save_map(&vtable);
+
+  TableVTable stored = vtable;
+  stored.store_hash = true;
+  test__save_map(&stored);
+
+  test__errors();
+  TEST_OVERVIEW();
+  return 0;
+}
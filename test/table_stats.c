@@ -0,0 +1,188 @@
+#define TABLE_STATS
+
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/table_stats.h>
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return hash_u32(*(const u32 *)d);
+}
+
+// every element lands in the same slot with the same tag
+// every key sits in its own home slot, consecutive keys fill whole groups
+static u64 int_hash_identity(const void *d, void *ctx) {
+  UNUSED(ctx);
+  return *(const u32 *)d;
+}
+
+static u64 int_hash_constant(const void *d, void *ctx) {
+  UNUSED(d);
+  UNUSED(ctx);
+  return 0;
+}
+
+static TableStats stats;
+
+static u64 probe_total(const TableStats *s) {
+  u64 total = 0;
+  for (usize i = 0; i < TABLE_STATS_PROBE_BUCKETS; ++i) {
+    total += s->probe_groups[i];
+  }
+  return total;
+}
+
+static void test__counters(void) {
+  const TableVTable vtable = {
+      .element_size = sizeof(int),
+      .compare = int_compare,
+      .insert = int_insert,
+      .overwrite = int_insert,
+      .hash = int_hash,
+      .stats = &stats,
+  };
+  table_stats_reset(&stats);
+
+  Table(int) table;
+  table_init(&table, &vtable, 16, allocator_global, NULL);
+  const usize initial_end = table.end;
+  for (int i = 0; i < 1000; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+  TEST_INT(stats.finds, 1000);
+  TEST_INT(probe_total(&stats), stats.finds);
+  TEST_INT(stats.resizes > 0, 1);
+  TEST_INT((usize)1 << stats.resizes, table.end / initial_end);
+  TEST_INT(stats.purges, 0);
+
+  table_stats_reset(&stats);
+  for (int i = 0; i < 1000; ++i) {
+    TEST_INT(table_contains(&table, &vtable, &i), 1);
+  }
+  TEST_INT(stats.finds, 1000);
+  TEST_INT(stats.tag_matches - stats.false_positives, 1000);
+  TEST_INT(stats.compares, stats.tag_matches);
+  TEST_INT(stats.resizes, 0);
+
+  // a miss can have tag matches, but every one of them is a false positive
+  table_stats_reset(&stats);
+  for (int i = 1000; i < 2000; ++i) {
+    TEST_INT(table_contains(&table, &vtable, &i), 0);
+  }
+  TEST_INT(stats.finds, 1000);
+  TEST_INT(stats.tag_matches, stats.false_positives);
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__collisions(void) {
+  const TableVTable vtable = {
+      .element_size = sizeof(int),
+      .compare = int_compare,
+      .insert = int_insert,
+      .overwrite = int_insert,
+      .hash = int_hash_constant,
+      .stats = &stats,
+  };
+  table_stats_reset(&stats);
+
+  Table(int) table;
+  table_init(&table, &vtable, 64, allocator_global, NULL);
+  const usize count = 4 * TABLE_GROUP_WIDTH;
+  for (int i = 0; i < (int)count; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+
+  // looking for the last element compares against every element before it
+  // and walks through all groups they fill
+  table_stats_reset(&stats);
+  const int last = (int)count - 1;
+  TEST_INT(table_contains(&table, &vtable, &last), 1);
+  TEST_INT(stats.finds, 1);
+  TEST_INT(stats.compares, count);
+  TEST_INT(stats.false_positives, count - 1);
+  TEST_INT(stats.probe_groups[3], 1);
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__purge(void) {
+  const TableVTable vtable = {
+      .element_size = sizeof(int),
+      .compare = int_compare,
+      .insert = int_insert,
+      .overwrite = int_insert,
+      .hash = int_hash_identity,
+      .stats = &stats,
+  };
+  table_stats_reset(&stats);
+
+  // keeps the length constant while leaving tombs behind until a purge. The
+  // elements form one run of consecutive slots which is far longer than a
+  // group, so whatever `TABLE_GROUP_WIDTH` is, every erased slot has a full
+  // group around it and becomes a tomb
+  Table(int) table;
+  table_init(&table, &vtable, 1000, allocator_global, NULL);
+  for (int i = 0; i < 800; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+  table_stats_reset(&stats);
+  for (int i = 0; i < 20000; ++i) {
+    const int old = i;
+    const int new = i + 800;
+    table_remove(&table, &vtable, &old);
+    table_insert(&table, &vtable, &new, allocator_global, NULL);
+  }
+  TEST_INT(stats.purges > 0, 1);
+  TEST_INT(stats.resizes, 0);
+  TEST_INT(table_stats_tomb_ratio(&table) < 0.25, 1);
+  TEST_INT(table_stats_load(&table) * table.end + 0.5 >= 800, 1);
+
+  table_deinit(&table, allocator_global);
+}
+
+static void test__report(void) {
+  const TableVTable vtable = {
+      .element_size = sizeof(int),
+      .compare = int_compare,
+      .insert = int_insert,
+      .overwrite = int_insert,
+      .hash = int_hash,
+      .stats = &stats,
+  };
+  table_stats_reset(&stats);
+
+  Table(int) table;
+  table_init(&table, &vtable, 16, allocator_global, NULL);
+  for (int i = 0; i < 100; ++i) {
+    table_insert(&table, &vtable, &i, allocator_global, NULL);
+  }
+
+  FILE *stream = tmpfile();
+  TEST_INT(stream != NULL, 1);
+  table_stats(&table, &vtable, stream);
+  TEST_INT(ftell(stream) > 0, 1);
+  (void)fclose(stream);
+
+  table_deinit(&table, allocator_global);
+}
+
+int main(void) {
+  test__counters();
+  test__collisions();
+  test__purge();
+  test__report();
+
+  TEST_OVERVIEW();
+  return 0;
+}
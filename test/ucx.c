@@ -0,0 +1,66 @@
+#include "test.h"
+#include <uc/ucx.c>
+
+#include <string.h>
+
+static bool int_compare(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)a == *(const int *)b;
+}
+
+static void int_insert(void *dest, const void *src, void *ctx) {
+  UNUSED(ctx);
+  *(int *)dest = *(const int *)src;
+}
+
+static u64 int_hash(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return (u64)*(const int *)element * 0x9E3779B97F4A7C15ull;
+}
+
+// the vtable is surrounded by garbage, every field the library reads through
+// the wrappers has to be part of `ucx_TableVTable`
+typedef struct Poisoned Poisoned;
+struct Poisoned {
+  u64 before[4];
+  ucx_TableVTable vtable;
+  u64 after[4];
+};
+
+static void test__vtable_layout(void) {
+  Poisoned poisoned;
+  memset(&poisoned, 0xa5, sizeof(poisoned));
+  ucx_TableVTable *vtable = &poisoned.vtable;
+  memset(vtable, 0, sizeof(*vtable));
+  vtable->hash = int_hash;
+  vtable->insert = int_insert;
+  vtable->overwrite = int_insert;
+  vtable->compare = int_compare;
+  vtable->element_size = sizeof(int);
+
+  ucx_Error error = 0;
+  ucx_Table(int) table;
+  ucx_table_init(&table, vtable, 8, ucx_allocator_global, &error);
+  TEST_INT(error, 0);
+  for (int i = 0; i < 1000; ++i) {
+    ucx_table_insert(&table, vtable, &i, ucx_allocator_global, &error);
+  }
+  TEST_INT(error, 0);
+  TEST_INT(table.length, 1000);
+  for (int i = 0; i < 2000; ++i) {
+    TEST_INT(ucx_table_contains(&table, vtable, &i), i < 1000);
+  }
+  ucx_table_reserve(&table, vtable, 5000, ucx_allocator_global, &error);
+  ucx_table_shrink(&table, vtable, ucx_allocator_global, &error);
+  TEST_INT(error, 0);
+  const int key = 123;
+  const usize index = ucx_table_find(&table, vtable, &key);
+  TEST_INT(*(const int *)ucx_table_get(&table, vtable, index), 123);
+  ucx_table_deinit(&table, ucx_allocator_global);
+}
+
+int main(void) {
+  test__vtable_layout();
+  TEST_OVERVIEW();
+  return 0;
+}
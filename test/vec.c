@@ -41,8 +41,172 @@ static void test__push_pop(void) {
   vec_deinit(&vec, sizeof(int), allocator_global);
 }
 
+static void test__bulk(void) {
+  Error error = 0;
+  Vec(int) vec;
+  vec_init(&vec, sizeof(int), 1, allocator_global, &error);
+  unwrap(error);
+
+  int numbers[100];
+  for (int i = 0; i < 100; ++i) {
+    numbers[i] = i;
+  }
+  vec_extend(&vec, sizeof(int), numbers, 100, allocator_global, &error);
+  unwrap(error);
+  TEST_INT(vec.length, 100);
+  TEST_INT(vec.end >= 100, 1);
+  for (int i = 0; i < 100; ++i) {
+    TEST_INT(vec.element[i], i);
+  }
+
+  // 0..9 -1 -2 -3 10..99
+  const int negative[] = {-1, -2, -3};
+  vec_insert_many(&vec, sizeof(int), 10, negative, 3, allocator_global,
+                  &error);
+  unwrap(error);
+  TEST_INT(vec.length, 103);
+  TEST_INT(vec.element[9], 9);
+  TEST_INT(vec.element[10], -1);
+  TEST_INT(vec.element[12], -3);
+  TEST_INT(vec.element[13], 10);
+  TEST_INT(vec.element[102], 99);
+
+  vec_insert_many(&vec, sizeof(int), 103, negative, 3, allocator_global,
+                  &error);
+  vec_insert_many(&vec, sizeof(int), 0, negative, 0, allocator_global,
+                  &error);
+  unwrap(error);
+  TEST_INT(vec.length, 106);
+  TEST_INT(vec.element[105], -3);
+
+  vec_remove_range(&vec, sizeof(int), 10, 3);
+  vec_remove_range(&vec, sizeof(int), 100, 3);
+  vec_remove_range(&vec, sizeof(int), 0, 0);
+  TEST_INT(vec.length, 100);
+  for (int i = 0; i < 100; ++i) {
+    TEST_INT(vec.element[i], i);
+  }
+
+  int *tail = vec_append_uninit(&vec, sizeof(int), 50, allocator_global,
+                                &error);
+  unwrap(error);
+  TEST_INT(tail == vec.element + 100, 1);
+  TEST_INT(vec.length, 150);
+
+  vec_resize(&vec, sizeof(int), 10, NULL, allocator_global, &error);
+  TEST_INT(vec.length, 10);
+  const int seven = 7;
+  vec_resize(&vec, sizeof(int), 1000, &seven, allocator_global, &error);
+  unwrap(error);
+  TEST_INT(vec.length, 1000);
+  TEST_INT(vec.end, 1000);
+  TEST_INT(vec.element[9], 9);
+  TEST_INT(vec.element[10], 7);
+  TEST_INT(vec.element[999], 7);
+  vec_resize(&vec, sizeof(int), 5, NULL, allocator_global, &error);
+  vec_resize(&vec, sizeof(int), 8, NULL, allocator_global, &error);
+  TEST_INT(vec.element[4], 4);
+  TEST_INT(vec.element[5], 0);
+  TEST_INT(vec.element[7], 0);
+
+  vec_deinit(&vec, sizeof(int), allocator_global);
+}
+
+static bool keep_odd(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return *(const int *)element & 1;
+}
+
+static void test__retain(void) {
+  Error error = 0;
+  Vec(int) vec;
+  vec_init(&vec, sizeof(int), 1, allocator_global, &error);
+  unwrap(error);
+  for (int i = 0; i < 10; ++i) {
+    vec_push(&vec, sizeof(int), &i, allocator_global, &error);
+  }
+  unwrap(error);
+
+  vec_swap_remove(&vec, sizeof(int), 2);
+  TEST_INT(vec.length, 9);
+  TEST_INT(vec.element[2], 9);
+  TEST_INT(vec.element[8], 8);
+  vec_swap_remove(&vec, sizeof(int), 8);
+  TEST_INT(vec.length, 8);
+  TEST_INT(vec.element[7], 7);
+
+  // 0 1 9 3 4 5 6 7
+  vec_retain(&vec, sizeof(int), keep_odd, NULL);
+  TEST_INT(vec.length, 5);
+  TEST_INT(vec.element[0], 1);
+  TEST_INT(vec.element[1], 9);
+  TEST_INT(vec.element[2], 3);
+  TEST_INT(vec.element[3], 5);
+  TEST_INT(vec.element[4], 7);
+  vec_retain(&vec, sizeof(int), keep_odd, NULL);
+  TEST_INT(vec.length, 5);
+  vec_deinit(&vec, sizeof(int), allocator_global);
+
+  // lengths which are not a multiple of any vector width and ranges at the
+  // ends of the value range, checked against a plain loop
+  const u64 ranges[][2] = {
+      {100, 200}, {0, 50}, {0, ~0ull}, {~0ull - 10, ~0ull}, {7, 7}};
+  for (usize r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+    for (usize length = 0; length < 300; length += 37) {
+      Vec(u32) small;
+      Vec(u64) large;
+      vec_init(&small, sizeof(u32), 1, allocator_global, &error);
+      vec_init(&large, sizeof(u64), 1, allocator_global, &error);
+      vec_resize(&small, sizeof(u32), length, NULL, allocator_global, &error);
+      vec_resize(&large, sizeof(u64), length, NULL, allocator_global, &error);
+      unwrap(error);
+      u64 x = 12345;
+      for (usize i = 0; i < length; ++i) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        const u64 value = i % 3 ? x >> 56 : x;
+        large.element[i] = ranges[r][0] > 100 ? ~value : value;
+        small.element[i] = (u32)large.element[i];
+      }
+      const u32 low32 = (u32)(ranges[r][0] > 0xffffffffull ? 0xfffffff0u
+                                                           : ranges[r][0]);
+      const u32 high32 = (u32)(ranges[r][1] > 0xffffffffull ? 0xffffffffu
+                                                            : ranges[r][1]);
+      Vec(u64) expected;
+      vec_init(&expected, sizeof(u64), 1, allocator_global, &error);
+      vec_extend(&expected, sizeof(u64), large.element, length,
+                 allocator_global, &error);
+      unwrap(error);
+
+      vec_retain_range_u32(&small, low32, high32);
+      vec_retain_range_u64(&large, ranges[r][0], ranges[r][1]);
+
+      bool same = true;
+      usize s = 0;
+      usize l = 0;
+      for (usize i = 0; i < length; ++i) {
+        const u64 value = expected.element[i];
+        if (low32 <= (u32)value && (u32)value <= high32) {
+          same &= s < small.length && small.element[s++] == (u32)value;
+        }
+        if (ranges[r][0] <= value && value <= ranges[r][1]) {
+          same &= l < large.length && large.element[l++] == value;
+        }
+      }
+      TEST_INT(same, 1);
+      TEST_INT(small.length, s);
+      TEST_INT(large.length, l);
+
+      vec_deinit(&expected, sizeof(u64), allocator_global);
+      vec_deinit(&small, sizeof(u32), allocator_global);
+      vec_deinit(&large, sizeof(u64), allocator_global);
+    }
+  }
+}
+
 int main(void) {
   test__push_pop();
+  test__bulk();
+  test__retain();
   TEST_OVERVIEW();
   return 0;
 }
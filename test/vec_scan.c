@@ -0,0 +1,248 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/vec_scan.h>
+
+// every kernel is compared with a plain loop, for lengths around the vector
+// widths and on inputs starting at unaligned addresses
+
+typedef Vec(u8) U8Vec;
+typedef Vec(u32) U32Vec;
+typedef Vec(u64) U64Vec;
+typedef Vec(i32) I32Vec;
+typedef Vec(i64) I64Vec;
+typedef Vec(float) FloatVec;
+
+static const usize lengths[] = {0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33,
+                                63, 64, 65, 100, 255, 1000, 8191, 9000};
+
+#define NUM_LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+// a view of `element + offset`, the kernels only read `element` and `length`
+#define VIEW(vec, type, offset, count)                                        \
+  ((type){.element = (vec)->element + (offset), .length = (count)})
+
+static void test__find(void) {
+  Error error = 0;
+  U8Vec bytes;
+  U32Vec words;
+  U64Vec longs;
+  vec_init(&bytes, sizeof(u8), 10000, allocator_global, &error);
+  vec_init(&words, sizeof(u32), 10000, allocator_global, &error);
+  vec_init(&longs, sizeof(u64), 10000, allocator_global, &error);
+  TEST_INT(error, 0);
+
+  for (usize l = 0; l < NUM_LENGTHS; ++l) {
+    const usize length = lengths[l];
+    for (usize offset = 0; offset < 2; ++offset) {
+      // values below the length, except for the one searched
+      for (usize i = 0; i < length + offset; ++i) {
+        bytes.element[i] = (u8)(i % 200);
+        words.element[i] = (u32)i;
+        // equal low halves, only the high half differs
+        longs.element[i] = ((u64)i << 32) | 7;
+      }
+      bool found = true;
+      for (usize target = 0; target <= length; target += length / 7 + 1) {
+        const U8Vec b = VIEW(&bytes, U8Vec, offset, length);
+        const U32Vec w = VIEW(&words, U32Vec, offset, length);
+        const U64Vec q = VIEW(&longs, U64Vec, offset, length);
+        if (target < length) {
+          b.element[target] = 250;
+          w.element[target] = 0xdeadbeef;
+          q.element[target] = 0xdeadbeefull << 32 | 7;
+        }
+        found &= vec_find_u8(&b, 250) == target;
+        found &= vec_find_u32(&w, 0xdeadbeef) == target;
+        found &= vec_find_u64(&q, 0xdeadbeefull << 32 | 7) == target;
+        // the first of two matches
+        if (target + 1 < length) {
+          b.element[target + 1] = 250;
+          w.element[target + 1] = 0xdeadbeef;
+          q.element[target + 1] = 0xdeadbeefull << 32 | 7;
+          found &= vec_find_u8(&b, 250) == target;
+          found &= vec_find_u32(&w, 0xdeadbeef) == target;
+          found &= vec_find_u64(&q, 0xdeadbeefull << 32 | 7) == target;
+        }
+        for (usize i = 0; i < length; ++i) {
+          b.element[i] = (u8)((i + offset) % 200);
+          w.element[i] = (u32)(i + offset);
+          q.element[i] = ((u64)(i + offset) << 32) | 7;
+        }
+      }
+      TEST_INT(found, 1);
+    }
+  }
+
+  vec_deinit(&bytes, sizeof(u8), allocator_global);
+  vec_deinit(&words, sizeof(u32), allocator_global);
+  vec_deinit(&longs, sizeof(u64), allocator_global);
+}
+
+static void test__count(void) {
+  Error error = 0;
+  // more than 255 rounds of the byte counters
+  const usize max = 40000;
+  U8Vec bytes;
+  U32Vec words;
+  vec_init(&bytes, sizeof(u8), max + 1, allocator_global, &error);
+  vec_init(&words, sizeof(u32), max + 1, allocator_global, &error);
+  TEST_INT(error, 0);
+  for (usize i = 0; i < max + 1; ++i) {
+    bytes.element[i] = (u8)(hash_u64(i) % 3);
+    words.element[i] = (u32)(hash_u64(i) % 3);
+  }
+
+  const usize counts[] = {0, 5, 16, 33, 4080, 4096, 8191, 40000};
+  for (usize c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    for (usize offset = 0; offset < 2; ++offset) {
+      const U8Vec b = VIEW(&bytes, U8Vec, offset, counts[c]);
+      const U32Vec w = VIEW(&words, U32Vec, offset, counts[c]);
+      bool same = true;
+      for (u8 value = 0; value < 4; ++value) {
+        usize expected = 0;
+        for (usize i = 0; i < counts[c]; ++i) {
+          expected += b.element[i] == value;
+        }
+        same &= vec_count_eq_u8(&b, value) == expected;
+        same &= vec_count_eq_u32(&w, value) == expected;
+      }
+      TEST_INT(same, 1);
+    }
+  }
+
+  // every element matching
+  for (usize i = 0; i < max; ++i) {
+    bytes.element[i] = 0xff;
+  }
+  const U8Vec all = VIEW(&bytes, U8Vec, 0, max);
+  TEST_INT(vec_count_eq_u8(&all, 0xff), max);
+
+  vec_deinit(&bytes, sizeof(u8), allocator_global);
+  vec_deinit(&words, sizeof(u32), allocator_global);
+}
+
+static void test__sum(void) {
+  Error error = 0;
+  I32Vec ints;
+  I64Vec longs;
+  vec_init(&ints, sizeof(i32), 10000, allocator_global, &error);
+  vec_init(&longs, sizeof(i64), 10000, allocator_global, &error);
+  TEST_INT(error, 0);
+
+  for (usize l = 0; l < NUM_LENGTHS; ++l) {
+    const usize length = lengths[l];
+    for (usize offset = 0; offset < 2; ++offset) {
+      for (usize i = 0; i < length + offset; ++i) {
+        // large values of both signs, an `i32` sum would overflow
+        ints.element[i] = (i32)(u32)hash_u64(i);
+        longs.element[i] = (i64)hash_u64(i);
+      }
+      const I32Vec a = VIEW(&ints, I32Vec, offset, length);
+      const I64Vec b = VIEW(&longs, I64Vec, offset, length);
+      i64 expected_a = 0;
+      u64 expected_b = 0;
+      for (usize i = 0; i < length; ++i) {
+        expected_a += a.element[i];
+        expected_b += (u64)b.element[i];
+      }
+      TEST_INT(vec_sum_i32(&a) == expected_a, 1);
+      TEST_INT(vec_sum_i64(&b) == (i64)expected_b, 1);
+    }
+  }
+
+  // the extremes
+  for (usize i = 0; i < 100; ++i) {
+    ints.element[i] = INT32_MIN;
+  }
+  const I32Vec minimum = VIEW(&ints, I32Vec, 0, 100);
+  TEST_INT(vec_sum_i32(&minimum) == (i64)INT32_MIN * 100, 1);
+
+  vec_deinit(&ints, sizeof(i32), allocator_global);
+  vec_deinit(&longs, sizeof(i64), allocator_global);
+}
+
+static void test__minmax(void) {
+  Error error = 0;
+  I32Vec ints;
+  FloatVec floats;
+  vec_init(&ints, sizeof(i32), 10000, allocator_global, &error);
+  vec_init(&floats, sizeof(float), 10000, allocator_global, &error);
+  TEST_INT(error, 0);
+
+  i32 min = 1;
+  i32 max = 2;
+  const I32Vec empty = VIEW(&ints, I32Vec, 0, 0);
+  TEST_INT(vec_minmax_i32(&empty, &min, &max), 0);
+  TEST_INT(min == 1 && max == 2, 1);
+
+  for (usize l = 1; l < NUM_LENGTHS; ++l) {
+    const usize length = lengths[l];
+    for (usize offset = 0; offset < 2; ++offset) {
+      for (usize i = 0; i < length + offset; ++i) {
+        ints.element[i] = (i32)(u32)hash_u64(i);
+        floats.element[i] = (float)(i32)(u32)hash_u64(i) * 0.5f;
+        // a NaN in every few elements
+        if (i % 5 == 3) {
+          floats.element[i] = NAN;
+        }
+      }
+      const I32Vec a = VIEW(&ints, I32Vec, offset, length);
+      const FloatVec b = VIEW(&floats, FloatVec, offset, length);
+      i32 expected_min = a.element[0];
+      i32 expected_max = a.element[0];
+      float expected_low = INFINITY;
+      float expected_high = -INFINITY;
+      for (usize i = 0; i < length; ++i) {
+        expected_min =
+            a.element[i] < expected_min ? a.element[i] : expected_min;
+        expected_max =
+            a.element[i] > expected_max ? a.element[i] : expected_max;
+        if (b.element[i] == b.element[i]) {
+          expected_low =
+              b.element[i] < expected_low ? b.element[i] : expected_low;
+          expected_high =
+              b.element[i] > expected_high ? b.element[i] : expected_high;
+        }
+      }
+      TEST_INT(vec_minmax_i32(&a, &min, &max), 1);
+      TEST_INT(min == expected_min && max == expected_max, 1);
+
+      float low = 1;
+      float high = 2;
+      const bool any = vec_minmax_f32(&b, &low, &high);
+      TEST_INT(any, expected_low <= expected_high);
+      if (any) {
+        TEST_INT(low == expected_low && high == expected_high, 1);
+      } else {
+        TEST_INT(low == 1 && high == 2, 1);
+      }
+    }
+  }
+
+  // only NaNs
+  for (usize i = 0; i < 40; ++i) {
+    floats.element[i] = NAN;
+  }
+  float low = 1;
+  float high = 2;
+  const FloatVec nans = VIEW(&floats, FloatVec, 0, 40);
+  TEST_INT(vec_minmax_f32(&nans, &low, &high), 0);
+
+  // infinities are regular values
+  floats.element[20] = -INFINITY;
+  floats.element[37] = INFINITY;
+  TEST_INT(vec_minmax_f32(&nans, &low, &high), 1);
+  TEST_INT(low == -INFINITY && high == INFINITY, 1);
+
+  vec_deinit(&ints, sizeof(i32), allocator_global);
+  vec_deinit(&floats, sizeof(float), allocator_global);
+}
+
+int main(void) {
+  test__find();
+  test__count();
+  test__sum();
+  test__minmax();
+  TEST_OVERVIEW();
+  return 0;
+}
@@ -0,0 +1,192 @@
+#include "test.h"
+#include <uc/hash.h>
+#include <uc/vec_sort.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Entry Entry;
+struct Entry {
+  u64 key;
+  u64 position;
+  // makes the element larger than the swap buffer
+  byte padding[60];
+};
+
+typedef Vec(u64) U64Vec;
+typedef Vec(Entry) EntryVec;
+
+static bool u64_less(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return *(const u64 *)a < *(const u64 *)b;
+}
+
+static bool entry_less(const void *a, const void *b, void *ctx) {
+  UNUSED(ctx);
+  return ((const Entry *)a)->key < ((const Entry *)b)->key;
+}
+
+static u64 entry_key(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return ((const Entry *)element)->key;
+}
+
+static u64 i64_key(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return vec_sort_key_i64(*(const i64 *)element);
+}
+
+static u64 f64_key(const void *element, void *ctx) {
+  UNUSED(ctx);
+  return vec_sort_key_f64(*(const double *)element);
+}
+
+enum { RANDOM, SORTED, REVERSED, FEW, SAWTOOTH, NARROW, NUM_PATTERNS };
+
+static u64 pattern(int kind, usize i, usize count) {
+  switch (kind) {
+  case RANDOM:
+    return hash_u64(i);
+  case SORTED:
+    return i;
+  case REVERSED:
+    return count - i;
+  case FEW:
+    return hash_u64(i) % 4;
+  case SAWTOOTH:
+    return i % 100;
+  default:
+    // differs only in a middle byte
+    return ((hash_u64(i) % 256) << 24) | 0xff00000000000000ull;
+  }
+}
+
+// sorts with both sorts and compares the result with a counting check: the
+// elements are ascending and the sum and xor are unchanged
+static void test__u64(usize count, usize num_threads) {
+  Error error = 0;
+  for (int kind = 0; kind < NUM_PATTERNS; ++kind) {
+    U64Vec a;
+    U64Vec b;
+    vec_init(&a, sizeof(u64), count ? count : 1, allocator_global, &error);
+    vec_init(&b, sizeof(u64), count ? count : 1, allocator_global, &error);
+    u64 sum = 0;
+    u64 x = 0;
+    for (usize i = 0; i < count; ++i) {
+      const u64 value = pattern(kind, i, count);
+      vec_push(&a, sizeof(u64), &value, allocator_global, &error);
+      vec_push(&b, sizeof(u64), &value, allocator_global, &error);
+      sum += value;
+      x ^= value;
+    }
+
+    vec_sort(&a, sizeof(u64), u64_less, NULL);
+    vec_sort_by_key(&b, sizeof(u64), NULL, NULL, num_threads,
+                    allocator_global, &error);
+    TEST_INT(error, 0);
+
+    bool same = true;
+    bool ascending = true;
+    u64 sum_a = 0;
+    u64 x_a = 0;
+    for (usize i = 0; i < count; ++i) {
+      same &= a.element[i] == b.element[i];
+      ascending &= !i || a.element[i - 1] <= a.element[i];
+      sum_a += a.element[i];
+      x_a ^= a.element[i];
+    }
+    TEST_INT(same, 1);
+    TEST_INT(ascending, 1);
+    TEST_INT(sum_a == sum && x_a == x, 1);
+
+    vec_deinit(&a, sizeof(u64), allocator_global);
+    vec_deinit(&b, sizeof(u64), allocator_global);
+  }
+}
+
+// radix sort of large elements by a key callback is stable
+static void test__stable(usize count, usize num_threads) {
+  Error error = 0;
+  EntryVec vec;
+  vec_init(&vec, sizeof(Entry), count, allocator_global, &error);
+  for (usize i = 0; i < count; ++i) {
+    Entry *entry = vec_more(&vec, sizeof(Entry), allocator_global, &error);
+    memset(entry, 0, sizeof(*entry));
+    entry->key = hash_u64(i) % (count / 8 + 1) << 40;
+    entry->position = i;
+    entry->padding[59] = (byte)i;
+  }
+  TEST_INT(error, 0);
+
+  vec_sort_by_key(&vec, sizeof(Entry), entry_key, NULL, num_threads,
+                  allocator_global, &error);
+  TEST_INT(error, 0);
+  bool stable = true;
+  for (usize i = 1; i < count; ++i) {
+    const Entry *prev = &vec.element[i - 1];
+    const Entry *entry = &vec.element[i];
+    stable &= prev->key < entry->key ||
+              (prev->key == entry->key && prev->position < entry->position);
+    stable &= entry->padding[59] == (byte)entry->position;
+  }
+  TEST_INT(stable, 1);
+
+  // comparison sort of the same elements in reverse
+  for (usize i = 0; i < count / 2; ++i) {
+    const Entry t = vec.element[i];
+    vec.element[i] = vec.element[count - 1 - i];
+    vec.element[count - 1 - i] = t;
+  }
+  vec_sort(&vec, sizeof(Entry), entry_less, NULL);
+  bool ascending = true;
+  for (usize i = 1; i < count; ++i) {
+    ascending &= vec.element[i - 1].key <= vec.element[i].key;
+    ascending &= vec.element[i].padding[59] == (byte)vec.element[i].position;
+  }
+  TEST_INT(ascending, 1);
+
+  vec_deinit(&vec, sizeof(Entry), allocator_global);
+}
+
+static void test__keys(void) {
+  Error error = 0;
+  const i64 signed_values[] = {5, -3, 0, INT64_MIN, INT64_MAX, -1, 1};
+  Vec(i64) s;
+  vec_init(&s, sizeof(i64), 1, allocator_global, &error);
+  vec_extend(&s, sizeof(i64), signed_values, 7, allocator_global, &error);
+  vec_sort_by_key(&s, sizeof(i64), i64_key, NULL, 1, allocator_global, &error);
+  TEST_INT(error, 0);
+  TEST_INT(s.element[0] == INT64_MIN, 1);
+  TEST_INT(s.element[1], -3);
+  TEST_INT(s.element[2], -1);
+  TEST_INT(s.element[3], 0);
+  TEST_INT(s.element[6] == INT64_MAX, 1);
+  vec_deinit(&s, sizeof(i64), allocator_global);
+
+  const double float_values[] = {2.5, -1.0, 0.0, -0.0, 1e300, -1e-300, 3.0};
+  Vec(double) f;
+  vec_init(&f, sizeof(double), 1, allocator_global, &error);
+  vec_extend(&f, sizeof(double), float_values, 7, allocator_global, &error);
+  vec_sort_by_key(&f, sizeof(double), f64_key, NULL, 1, allocator_global,
+                  &error);
+  TEST_INT(error, 0);
+  TEST_INT(f.element[0] == -1.0, 1);
+  TEST_INT(f.element[1] == -1e-300, 1);
+  TEST_INT(f.element[4] == 2.5, 1);
+  TEST_INT(f.element[6] == 1e300, 1);
+  vec_deinit(&f, sizeof(double), allocator_global);
+}
+
+int main(void) {
+  const usize counts[] = {0, 1, 2, 23, 24, 100, 129, 1000, 5000};
+  for (usize c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    test__u64(counts[c], 1);
+  }
+  test__u64(200000, 1);
+  test__u64(200000, 4);
+  test__stable(1000, 1);
+  test__stable(100000, 3);
+  test__keys();
+  TEST_OVERVIEW();
+  return 0;
+}